@@ -109,3 +109,7 @@ target_include_directories(bench_runtime PRIVATE ${CMAKE_SOURCE_DIR}/include)
 add_executable(ir_dump ${CMAKE_SOURCE_DIR}/tools/ir_dump.cpp)
 target_link_libraries(ir_dump PRIVATE pycc_core)
 target_include_directories(ir_dump PRIVATE ${CMAKE_SOURCE_DIR}/include)
+
+# Runtime trace (PYCC_RT_TRACE) to Chrome trace JSON converter
+add_executable(trace_to_chrome ${CMAKE_SOURCE_DIR}/tools/trace_to_chrome.cpp)
+target_include_directories(trace_to_chrome PRIVATE ${CMAKE_SOURCE_DIR}/include)
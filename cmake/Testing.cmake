@@ -102,6 +102,28 @@ if(BUILD_TESTING)
       RuntimeIOFailures.*:
       RuntimeOSFS.*:
       RuntimeGlob.*:
+      RuntimeHeapIndex.*:
+      RuntimeNursery.*:
+      RuntimeMarkStack.*:
+      RuntimeTLAB.*:
+      RuntimeShadowStack.*:
+      RuntimeIncrementalMark.*:
+      RuntimeStoreBuffer.*:
+      RuntimeGcTimings.*:
+      RuntimeGcPacer.*:
+      RuntimeScavenger.*:
+      RuntimeCompactHeader.*:
+      RuntimeThreadHeap.*:
+      RuntimeSafepoint.*:
+      RuntimeCompaction.*:
+      RuntimeArena.*:
+      RuntimeHeapProfile.*:
+      RuntimeTrace.*:
+      RuntimeDictHash.*:
+      RuntimeDictOrder.*:
+      RuntimeSet.*:
+      RuntimeStringIntern.*:
+      RuntimeStaticString.*:
       RuntimeFnmatch.*:
       RuntimeSubprocess.*:
       RuntimeTempfile.*)
@@ -9,5 +9,7 @@
 #include "runtime/TypeTag.h"
 #include "runtime/GCStats.h"
 #include "runtime/GC.h"
+#include "runtime/Trace.h"
+#include "runtime/StaticString.h"
 #include "runtime/Runtime.h" // transitional; will be removed once fully split
 
@@ -8,14 +8,67 @@
 #include "runtime/GCStats.h"
 
 namespace pycc::rt {
+    // Pin the major-collection trigger at a fixed number of old-space bytes (disables pacing).
     void gc_set_threshold(std::size_t bytes);
 
+    // Heap pacing: after each major collection the next trigger is derived from the live bytes
+    // and either an absolute heap target (bytes; 0 = use the growth percentage) or a growth
+    // percentage over live bytes (default 100, negative = off). Both resume pacing after
+    // gc_set_threshold; PYCC_GC_HEAP_TARGET and PYCC_GC_PERCENT set them from the environment.
+    void gc_set_heap_target(std::size_t bytes);
+
+    void gc_set_heap_growth(int percent);
+
+    // Collections stop the other threads at safepoints before reading their roots: loop
+    // headers of compiled code, entry into the runtime, and blocking runtime calls (channels,
+    // joins, sleeps). Precise mode only waits for threads with compiled frames; conservative
+    // mode also scans the stacks of all allocating threads, so native loops that hold heap
+    // objects and never enter the runtime have to call gc_safepoint themselves.
     void gc_set_conservative(bool enabled);
 
+    // Park here if a collector is waiting to scan this thread's stack.
+    void gc_safepoint();
+
+    // Mostly-copying compaction: once a sweep finds more than this percentage of the bytes in
+    // partly used small-object spans free, the next major collection evacuates sparse spans.
+    // Needs conservative mode; spans a stack points into are pinned. Negative = off (default);
+    // PYCC_GC_COMPACT sets it from the environment.
+    void gc_set_compaction(int fragmentationPercent);
+
+    // Heap profiler: sample about one allocation per meanBytes allocated and record its native
+    // stack (0 = off, the default). Other threads pick the change up within 1 MiB of allocation.
+    // PYCC_HEAP_PROFILE=<path> turns it on from startup, with PYCC_HEAP_PROFILE_RATE as the
+    // mean, and writes the profile to that path at exit.
+    void gc_set_heap_profile_rate(std::size_t meanBytes);
+
+    // Write the sampled heap profile, in pprof's legacy heap_v2 text format, to path (nullptr:
+    // the PYCC_HEAP_PROFILE path). Returns false when there is no path or the write fails.
+    bool gc_heap_profile_dump(const char* path);
+
+    // Request transparent huge pages (MADV_HUGEPAGE) for heap arenas reserved from now on
+    // (default on; PYCC_GC_HUGE_PAGES=0 turns it off from the environment).
+    void gc_set_huge_pages(bool enabled);
+
     void gc_set_background(bool enabled);
 
+    // On a thread started by rt_spawn, collects only that thread's private heap.
     void gc_collect();
 
+    // Number of threads that drain the mark stack during a collection (1 = serial,
+    // 0 = one per hardware thread). Helpers only start when there is enough gray work.
+    void gc_set_mark_threads(unsigned threads);
+
+    // Young-generation collection only: marks through roots and the remembered set,
+    // promotes nursery survivors in place and recycles emptied nursery chunks.
+    void gc_collect_minor();
+
+    // Nursery budget in bytes (rounded to 64 KiB chunks); 0 disables the nursery.
+    void gc_set_nursery_size(std::size_t bytes);
+
+    // Return idle heap pages (free small-object pages, unused nursery chunks) to the OS now;
+    // returns the bytes released. The collector also does this on its own when pressure is low.
+    std::size_t gc_scavenge();
+
     void gc_register_root(void **addr);
 
     void gc_unregister_root(void **addr);
@@ -24,7 +77,9 @@ namespace pycc::rt {
 
     GcTelemetry gc_telemetry();
 
-    // Barrier mode (0 = incremental-update, 1 = SATB)
+    // Barrier mode for background incremental marking (0 = incremental-update: stored values
+    // are logged; 1 = SATB: overwritten values are logged). Mark slices last at most the
+    // adaptive slice budget.
     void gc_set_barrier_mode(int mode);
 
     void gc_pre_barrier(void **slot);
@@ -1,5 +1,5 @@
 /***
- * Name: pycc::rt::RuntimeStats, GcTelemetry
+ * Name: pycc::rt::RuntimeStats, GcPauseSummary, GcTelemetry
  * Purpose: Expose GC counters and telemetry to tests and tooling.
  */
 #pragma once
@@ -10,15 +10,41 @@ namespace pycc::rt {
     struct RuntimeStats {
         uint64_t numAllocated{0};
         uint64_t numFreed{0};
-        uint64_t numCollections{0};
+        uint64_t numCollections{0}; // minor + major
+        uint64_t numMinorCollections{0};
+        uint64_t numMajorCollections{0};
         uint64_t bytesAllocated{0};
         uint64_t bytesLive{0};
         uint64_t peakBytesLive{0};
         uint64_t lastReclaimedBytes{0};
+        uint64_t bytesReleased{0}; // idle heap pages handed back to the OS by the scavenger
+        uint64_t numLocalCollections{0}; // collections of rt_spawn threads' private heaps
+        uint64_t numPublished{0}; // heap objects copied into the shared message heap by chan_send
+        uint64_t fragmentedBytes{0}; // free bytes in partly used small-object spans after the last sweep
+        uint64_t numCompactions{0};
+        uint64_t bytesEvacuated{0}; // objects moved out of sparse spans by compaction
+        uint64_t numPinnedSpans{0}; // spans compaction left in place for stack references
+        uint64_t arenaBytes{0}; // address space held in 2 MiB heap arenas (currently mapped)
+        uint64_t hugePageBytes{0}; // arena bytes the kernel was asked to back with huge pages
+    };
+
+    // Percentiles over every recorded duration since start (or gc_reset_for_tests), in ns.
+    // Percentiles are bucket upper bounds (within 12.5%), never above maxNs.
+    struct GcPauseSummary {
+        uint64_t count{0};
+        uint64_t p50Ns{0};
+        uint64_t p90Ns{0};
+        uint64_t p99Ns{0};
+        uint64_t maxNs{0};
     };
 
     struct GcTelemetry {
         double allocRateBytesPerSec{0.0}; // recent bytes/sec
         double pressure{0.0}; // bytesLive / threshold (0..inf)
+        GcPauseSummary pause; // each stop-the-world section, including a background cycle's mark slices
+        GcPauseSummary mark; // marking time per completed collection (summed over slices)
+        GcPauseSummary sweep; // sweeping time per completed collection (summed over batches)
+        uint64_t triggerBytes{0}; // old-space bytes that start the next major cycle
+        uint64_t heapGoalBytes{0}; // heap size the pacer aims to finish that cycle at
     };
 } // namespace pycc::rt
@@ -24,6 +24,10 @@ namespace pycc::rt {
 
     void *string_from_cstr(const char *cstr);
 
+    // The one interned string with this content, created on first request. Interned strings
+    // are never collected, so equal ones compare (and hit dict lookups) by pointer.
+    void *string_intern(const char *data, std::size_t len);
+
     void *string_concat(void *a, void *b);
 
     // Slice uses Unicode code points (start, length)
@@ -85,7 +89,8 @@ namespace pycc::rt {
     // Append bytes content to bytearray up to capacity (no reallocation in this subset)
     void bytearray_extend_from_bytes(void *obj, void *bytes);
 
-    // Boxed primitives (opaque heap objects with value payloads)
+    // Boxed primitives. Ints that fit in 63 bits and bools are immediates encoded in the
+    // pointer (no allocation); floats and wider ints are heap objects with value payloads.
     void *box_int(int64_t value);
 
     int64_t box_int_value(void *obj);
@@ -98,6 +103,9 @@ namespace pycc::rt {
 
     bool box_bool_value(void *obj);
 
+    // True for immediate values, which have no heap object or header
+    bool is_immediate(const void *value);
+
     // List operations (opaque list of ptr values)
     void *list_new(std::size_t capacity);
 
@@ -118,11 +126,33 @@ namespace pycc::rt {
 
     std::size_t dict_len(void *dict);
 
-    // Dict iteration (iterator object with [0]=dict, [1]=index)
+    // Dict iteration in insertion order (iterator object with [0]=dict, [1]=position, [2]=version)
     void *dict_iter_new(void *dict);
 
     void *dict_iter_next(void *it); // returns next key or nullptr when done
 
+    // Set operations (hash set; elements hashed and compared like dict keys)
+    void *set_new(std::size_t capacity);
+
+    void set_add(void **set_slot, void *elem);
+
+    bool set_discard(void *set, void *elem); // true if elem was present
+
+    bool set_contains(void *set, void *elem);
+
+    std::size_t set_len(void *set);
+
+    void *set_union(void *a, void *b);
+
+    void *set_intersection(void *a, void *b);
+
+    void *set_difference(void *a, void *b);
+
+    // Set iteration in insertion order (iterator object with [0]=set, [1]=position, [2]=version)
+    void *set_iter_new(void *set);
+
+    void *set_iter_next(void *it); // returns next element or nullptr when done
+
     // Object operations (fixed-size field table of ptr values)
     void *object_new(std::size_t field_count);
 
@@ -618,7 +648,8 @@ namespace pycc::rt {
     struct RtChannelHandle; // opaque
     struct RtAtomicIntHandle; // opaque
 
-    // Threads
+    // Threads. Each spawned thread allocates from a private heap that it collects itself
+    // and that is released when the entry function returns.
     RtThreadHandle *rt_spawn(RtStart fn, const void *payload, std::size_t len);
 
     bool rt_join(RtThreadHandle *h, void **ret, std::size_t *ret_len);
@@ -630,6 +661,8 @@ namespace pycc::rt {
 
     void chan_close(RtChannelHandle *ch);
 
+    // Payloads are copied into a shared message heap on send; recv hands back a copy
+    // allocated in the receiving thread's heap.
     void chan_send(RtChannelHandle *ch, void *value);
 
     void *chan_recv(RtChannelHandle *ch);
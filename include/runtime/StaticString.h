@@ -0,0 +1,54 @@
+/***
+ * Name: pycc::rt::StaticStringObject, string_content_hash
+ * Purpose: Layout of the immortal string objects compiled code emits for its string constants,
+ *          and the content hash strings cache, which the compiler precomputes for them.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include "runtime/TypeTag.h"
+
+namespace pycc::rt {
+    // Header flag of objects outside the collected heap (string constants in read-only data,
+    // interned strings): never freed, scanned, moved or written to.
+    constexpr uint8_t kFlagImmortal = 8U;
+
+    // Content hash cached in every string object; never 0, which marks a hash not computed yet.
+    // FNV-1a with a final avalanche, so the compiler and the runtime agree on it.
+    constexpr std::size_t string_content_hash(std::string_view text) {
+        uint64_t hash = 1469598103934665603ULL;
+        for (const char ch: text) {
+            hash ^= static_cast<unsigned char>(ch);
+            hash *= 1099511628211ULL;
+        }
+        hash ^= hash >> 33U; hash *= 0xff51afd7ed558ccdULL; hash ^= hash >> 33U;
+        return (hash == 0U) ? 1U : static_cast<std::size_t>(hash);
+    }
+
+    // Object header, then the string payload (length, hash, bytes and a NUL). Strings are
+    // handled by the address of len, one word into a 16-byte granule like heap objects.
+    template <std::size_t N>
+    struct alignas(16) StaticStringObject {
+        uint8_t tag{static_cast<uint8_t>(TypeTag::String)};
+        uint8_t gen{1};
+        uint8_t age{0};
+        uint8_t flags{kFlagImmortal};
+        uint32_t size{static_cast<uint32_t>(8U + (2U * sizeof(std::size_t)) + N)};
+        std::size_t len{N - 1U};
+        std::size_t hash{0};
+        char data[N]{}; // NOLINT(cppcoreguidelines-avoid-c-arrays)
+
+        void* value() const { return const_cast<std::size_t*>(&len); } // NOLINT(cppcoreguidelines-pro-type-const-cast)
+    };
+
+    // Build a constant string object from a literal: static const auto s = make_static_string("key");
+    template <std::size_t N>
+    constexpr StaticStringObject<N> make_static_string(const char (&text)[N]) { // NOLINT(cppcoreguidelines-avoid-c-arrays)
+        StaticStringObject<N> obj;
+        for (std::size_t i = 0; i < N; ++i) { obj.data[i] = text[i]; } // NOLINT(cppcoreguidelines-pro-bounds-constant-array-index)
+        obj.hash = string_content_hash(std::string_view(text, N - 1U));
+        return obj;
+    }
+} // namespace pycc::rt
@@ -0,0 +1,75 @@
+/***
+ * Name: pycc::rt::TraceEvent, TraceKind, tracing controls
+ * Purpose: Record runtime events (GC phases, barrier buffer flushes, channel blocking, thread
+ *          spawn/join) into per-thread ring buffers and write them out as a compact trace file.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace pycc::rt {
+    enum class TraceKind : uint8_t {
+        GcMinor = 1,     // a minor collection
+        GcMajor,         // a synchronous major collection or a background major cycle
+        GcMark,          // marking (one slice of a background cycle)
+        GcSweep,         // sweeping (one batch of a background cycle)
+        GcCompact,       // evacuating sparse spans
+        GcStop,          // stopping the mutators at safepoints
+        SafepointPark,   // a mutator parked for a collector or in a blocking call
+        BarrierFlush,    // arg: barrier records handed to the collector
+        ChanSendBlocked, // waiting for room in a full channel
+        ChanRecvBlocked, // waiting for a message on an empty channel
+        ThreadSpawn,     // rt_spawn started a thread
+        ThreadRun,       // an rt_spawn thread's entry function
+        ThreadJoin,      // waiting in rt_join
+    };
+
+    enum class TracePhase : uint8_t { Begin = 'B', End = 'E', Instant = 'i' };
+
+    // One record of the trace file.
+    struct TraceEvent {
+        uint64_t timeNs{0}; // steady clock
+        uint32_t arg{0};    // kind-specific, see TraceKind
+        uint16_t thread{0}; // trace thread number, from 1 in order of each thread's first event
+        TraceKind kind{};
+        TracePhase phase{};
+    };
+    static_assert(sizeof(TraceEvent) == 16U, "trace records are written as-is");
+
+    // Trace file: this header, then `count` TraceEvents in time order (host byte order).
+    struct TraceFileHeader {
+        char magic[8]{'P', 'Y', 'C', 'C', 'T', 'R', 'C', '1'}; // NOLINT(cppcoreguidelines-avoid-c-arrays)
+        uint32_t eventSize{sizeof(TraceEvent)};
+        uint32_t reserved{0};
+        uint64_t count{0};
+    };
+
+    inline const char* trace_kind_name(TraceKind kind) {
+        switch (kind) {
+            case TraceKind::GcMinor: return "gc.minor";
+            case TraceKind::GcMajor: return "gc.major";
+            case TraceKind::GcMark: return "gc.mark";
+            case TraceKind::GcSweep: return "gc.sweep";
+            case TraceKind::GcCompact: return "gc.compact";
+            case TraceKind::GcStop: return "gc.stop_mutators";
+            case TraceKind::SafepointPark: return "safepoint.park";
+            case TraceKind::BarrierFlush: return "barrier.flush";
+            case TraceKind::ChanSendBlocked: return "chan.send_blocked";
+            case TraceKind::ChanRecvBlocked: return "chan.recv_blocked";
+            case TraceKind::ThreadSpawn: return "thread.spawn";
+            case TraceKind::ThreadRun: return "thread.run";
+            case TraceKind::ThreadJoin: return "thread.join";
+        }
+        return "unknown";
+    }
+
+    // Start or stop recording. Each thread records into a ring buffer of its own without
+    // locks; once full, its oldest events are overwritten. PYCC_RT_TRACE=<path> starts
+    // recording at startup and writes the trace to that path at exit.
+    void trace_set_enabled(bool enabled);
+
+    // Write every buffered event to path (nullptr: the PYCC_RT_TRACE path) and clear the
+    // buffers. Returns false when there is no path or the write fails.
+    bool trace_flush(const char* path);
+} // namespace pycc::rt
@@ -16,6 +16,7 @@ namespace pycc::rt {
         Object = 6,
         Dict = 7,
         Bytes = 8,
-        ByteArray = 9
+        ByteArray = 9,
+        Set = 10
     };
 } // namespace pycc::rt
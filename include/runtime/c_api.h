@@ -12,10 +12,57 @@ extern "C" {
 // GC controls
 void pycc_gc_collect(void);
 void pycc_gc_set_threshold(size_t bytes);
+void pycc_gc_set_heap_target(size_t bytes);
+void pycc_gc_set_heap_growth(int percent);
+size_t pycc_gc_scavenge(void);
+// Write the sampled heap profile (NULL: the PYCC_HEAP_PROFILE path); 1 on success.
+int pycc_gc_heap_profile_dump(const char* path);
 void pycc_gc_set_background(int enabled);
 void pycc_gc_set_conservative(int enabled);
 void pycc_gc_write_barrier(void** slot, void* value);
 
+// GC timing percentiles in nanoseconds (see pycc::rt::GcTelemetry)
+struct pycc_gc_pause_summary {
+  uint64_t count;
+  uint64_t p50_ns;
+  uint64_t p90_ns;
+  uint64_t p99_ns;
+  uint64_t max_ns;
+};
+struct pycc_gc_timings {
+  struct pycc_gc_pause_summary pause; // stop-the-world sections
+  struct pycc_gc_pause_summary mark;  // marking per collection
+  struct pycc_gc_pause_summary sweep; // sweeping per collection
+};
+void pycc_gc_get_timings(struct pycc_gc_timings* out);
+
+// LLVM shadow-stack frames (functions marked gc "shadow-stack"): every active call links one
+// entry into its thread's llvm_gc_root_chain; the collector walks the chains of stopped
+// threads for precise stack roots.
+struct pycc_gc_frame_map {
+  int32_t num_roots; // includes roots with metadata
+  int32_t num_meta;
+  /* const void* meta[num_meta] follows */
+};
+struct pycc_gc_stack_entry {
+  struct pycc_gc_stack_entry* next; // caller's frame
+  const struct pycc_gc_frame_map* map;
+  /* void* roots[map->num_roots] follows */
+};
+#ifdef __cplusplus
+extern thread_local struct pycc_gc_stack_entry* llvm_gc_root_chain;
+#else
+extern _Thread_local struct pycc_gc_stack_entry* llvm_gc_root_chain;
+#endif
+// Nonzero while an incremental mark is in progress. Compiled code stores only into shadow-stack
+// slots, which collectors walk with the owning thread stopped (stop-the-world collections and
+// the final remark), so it loads this byte and calls pycc_gc_write_barrier only when it is set.
+extern uint8_t pycc_gc_marking;
+// Nonzero while a collector waits to scan mutator stacks; compiled loops test it at their
+// headers and call pycc_gc_safepoint to park.
+extern uint8_t pycc_gc_safepoint_requested;
+void pycc_gc_safepoint(void);
+
 // Boxing
 void* pycc_box_int(int64_t v);
 void* pycc_box_float(double v);
@@ -23,6 +70,7 @@ void* pycc_box_bool(bool v);
 
 // Strings
 void* pycc_string_new(const char* data, size_t len);
+void* pycc_string_intern(const char* data, size_t len);
 size_t pycc_string_len(void* s);
 void* pycc_string_concat(void* a, void* b);
 void* pycc_string_slice(void* s, int64_t start, int64_t len);
@@ -49,6 +97,18 @@ uint64_t pycc_dict_len(void* dict);
 void* pycc_dict_iter_new(void* dict);
 void* pycc_dict_iter_next(void* it);
 
+// Sets
+void* pycc_set_new(uint64_t cap);
+void pycc_set_add(void** set_slot, void* elem);
+bool pycc_set_discard(void* set, void* elem);
+bool pycc_set_contains(void* set, void* elem);
+uint64_t pycc_set_len(void* set);
+void* pycc_set_union(void* a, void* b);
+void* pycc_set_intersection(void* a, void* b);
+void* pycc_set_difference(void* a, void* b);
+void* pycc_set_iter_new(void* set);
+void* pycc_set_iter_next(void* it);
+
 // Object attribute interop (dictionary-backed per-instance attributes)
 void pycc_object_set_attr(void* obj, void* key_string, void* value);
 void* pycc_object_get_attr(void* obj, void* key_string);
@@ -11,5 +11,9 @@ namespace pycc::rt {
 // Expose object type tag for internal helpers.
 TypeTag type_of_public(void* obj);
 
+// A dict's dense entries in insertion order: count keys and their values.
+struct DictEntries { void* const* keys{nullptr}; void* const* values{nullptr}; std::size_t count{0}; };
+DictEntries dict_entries_public(void* dict);
+
 }
 
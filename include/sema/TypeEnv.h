@@ -56,6 +56,11 @@ namespace pycc::sema {
 
         uint32_t getListElems(const std::string &name) const;
 
+        // Set element masks (sets are typed as List, but are not indexable)
+        void defineSetElems(const std::string &name, uint32_t elemMask);
+
+        uint32_t getSetElems(const std::string &name) const;
+
         // Tuple element masks by index (heterogeneous). Unknown index uses unionOfTupleElems(name).
         void defineTupleElems(const std::string &name, std::vector<uint32_t> elemMasks);
 
@@ -110,6 +115,7 @@ namespace pycc::sema {
         std::unordered_map<std::string, bool> nonNone_;
         std::unordered_map<std::string, uint32_t> sets_;
         std::unordered_map<std::string, uint32_t> listElemSets_;
+        std::unordered_map<std::string, uint32_t> setElemSets_;
         std::unordered_map<std::string, std::vector<uint32_t> > tupleElemSets_;
         std::unordered_map<std::string, uint32_t> dictKeySets_;
         std::unordered_map<std::string, uint32_t> dictValSets_;
@@ -38,7 +38,16 @@ bool handleSetComp(const ast::SetComp& sc,
                    const std::unordered_map<std::string, ClassInfo>* classes,
                    ast::TypeKind& out,
                    uint32_t& outSet,
-                   bool& ok);
+                   bool& ok,
+                   uint32_t* eltMask = nullptr); // receives the element kinds when non-null
+
+// Element kinds of a set literal or set comprehension (sets are typed as List); 0 when unknown.
+uint32_t setElementMask(const ast::Expr& set,
+                        const TypeEnv& env,
+                        const std::unordered_map<std::string, Sig>& sigs,
+                        const std::unordered_map<std::string, int>& retParamIdxs,
+                        std::vector<Diagnostic>& diags,
+                        const std::unordered_map<std::string, ClassInfo>* classes);
 
 bool handleDictComp(const ast::DictComp& dc,
                     const TypeEnv& env,
@@ -15,6 +15,8 @@ struct IntersectOps {
     static void setsAndTypes(TypeEnv& dst, const TypeEnv& a, const TypeEnv& b);
     // Intersect list element sets for names present in both
     static void listElems(TypeEnv& dst, const TypeEnv& a, const TypeEnv& b);
+    // Intersect set element sets for names present in both
+    static void setElems(TypeEnv& dst, const TypeEnv& a, const TypeEnv& b);
     // Intersect tuple element sets index-wise for names present in both
     static void tupleElems(TypeEnv& dst, const TypeEnv& a, const TypeEnv& b);
     // Intersect dict key/value sets for names present in both
@@ -24,6 +24,8 @@
 #include "ast/Subscript.h"
 #include "ast/IntLiteral.h"
 #include "ast/ListLiteral.h"
+#include "ast/SetLiteral.h"
+#include "ast/Comprehension.h"
 #include "ast/Module.h"
 #include "ast/Name.h"
 #include "ast/NodeKind.h"
@@ -36,6 +38,7 @@
 #include "ast/TypeKind.h"
 #include "ast/Unary.h"
 #include "ast/VisitorBase.h"
+#include "runtime/StaticString.h"
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
@@ -44,6 +47,7 @@
 #include <filesystem>
 #include <fstream>
 #include <functional>
+#include <optional>
 #include <ios>
 #include <sstream>
 #include <stdexcept>
@@ -67,6 +71,251 @@ namespace pycc::codegen {
         return base.substr(0, posDot) + ext;
     }
 
+    // Immortal string object (runtime/StaticString.h) holding the bytes of the constant
+    // @.str_<hash> global; the string value is its address plus the 8-byte object header.
+    static std::string staticStrObject(const std::string &strGlobal) {
+        return ".sobj_" + strGlobal.substr(std::string(".str_").size());
+    }
+
+    // Give calls the statement emitters left unlocated the location of the next located
+    // instruction in the function (the statement they compute a value for), else the last
+    // one, else the function's. The verifier rejects debug info with unlocated calls to defined
+    // functions or dbg.declare, and located calls let heap profiles and backtraces of compiled
+    // programs resolve every call site to a source line.
+    static std::string locateCalls(const std::string &fn, int fallbackLocId) {
+        std::vector<std::string> lines;
+        std::istringstream in(fn);
+        for (std::string line; std::getline(in, line);) { lines.push_back(std::move(line)); }
+        const auto locOf = [](const std::string &line) {
+            const auto pos = line.starts_with("define ") ? std::string::npos : line.find("!dbg !");
+            return pos == std::string::npos ? 0 : std::atoi(line.c_str() + pos + 6);
+        };
+        const auto isCall = [](const std::string &line) {
+            const auto first = line.find_first_not_of(' ');
+            if (first == std::string::npos || first == 0) { return false; }
+            const std::string_view inst = std::string_view(line).substr(first);
+            const auto eq = inst.starts_with("%") ? inst.find(" = ") : std::string_view::npos;
+            const std::string_view op = eq == std::string_view::npos ? inst : inst.substr(eq + 3);
+            return op.starts_with("call ") || op.starts_with("tail call ") || op.starts_with("invoke ");
+        };
+        std::vector<int> nextLoc(lines.size() + 1, 0);
+        for (std::size_t i = lines.size(); i > 0; --i) {
+            const int loc = locOf(lines[i - 1]);
+            nextLoc[i - 1] = loc > 0 ? loc : nextLoc[i];
+        }
+        std::ostringstream out;
+        int prevLoc = 0;
+        for (std::size_t i = 0; i < lines.size(); ++i) {
+            std::string &line = lines[i];
+            const int loc = locOf(line);
+            if (loc > 0) {
+                prevLoc = loc;
+            } else if (isCall(line)) {
+                const int use = nextLoc[i] > 0 ? nextLoc[i] : (prevLoc > 0 ? prevLoc : fallbackLocId);
+                if (use > 0) {
+                    const auto comment = line.find(" ; ");
+                    line.insert(comment == std::string::npos ? line.size() : comment, ", !dbg !" + std::to_string(use));
+                }
+            }
+            out << line << '\n';
+        }
+        return out.str();
+    }
+
+    // Escape analysis for list literals bound to function locals. A local qualifies for stack storage when
+    // its only binding is a single `name = [...]` of at most kMaxLen elements and every other occurrence
+    // reads it through `name[i]`, `len(name)` or `for v in name`; such a list never leaves the frame.
+    // Constructs the scan does not model (closures, try, del, comprehensions, ...) disqualify the function.
+    // Only lists are candidates: a local float already lives unboxed in an `alloca double` and is boxed
+    // only on its way into a container or runtime call, and object literals are read back through
+    // obj_get/attribute helpers that need the runtime object itself.
+    struct StackListScan {
+        static constexpr std::size_t kMaxLen = 8;
+        std::unordered_map<std::string, std::size_t> bound; // name -> literal length (first binding)
+        std::unordered_map<std::string, int> bindings;
+        std::unordered_set<std::string> escaped;
+        bool opaque{false};
+
+        static std::unordered_map<std::string, std::size_t> run(const ast::FunctionDef &fn) {
+            StackListScan scan;
+            scan.stmts(fn.body);
+            std::unordered_map<std::string, std::size_t> out;
+            if (scan.opaque) { return out; }
+            for (const auto &[name, len]: scan.bound) {
+                if (scan.bindings[name] == 1 && !scan.escaped.contains(name)) { out.emplace(name, len); }
+            }
+            for (const auto &param: fn.params) { out.erase(param.name); }
+            return out;
+        }
+
+        // break/continue in an unrolled loop body would have no loop to target
+        static bool hasLoopJump(const std::vector<std::unique_ptr<ast::Stmt> > &body) {
+            for (const auto &st: body) {
+                if (!st) { continue; }
+                if (st->kind == ast::NodeKind::BreakStmt || st->kind == ast::NodeKind::ContinueStmt) { return true; }
+                if (st->kind == ast::NodeKind::IfStmt) {
+                    const auto *iff = static_cast<const ast::IfStmt *>(st.get());
+                    if (hasLoopJump(iff->thenBody) || hasLoopJump(iff->elseBody)) { return true; }
+                }
+            }
+            return false;
+        }
+
+        void stmts(const std::vector<std::unique_ptr<ast::Stmt> > &body) {
+            for (const auto &st: body) { stmt(st.get()); }
+        }
+
+        void target(const ast::Expr *t) {
+            if (t == nullptr) { return; }
+            if (t->kind == ast::NodeKind::Name) {
+                escaped.insert(static_cast<const ast::Name *>(t)->id);
+            } else if (t->kind == ast::NodeKind::Subscript) {
+                const auto *sub = static_cast<const ast::Subscript *>(t);
+                if (sub->value && sub->value->kind == ast::NodeKind::Name) {
+                    escaped.insert(static_cast<const ast::Name *>(sub->value.get())->id); // element stores
+                } else { expr(sub->value.get()); }
+                expr(sub->slice.get());
+            } else { expr(t); }
+        }
+
+        void stmt(const ast::Stmt *s) { // NOLINT(readability-function-cognitive-complexity)
+            using NK = ast::NodeKind;
+            if (s == nullptr) { return; }
+            switch (s->kind) {
+                case NK::AssignStmt: {
+                    const auto *asg = static_cast<const ast::AssignStmt *>(s);
+                    std::string name = asg->target;
+                    if (name.empty() && asg->targets.size() == 1 && asg->targets[0] &&
+                        asg->targets[0]->kind == NK::Name) {
+                        name = static_cast<const ast::Name *>(asg->targets[0].get())->id;
+                    }
+                    if (!name.empty() && asg->targets.size() <= 1 && asg->value &&
+                        asg->value->kind == NK::ListLiteral) {
+                        const auto *lst = static_cast<const ast::ListLiteral *>(asg->value.get());
+                        if (lst->elements.size() <= kMaxLen) {
+                            bound.emplace(name, lst->elements.size());
+                            ++bindings[name];
+                        } else { escaped.insert(name); }
+                    } else {
+                        if (!name.empty()) { escaped.insert(name); }
+                        for (const auto &t: asg->targets) { target(t.get()); }
+                    }
+                    expr(asg->value.get());
+                    return;
+                }
+                case NK::AugAssignStmt: {
+                    const auto *aug = static_cast<const ast::AugAssignStmt *>(s);
+                    target(aug->target.get());
+                    expr(aug->value.get());
+                    return;
+                }
+                case NK::ExprStmt: expr(static_cast<const ast::ExprStmt *>(s)->value.get());
+                    return;
+                case NK::ReturnStmt: expr(static_cast<const ast::ReturnStmt *>(s)->value.get());
+                    return;
+                case NK::IfStmt: {
+                    const auto *iff = static_cast<const ast::IfStmt *>(s);
+                    expr(iff->cond.get());
+                    stmts(iff->thenBody);
+                    stmts(iff->elseBody);
+                    return;
+                }
+                case NK::WhileStmt: {
+                    const auto *ws = static_cast<const ast::WhileStmt *>(s);
+                    expr(ws->cond.get());
+                    stmts(ws->thenBody);
+                    stmts(ws->elseBody);
+                    return;
+                }
+                case NK::ForStmt: {
+                    const auto *fs = static_cast<const ast::ForStmt *>(s);
+                    target(fs->target.get());
+                    if (fs->iterable && fs->iterable->kind == NK::Name) {
+                        if (hasLoopJump(fs->thenBody)) {
+                            escaped.insert(static_cast<const ast::Name *>(fs->iterable.get())->id);
+                        }
+                    } else { expr(fs->iterable.get()); }
+                    stmts(fs->thenBody);
+                    stmts(fs->elseBody);
+                    return;
+                }
+                case NK::BreakStmt:
+                case NK::ContinueStmt:
+                case NK::PassStmt:
+                    return;
+                default:
+                    opaque = true;
+                    return;
+            }
+        }
+
+        void expr(const ast::Expr *e) { // NOLINT(readability-function-cognitive-complexity)
+            using NK = ast::NodeKind;
+            if (e == nullptr) { return; }
+            switch (e->kind) {
+                case NK::IntLiteral:
+                case NK::BoolLiteral:
+                case NK::FloatLiteral:
+                case NK::StringLiteral:
+                case NK::BytesLiteral:
+                case NK::NoneLiteral:
+                    return;
+                case NK::Name: escaped.insert(static_cast<const ast::Name *>(e)->id);
+                    return;
+                case NK::Subscript: {
+                    const auto *sub = static_cast<const ast::Subscript *>(e);
+                    if (!sub->value || sub->value->kind != NK::Name) { expr(sub->value.get()); }
+                    expr(sub->slice.get());
+                    return;
+                }
+                case NK::Call: {
+                    const auto *call = static_cast<const ast::Call *>(e);
+                    const bool isLen = call->callee && call->callee->kind == NK::Name &&
+                                       static_cast<const ast::Name *>(call->callee.get())->id == "len" &&
+                                       call->args.size() == 1 && call->args[0] &&
+                                       call->args[0]->kind == NK::Name && call->keywords.empty() &&
+                                       call->starArgs.empty() && call->kwStarArgs.empty();
+                    if (isLen) { return; }
+                    expr(call->callee.get());
+                    for (const auto &a: call->args) { expr(a.get()); }
+                    for (const auto &kw: call->keywords) { expr(kw.value.get()); }
+                    for (const auto &a: call->starArgs) { expr(a.get()); }
+                    for (const auto &a: call->kwStarArgs) { expr(a.get()); }
+                    return;
+                }
+                case NK::BinaryExpr: {
+                    const auto *bin = static_cast<const ast::Binary *>(e);
+                    expr(bin->lhs.get());
+                    expr(bin->rhs.get());
+                    return;
+                }
+                case NK::UnaryExpr: expr(static_cast<const ast::Unary *>(e)->operand.get());
+                    return;
+                case NK::Attribute: expr(static_cast<const ast::Attribute *>(e)->value.get());
+                    return;
+                case NK::IfExpr: {
+                    const auto *ie = static_cast<const ast::IfExpr *>(e);
+                    expr(ie->test.get());
+                    expr(ie->body.get());
+                    expr(ie->orelse.get());
+                    return;
+                }
+                case NK::TupleLiteral:
+                    for (const auto &el: static_cast<const ast::TupleLiteral *>(e)->elements) { expr(el.get()); }
+                    return;
+                case NK::ListLiteral:
+                    for (const auto &el: static_cast<const ast::ListLiteral *>(e)->elements) { expr(el.get()); }
+                    return;
+                case NK::ObjectLiteral:
+                    for (const auto &fld: static_cast<const ast::ObjectLiteral *>(e)->fields) { expr(fld.get()); }
+                    return;
+                default:
+                    opaque = true;
+                    return;
+            }
+        }
+    };
+
     // NOLINTNEXTLINE(readability-function-cognitive-complexity)
     std::string Codegen::emit(const ast::Module &mod,
                               const std::string &outBase,
@@ -238,6 +487,7 @@ namespace pycc::codegen {
         const int diDoubleId = nextDbgId++;
         const int diPtrId = nextDbgId++;
         const int diExprId = nextDbgId++;
+        const int diSubTyId = nextDbgId++;
         struct DbgVar {
             int id;
             std::string name;
@@ -249,8 +499,56 @@ namespace pycc::codegen {
             bool isParam;
         };
         std::vector<DbgVar> dbgVars;
-        // GC barrier declaration for pointer writes (C ABI)
+        // Every thread links its shadow-stack frames into its own chain: the shadow-stack
+        // lowering turns this declaration into a linkonce copy of the runtime's thread_local.
+        irStream << "@llvm_gc_root_chain = external thread_local global ptr\n";
+        // GC barrier declaration for pointer writes (C ABI), and the inline fast path every
+        // pointer store goes through. All of them target shadow-stack root slots, and the
+        // collector walks a thread's slots only with the thread stopped at a safepoint, in
+        // stop-the-world collections and in the remark that ends an incremental mark. A store
+        // lands before such a walk, which sees it, or after it, and then stores a pointer
+        // that was in a walked slot or came from the runtime once the collection was over.
+        // So the runtime only needs to hear about stores while an incremental mark is running
+        // (pycc_gc_marking set), whose slices let mutators run in between, and never about
+        // immediate ints and bools, which carry a nonzero low three bits instead of pointing at
+        // a heap object.
         irStream << "declare void @pycc_gc_write_barrier(ptr, ptr)\n"
+                << "@pycc_gc_marking = external global i8\n"
+                << "define internal void @pycc_gc_store_barrier(ptr %slot, ptr %value) alwaysinline {\n"
+                << "entry:\n"
+                << "  %marking = load atomic i8, ptr @pycc_gc_marking monotonic, align 1\n"
+                << "  %active = icmp ne i8 %marking, 0\n"
+                << "  br i1 %active, label %check, label %done, !prof !{!\"branch_weights\", i32 1, i32 2000}\n"
+                << "check:\n"
+                << "  %bits = ptrtoint ptr %value to i64\n"
+                << "  %low = and i64 %bits, 7\n"
+                << "  %heap = icmp eq i64 %low, 0\n"
+                << "  br i1 %heap, label %slow, label %done\n"
+                << "slow:\n"
+                << "  call void @pycc_gc_write_barrier(ptr %slot, ptr %value)\n"
+                << "  br label %done\n"
+                << "done:\n"
+                << "  ret void\n"
+                << "}\n";
+        // Safepoint poll for loop headers: a collector about to walk thread stacks raises
+        // pycc_gc_safepoint_requested and waits for every thread to park in pycc_gc_safepoint.
+        // Every loop header polls (while, for over sets and dicts, set comprehensions), with the
+        // heap pointers live across it held in root slots: runtime calls that take no lock, such
+        // as iterator steps, are no safepoints, and the poll is cheap enough to keep
+        // unconditional.
+        irStream << "declare void @pycc_gc_safepoint()\n"
+                << "@pycc_gc_safepoint_requested = external global i8\n"
+                << "define internal void @pycc_gc_poll() alwaysinline {\n"
+                << "entry:\n"
+                << "  %requested = load atomic i8, ptr @pycc_gc_safepoint_requested monotonic, align 1\n"
+                << "  %stop = icmp ne i8 %requested, 0\n"
+                << "  br i1 %stop, label %park, label %done, !prof !{!\"branch_weights\", i32 1, i32 2000}\n"
+                << "park:\n"
+                << "  call void @pycc_gc_safepoint()\n"
+                << "  br label %done\n"
+                << "done:\n"
+                << "  ret void\n"
+                << "}\n"
                 // Future aggregate runtime calls (scaffold)
                 << "declare ptr @pycc_list_new(i64)\n"
                 << "declare void @pycc_list_push(ptr, ptr)\n"
@@ -265,6 +563,10 @@ namespace pycc::codegen {
                 << "declare void @pycc_dict_set(ptr, ptr, ptr)\n"
                 << "declare ptr @pycc_dict_get(ptr, ptr)\n"
                 << "declare i64 @pycc_dict_len(ptr)\n"
+                << "declare ptr @pycc_set_new(i64)\n"
+                << "declare void @pycc_set_add(ptr, ptr)\n"
+                << "declare i1 @pycc_set_contains(ptr, ptr)\n"
+                << "declare i64 @pycc_set_len(ptr)\n"
                 << "declare void @pycc_object_set_attr(ptr, ptr, ptr)\n"
                 << "declare ptr @pycc_object_get_attr(ptr, ptr)\n"
                 << "declare ptr @pycc_string_new(ptr, i64)\n"
@@ -592,7 +894,9 @@ namespace pycc::codegen {
                 << "declare void @pycc_collections_defaultdict_set(ptr, ptr, ptr)\n\n"
                 // Dict iteration helpers
                 << "declare ptr @pycc_dict_iter_new(ptr)\n"
-                << "declare ptr @pycc_dict_iter_next(ptr)\n\n";
+                << "declare ptr @pycc_dict_iter_next(ptr)\n"
+                << "declare ptr @pycc_set_iter_new(ptr)\n"
+                << "declare ptr @pycc_set_iter_next(ptr)\n\n";
 
         // Pre-scan functions to gather signatures
         struct Sig {
@@ -999,11 +1303,44 @@ namespace pycc::codegen {
             std::ostringstream fnBody;
 
             enum class ValKind : std::uint8_t { I32, I1, F64, Ptr };
-            enum class PtrTag : std::uint8_t { Unknown, Str, Bytes, List, Dict, Object };
+            enum class PtrTag : std::uint8_t { Unknown, Str, Bytes, List, Dict, Set, Object, StackList };
             struct Slot {
                 std::string ptr;
                 ValKind kind{};
                 PtrTag tag{PtrTag::Unknown};
+                std::size_t stackLen{0}; // StackList: elements live in <ptr>.el<i> stack slots
+                std::vector<ValKind> stackKinds; // StackList: kind each element had before it was tagged/boxed
+
+                // Load StackList element i and undo its tagging (ints, bools) or boxing (floats); the returned
+                // register holds a value of stackKinds[i].
+                std::string loadStackElem(std::ostringstream &ir, int &temp, std::size_t i,
+                                          const std::string &dbgSuffix) const {
+                    std::ostringstream el;
+                    el << "%t" << temp++;
+                    const ValKind k = stackKinds[i];
+                    if (k == ValKind::F64) {
+                        ir << "  " << el.str() << " = load ptr, ptr " << ptr << i << dbgSuffix << "\n";
+                        std::ostringstream d;
+                        d << "%t" << temp++;
+                        ir << "  " << d.str() << " = load double, ptr " << el.str() << dbgSuffix << "\n";
+                        return d.str();
+                    }
+                    ir << "  " << el.str() << " = load ptr, ptr " << ptr << i << dbgSuffix << "\n";
+                    if (k != ValKind::I32 && k != ValKind::I1) { return el.str(); }
+                    std::ostringstream w, sh, v;
+                    w << "%t" << temp++;
+                    sh << "%t" << temp++;
+                    v << "%t" << temp++;
+                    ir << "  " << w.str() << " = ptrtoint ptr " << el.str() << " to i64" << dbgSuffix << "\n";
+                    if (k == ValKind::I32) {
+                        ir << "  " << sh.str() << " = ashr i64 " << w.str() << ", 1" << dbgSuffix << "\n";
+                        ir << "  " << v.str() << " = trunc i64 " << sh.str() << " to i32" << dbgSuffix << "\n";
+                    } else {
+                        ir << "  " << sh.str() << " = lshr i64 " << w.str() << ", 3" << dbgSuffix << "\n";
+                        ir << "  " << v.str() << " = trunc i64 " << sh.str() << " to i1" << dbgSuffix << "\n";
+                    }
+                    return v.str();
+                }
             };
             std::unordered_map<std::string, Slot> slots; // var -> slot
             int temp = 0;
@@ -1044,7 +1381,7 @@ namespace pycc::codegen {
                 } else if (param.type == ast::TypeKind::Str || param.type == ast::TypeKind::Bytes) {
                     fnPrologue << "  " << ptr << " = alloca ptr\n";
                     fnPrologue << "  store ptr %" << param.name << ", ptr " << ptr << "\n";
-                    fnPrologue << "  call void @pycc_gc_write_barrier(ptr " << ptr << ", ptr %" << param.name << ")\n";
+                    fnPrologue << "  call void @pycc_gc_store_barrier(ptr " << ptr << ", ptr %" << param.name << ")\n";
                     fnPrologue << "  call void @llvm.gcroot(ptr " << ptr << ", ptr null)\n";
                     Slot s{ptr, ValKind::Ptr};
                     s.tag = (param.type == ast::TypeKind::Str) ? PtrTag::Str : PtrTag::Bytes;
@@ -1153,6 +1490,39 @@ namespace pycc::codegen {
                     return out;
                 }
 
+                // Box a native value into a runtime object pointer (pointers pass through).
+                std::string boxValue(const Value &v) {
+                    if (v.k == ValKind::Ptr) { return v.s; }
+                    std::ostringstream r;
+                    r << "%t" << temp++;
+                    if (v.k == ValKind::I32) {
+                        std::string wide = v.s;
+                        if (!v.s.empty() && v.s[0] == '%') {
+                            std::ostringstream w;
+                            w << "%t" << temp++;
+                            ir << "  " << w.str() << " = sext i32 " << v.s << " to i64\n";
+                            wide = w.str();
+                        }
+                        usedBoxInt = true;
+                        ir << "  " << r.str() << " = call ptr @pycc_box_int(i64 " << wide << ")\n";
+                    } else if (v.k == ValKind::F64) {
+                        usedBoxFloat = true;
+                        ir << "  " << r.str() << " = call ptr @pycc_box_float(double " << v.s << ")\n";
+                    } else {
+                        usedBoxBool = true;
+                        ir << "  " << r.str() << " = call ptr @pycc_box_bool(i1 " << v.s << ")\n";
+                    }
+                    return r.str();
+                }
+
+                // True when the expression is known to evaluate to a runtime set.
+                bool isSetExpr(const ast::Expr &e) const {
+                    if (e.kind == ast::NodeKind::SetLiteral || e.kind == ast::NodeKind::SetComp) { return true; }
+                    if (e.kind != ast::NodeKind::Name) { return false; }
+                    auto it = slots.find(static_cast<const ast::Name &>(e).id);
+                    return it != slots.end() && it->second.tag == PtrTag::Set;
+                }
+
                 void visit(const ast::IntLiteral &lit) override {
                     out = Value{std::to_string(static_cast<int>(lit.value)), ValKind::I32};
                 }
@@ -1184,20 +1554,13 @@ namespace pycc::codegen {
                 }
 
                 void visit(const ast::StringLiteral &s) override {
-                    // Ensure global exists and retrieve length
+                    // Ensure global exists; the constant's immortal string object needs no allocation
                     ensureStrConst(s.value);
                     auto it = strGlobals.find(s.value);
                     const std::string &gname = it->second.first;
-                    const size_t glen = it->second.second - 1; // stored with NUL
-                    // Compute pointer to constant data
-                    std::ostringstream dataPtr;
-                    dataPtr << "%t" << temp++;
-                    ir << "  " << dataPtr.str() << " = getelementptr inbounds i8, ptr @" << gname << ", i64 0\n";
-                    // Call runtime to create managed string object
                     std::ostringstream reg;
                     reg << "%t" << temp++;
-                    ir << "  " << reg.str() << " = call ptr @pycc_string_new(ptr " << dataPtr.str() << ", i64 " << glen
-                            << ")\n";
+                    ir << "  " << reg.str() << " = getelementptr inbounds i8, ptr @" << staticStrObject(gname) << ", i64 8\n";
                     out = Value{reg.str(), ValKind::Ptr};
                 }
 
@@ -1219,8 +1582,63 @@ namespace pycc::codegen {
                     out = Value{reg.str(), ValKind::Ptr};
                 }
 
+                // Read from a list kept in stack slots: a constant index loads its slot directly and yields the
+                // element's own kind, any other index selects over every slot and yields the tagged pointer.
+                // Negative indices count from the end and out-of-range reads give null, like pycc_list_get.
+                Value stackListGet(const Slot &slot, const ast::Expr &index) {
+                    const ast::Expr *lit = &index;
+                    bool negated = false;
+                    if (index.kind == ast::NodeKind::UnaryExpr) {
+                        const auto &un = static_cast<const ast::Unary &>(index);
+                        if (un.op == ast::UnaryOperator::Neg && un.operand && un.operand->kind == ast::NodeKind::IntLiteral) {
+                            lit = un.operand.get();
+                            negated = true;
+                        }
+                    }
+                    if (lit->kind == ast::NodeKind::IntLiteral) {
+                        auto k = static_cast<int64_t>(static_cast<const ast::IntLiteral &>(*lit).value);
+                        if (negated) { k = -k; }
+                        if (k < 0) { k += static_cast<int64_t>(slot.stackLen); }
+                        if (k < 0 || static_cast<std::size_t>(k) >= slot.stackLen) {
+                            return Value{"null", ValKind::Ptr};
+                        }
+                        const auto i = static_cast<std::size_t>(k);
+                        return Value{slot.loadStackElem(ir, temp, i, ""), slot.stackKinds[i]};
+                    }
+                    auto idxV = run(index);
+                    if (idxV.k != ValKind::I32) { throw std::runtime_error("subscript index must be int"); }
+                    std::ostringstream neg, wrapped, norm;
+                    neg << "%t" << temp++;
+                    wrapped << "%t" << temp++;
+                    norm << "%t" << temp++;
+                    ir << "  " << neg.str() << " = icmp slt i32 " << idxV.s << ", 0\n";
+                    ir << "  " << wrapped.str() << " = add i32 " << idxV.s << ", " << slot.stackLen << "\n";
+                    ir << "  " << norm.str() << " = select i1 " << neg.str() << ", i32 " << wrapped.str() << ", i32 " <<
+                            idxV.s << "\n";
+                    std::string cur = "null";
+                    for (std::size_t i = 0; i < slot.stackLen; ++i) {
+                        std::ostringstream el, hit, sel;
+                        el << "%t" << temp++;
+                        hit << "%t" << temp++;
+                        sel << "%t" << temp++;
+                        ir << "  " << el.str() << " = load ptr, ptr " << slot.ptr << i << "\n";
+                        ir << "  " << hit.str() << " = icmp eq i32 " << norm.str() << ", " << i << "\n";
+                        ir << "  " << sel.str() << " = select i1 " << hit.str() << ", ptr " << el.str() << ", ptr " <<
+                                cur << "\n";
+                        cur = sel.str();
+                    }
+                    return Value{cur, ValKind::Ptr};
+                }
+
                 void visit(const ast::Subscript &sub) override {
                     if (!sub.value || !sub.slice) { throw std::runtime_error("null subscript"); }
+                    if (sub.value->kind == ast::NodeKind::Name) {
+                        auto it = slots.find(static_cast<const ast::Name *>(sub.value.get())->id);
+                        if (it != slots.end() && it->second.tag == PtrTag::StackList) {
+                            out = stackListGet(it->second, *sub.slice);
+                            return;
+                        }
+                    }
                     // Evaluate base
                     auto base = run(*sub.value);
                     if (base.k != ValKind::Ptr) { throw std::runtime_error("subscript base must be pointer"); }
@@ -1313,8 +1731,9 @@ namespace pycc::codegen {
                     cap << (n == 0 ? 8 : n * 2);
                     ir << "  " << slot.str() << " = alloca ptr\n";
                     ir << "  " << dict.str() << " = call ptr @pycc_dict_new(i64 " << cap.str() << ")\n";
+                    ir << "  call void @llvm.gcroot(ptr " << slot.str() << ", ptr null)\n";
                     ir << "  store ptr " << dict.str() << ", ptr " << slot.str() << "\n";
-                    ir << "  call void @pycc_gc_write_barrier(ptr " << slot.str() << ", ptr " << dict.str() << ")\n";
+                    ir << "  call void @pycc_gc_store_barrier(ptr " << slot.str() << ", ptr " << dict.str() << ")\n";
                     for (const auto &kv: d.items) {
                         if (!kv.first || !kv.second) { continue; }
                         auto k = run(*kv.first);
@@ -1396,6 +1815,170 @@ namespace pycc::codegen {
                     out = Value{outReg.str(), ValKind::Ptr};
                 }
 
+                // Allocate a GC-rooted slot holding a fresh set; adds go through the slot since growth moves it.
+                std::string emitSetSlot(std::size_t capacity) {
+                    std::ostringstream slot, set;
+                    slot << "%t" << temp++;
+                    set << "%t" << temp++;
+                    ir << "  " << slot.str() << " = alloca ptr\n";
+                    ir << "  " << set.str() << " = call ptr @pycc_set_new(i64 " << capacity << ")\n";
+                    ir << "  call void @llvm.gcroot(ptr " << slot.str() << ", ptr null)\n";
+                    ir << "  store ptr " << set.str() << ", ptr " << slot.str() << "\n";
+                    ir << "  call void @pycc_gc_store_barrier(ptr " << slot.str() << ", ptr " << set.str() << ")\n";
+                    return slot.str();
+                }
+
+                void visit(const ast::SetLiteral &st) override {
+                    const std::string slot = emitSetSlot(st.elements.empty() ? 8 : st.elements.size() * 2);
+                    for (const auto &e: st.elements) {
+                        if (!e) { continue; }
+                        const std::string eptr = boxValue(run(*e));
+                        ir << "  call void @pycc_set_add(ptr " << slot << ", ptr " << eptr << ")\n";
+                    }
+                    std::ostringstream outReg;
+                    outReg << "%t" << temp++;
+                    ir << "  " << outReg.str() << " = load ptr, ptr " << slot << "\n";
+                    out = Value{outReg.str(), ValKind::Ptr};
+                }
+
+                void visit(const ast::SetComp &sc) override {
+                    if (!sc.elt || sc.fors.empty()) { throw std::runtime_error("malformed set comprehension"); }
+                    const std::string slot = emitSetSlot(8);
+                    // Target and iterator slots for every clause are allocated up front, outside any loop
+                    std::vector<SetCompSlots> clauseSlots(sc.fors.size());
+                    for (auto &cs: clauseSlots) {
+                        cs.it = newAlloca("ptr", true);
+                        cs.byKind[static_cast<int>(ValKind::Ptr)] = newAlloca("ptr", true);
+                        cs.byKind[static_cast<int>(ValKind::I32)] = newAlloca("i32", false);
+                        cs.byKind[static_cast<int>(ValKind::I1)] = newAlloca("i1", false);
+                        cs.byKind[static_cast<int>(ValKind::F64)] = newAlloca("double", false);
+                    }
+                    emitSetCompClause(sc, 0, slot, clauseSlots);
+                    std::ostringstream outReg;
+                    outReg << "%t" << temp++;
+                    ir << "  " << outReg.str() << " = load ptr, ptr " << slot << "\n";
+                    out = Value{outReg.str(), ValKind::Ptr};
+                }
+
+                struct SetCompSlots {
+                    std::string it;
+                    std::string byKind[4];
+                };
+
+                std::string newAlloca(const char *ty, bool rooted) {
+                    std::ostringstream a;
+                    a << "%t" << temp++;
+                    ir << "  " << a.str() << " = alloca " << ty << "\n";
+                    if (rooted) {
+                        ir << "  call void @llvm.gcroot(ptr " << a.str() << ", ptr null)\n";
+                        ir << "  store ptr null, ptr " << a.str() << "\n";
+                    }
+                    return a.str();
+                }
+
+                // Lower one `for` clause of a set comprehension: literal lists/tuples unroll with the target
+                // bound to each element; sets and dicts are walked with the runtime iterator, binding the
+                // target to each element (or key) object.
+                void emitSetCompClause(const ast::SetComp &sc, std::size_t depth, const std::string &setSlot,
+                                       const std::vector<SetCompSlots> &clauseSlots) {
+                    if (depth == sc.fors.size()) {
+                        const std::string eptr = boxValue(run(*sc.elt));
+                        ir << "  call void @pycc_set_add(ptr " << setSlot << ", ptr " << eptr << ")\n";
+                        return;
+                    }
+                    const auto &cf = sc.fors[depth];
+                    if (!cf.target || cf.target->kind != ast::NodeKind::Name || !cf.iter) {
+                        throw std::runtime_error("set comprehension target must be a name");
+                    }
+                    if (cf.isAsync) { throw std::runtime_error("async set comprehension not supported"); }
+                    const std::string &var = static_cast<const ast::Name *>(cf.target.get())->id;
+                    const SetCompSlots &cs = clauseSlots[depth];
+                    static int setCompCounter = 0;
+                    const std::string lbl = "setc" + std::to_string(setCompCounter++);
+                    const auto shadowed = slots.find(var);
+                    const std::optional<Slot> saved = shadowed != slots.end()
+                                                          ? std::optional<Slot>(shadowed->second)
+                                                          : std::nullopt;
+                    // Branch to `skipLbl` unless every guard holds, then emit the next clause
+                    auto emitGuardedBody = [&](const std::string &skipLbl, const std::string &tagLbl) {
+                        for (std::size_t g = 0; g < cf.ifs.size(); ++g) {
+                            if (!cf.ifs[g]) { continue; }
+                            auto cv = run(*cf.ifs[g]);
+                            std::string cond = cv.s;
+                            if (cv.k != ValKind::I1) {
+                                std::ostringstream c;
+                                c << "%t" << temp++;
+                                cond = c.str();
+                                if (cv.k == ValKind::I32) {
+                                    ir << "  " << cond << " = icmp ne i32 " << cv.s << ", 0\n";
+                                } else if (cv.k == ValKind::F64) {
+                                    ir << "  " << cond << " = fcmp one double " << cv.s << ", 0.0\n";
+                                } else {
+                                    ir << "  " << cond << " = icmp ne ptr " << cv.s << ", null\n";
+                                }
+                            }
+                            const std::string passLbl = tagLbl + ".if" + std::to_string(g);
+                            ir << "  br i1 " << cond << ", label %" << passLbl << ", label %" << skipLbl << "\n";
+                            ir << passLbl << ":\n";
+                        }
+                        emitSetCompClause(sc, depth + 1, setSlot, clauseSlots);
+                        ir << "  br label %" << skipLbl << "\n";
+                    };
+                    const ast::Expr &iter = *cf.iter;
+                    const bool overSet = isSetExpr(iter);
+                    bool overDict = false;
+                    if (iter.kind == ast::NodeKind::Name) {
+                        auto it = slots.find(static_cast<const ast::Name &>(iter).id);
+                        overDict = it != slots.end() && it->second.tag == PtrTag::Dict;
+                    }
+                    if (iter.kind == ast::NodeKind::ListLiteral || iter.kind == ast::NodeKind::TupleLiteral) {
+                        const auto &elems = iter.kind == ast::NodeKind::ListLiteral
+                                                ? static_cast<const ast::ListLiteral &>(iter).elements
+                                                : static_cast<const ast::TupleLiteral &>(iter).elements;
+                        for (std::size_t i = 0; i < elems.size(); ++i) {
+                            if (!elems[i]) { continue; }
+                            auto v = run(*elems[i]);
+                            const std::string &vslot = cs.byKind[static_cast<int>(v.k)];
+                            const char *ty = v.k == ValKind::I32 ? "i32"
+                                             : v.k == ValKind::I1 ? "i1"
+                                             : v.k == ValKind::F64 ? "double" : "ptr";
+                            ir << "  store " << ty << " " << v.s << ", ptr " << vslot << "\n";
+                            slots[var] = Slot{vslot, v.k};
+                            const std::string elemLbl = lbl + ".e" + std::to_string(i);
+                            emitGuardedBody(elemLbl + ".next", elemLbl);
+                            ir << elemLbl << ".next:\n";
+                        }
+                    } else if (overSet || overDict) {
+                        auto container = run(iter);
+                        const std::string &varSlot = cs.byKind[static_cast<int>(ValKind::Ptr)];
+                        std::ostringstream itReg;
+                        itReg << "%t" << temp++;
+                        ir << "  " << itReg.str() << " = call ptr @"
+                                << (overSet ? "pycc_set_iter_new" : "pycc_dict_iter_new") << "(ptr " << container.s << ")\n";
+                        ir << "  store ptr " << itReg.str() << ", ptr " << cs.it << "\n";
+                        slots[var] = Slot{varSlot, ValKind::Ptr};
+                        std::ostringstream itv, elem, done;
+                        itv << "%t" << temp++;
+                        elem << "%t" << temp++;
+                        done << "%t" << temp++;
+                        ir << "  br label %" << lbl << ".cond\n";
+                        ir << lbl << ".cond:\n";
+                        ir << "  call void @pycc_gc_poll()\n"; // safepoint; never unwinds
+                        ir << "  " << itv.str() << " = load ptr, ptr " << cs.it << "\n";
+                        ir << "  " << elem.str() << " = call ptr @"
+                                << (overSet ? "pycc_set_iter_next" : "pycc_dict_iter_next") << "(ptr " << itv.str() << ")\n";
+                        ir << "  " << done.str() << " = icmp eq ptr " << elem.str() << ", null\n";
+                        ir << "  br i1 " << done.str() << ", label %" << lbl << ".end, label %" << lbl << ".body\n";
+                        ir << lbl << ".body:\n";
+                        ir << "  store ptr " << elem.str() << ", ptr " << varSlot << "\n";
+                        emitGuardedBody(lbl + ".cond", lbl);
+                        ir << lbl << ".end:\n";
+                    } else {
+                        throw std::runtime_error("unsupported iterable in set comprehension");
+                    }
+                    if (saved) { slots[var] = *saved; } else { slots.erase(var); }
+                }
+
                 void visit(const ast::Attribute &attr) override {
                     if (!attr.value) { throw std::runtime_error("null attribute base"); }
                     auto base = run(*attr.value);
@@ -1414,13 +1997,10 @@ namespace pycc::codegen {
                     const uint64_t h = hash(attr.attr);
                     std::ostringstream gname;
                     gname << ".str_" << std::hex << h;
-                    std::ostringstream dataPtr;
-                    dataPtr << "%t" << temp++;
-                    ir << "  " << dataPtr.str() << " = getelementptr inbounds i8, ptr @" << gname.str() << ", i64 0\n";
                     std::ostringstream sobj;
                     sobj << "%t" << temp++;
-                    ir << "  " << sobj.str() << " = call ptr @pycc_string_new(ptr " << dataPtr.str() << ", i64 " <<
-                            static_cast<long long>(attr.attr.size()) << ")\n";
+                    ir << "  " << sobj.str() << " = getelementptr inbounds i8, ptr @" << staticStrObject(gname.str()) <<
+                            ", i64 8\n";
                     std::ostringstream reg;
                     reg << "%t" << temp++;
                     ir << "  " << reg.str() << " = call ptr @pycc_object_get_attr(ptr " << base.s << ", ptr " << sobj.
@@ -1488,8 +2068,9 @@ namespace pycc::codegen {
                     cap << n;
                     ir << "  " << slot.str() << " = alloca ptr\n";
                     ir << "  " << lst.str() << " = call ptr @pycc_list_new(i64 " << cap.str() << ")\n";
+                    ir << "  call void @llvm.gcroot(ptr " << slot.str() << ", ptr null)\n";
                     ir << "  store ptr " << lst.str() << ", ptr " << slot.str() << "\n";
-                    ir << "  call void @pycc_gc_write_barrier(ptr " << slot.str() << ", ptr " << lst.str() << ")\n";
+                    ir << "  call void @pycc_gc_store_barrier(ptr " << slot.str() << ", ptr " << lst.str() << ")\n";
                     for (const auto &el: list.elements) {
                         if (!el) { continue; }
                         auto v = run(*el);
@@ -1538,6 +2119,9 @@ namespace pycc::codegen {
                 void visit(const ast::Name &nm) override {
                     auto it = slots.find(nm.id);
                     if (it == slots.end()) throw std::runtime_error(std::string("undefined name: ") + nm.id);
+                    if (it->second.tag == PtrTag::StackList) {
+                        throw std::runtime_error(std::string("internal: stack list escaped: ") + nm.id);
+                    }
                     std::ostringstream reg;
                     reg << "%t" << temp++;
                     if (it->second.kind == ValKind::I32)
@@ -5147,6 +5731,23 @@ namespace pycc::codegen {
                             out = Value{std::to_string(static_cast<int>(listLit->elements.size())), ValKind::I32};
                             return;
                         }
+                        if (arg0->kind == ast::NodeKind::Name) {
+                            auto itStack = slots.find(static_cast<const ast::Name *>(arg0)->id);
+                            if (itStack != slots.end() && itStack->second.tag == PtrTag::StackList) {
+                                out = Value{std::to_string(static_cast<int>(itStack->second.stackLen)), ValKind::I32};
+                                return;
+                            }
+                        }
+                        if (isSetExpr(*arg0)) {
+                            auto v = run(*arg0);
+                            std::ostringstream r64, r32;
+                            r64 << "%t" << temp++;
+                            r32 << "%t" << temp++;
+                            ir << "  " << r64.str() << " = call i64 @pycc_set_len(ptr " << v.s << ")\n";
+                            ir << "  " << r32.str() << " = trunc i64 " << r64.str() << " to i32\n";
+                            out = Value{r32.str(), ValKind::I32};
+                            return;
+                        }
                         if (arg0->kind == ast::NodeKind::StringLiteral) {
                             // Defer to runtime for correct code point length
                             auto v = run(*arg0);
@@ -5516,6 +6117,22 @@ namespace pycc::codegen {
                     // only need to inspect RHS structure without lowering it as a value.
                     // Handle membership early to avoid lowering tuple/list RHS as a value.
                     if (b.op == ast::BinaryOperator::In || b.op == ast::BinaryOperator::NotIn) {
+                        // Set membership: one hashed probe in the runtime set
+                        if (isSetExpr(*b.rhs)) {
+                            const std::string needle = boxValue(LV);
+                            auto S = run(*b.rhs);
+                            std::ostringstream c;
+                            c << "%t" << temp++;
+                            ir << "  " << c.str() << " = call i1 @pycc_set_contains(ptr " << S.s << ", ptr " << needle
+                                    << ")\n";
+                            if (b.op == ast::BinaryOperator::NotIn) {
+                                std::ostringstream nx;
+                                nx << "%t" << temp++;
+                                ir << "  " << nx.str() << " = xor i1 " << c.str() << ", true\n";
+                                out = Value{nx.str(), ValKind::I1};
+                            } else { out = Value{c.str(), ValKind::I1}; }
+                            return;
+                        }
                         // String membership: substring in string
                         bool rhsStr = (b.rhs->kind == ast::NodeKind::StringLiteral) ||
                                       (b.rhs->kind == ast::NodeKind::Name && [this,&b]() {
@@ -6247,6 +6864,64 @@ namespace pycc::codegen {
                 std::string excCheckLabel;
                 // Landingpad label when under try
                 std::string lpadLabel;
+                // Locals whose list literal never escapes the frame (name -> length)
+                const std::unordered_map<std::string, std::size_t> *stackLists{nullptr};
+
+                // Bind a non-escaping list literal to per-element stack slots instead of a heap list. Ints and
+                // bools are stored as tagged immediates (the encoding of pycc_box_int/pycc_box_bool) and their
+                // slots are not GC roots; only float boxes and pointers are rooted and written through the barrier.
+                void emitStackList(const std::string &name, const ast::ListLiteral &lst, const std::string &dbgSuffix) {
+                    if (slots.contains(name)) { throw std::runtime_error("assignment type changed for variable"); }
+                    const std::string base = "%" + name + ".el";
+                    std::vector<Value> vals;
+                    vals.reserve(lst.elements.size());
+                    for (const auto &el: lst.elements) {
+                        vals.push_back(el ? eval(el.get()) : Value{"null", ValKind::Ptr});
+                    }
+                    for (std::size_t i = 0; i < vals.size(); ++i) {
+                        const Value &v = vals[i];
+                        const std::string addr = base + std::to_string(i);
+                        const bool heap = (v.k == ValKind::F64 || v.k == ValKind::Ptr);
+                        prologue << "  " << addr << " = alloca ptr\n";
+                        if (heap) { prologue << "  call void @llvm.gcroot(ptr " << addr << ", ptr null)\n"; }
+                        std::string elemPtr;
+                        if (v.k == ValKind::I32 || v.k == ValKind::I1) {
+                            std::ostringstream w, sh, tag, p;
+                            w << "%t" << temp++;
+                            sh << "%t" << temp++;
+                            tag << "%t" << temp++;
+                            p << "%t" << temp++;
+                            if (v.k == ValKind::I32) {
+                                ir << "  " << w.str() << " = sext i32 " << v.s << " to i64" << dbgSuffix << "\n";
+                                ir << "  " << sh.str() << " = shl i64 " << w.str() << ", 1" << dbgSuffix << "\n";
+                                ir << "  " << tag.str() << " = or i64 " << sh.str() << ", 1" << dbgSuffix << "\n";
+                            } else {
+                                ir << "  " << w.str() << " = zext i1 " << v.s << " to i64" << dbgSuffix << "\n";
+                                ir << "  " << sh.str() << " = shl i64 " << w.str() << ", 3" << dbgSuffix << "\n";
+                                ir << "  " << tag.str() << " = or i64 " << sh.str() << ", 2" << dbgSuffix << "\n";
+                            }
+                            ir << "  " << p.str() << " = inttoptr i64 " << tag.str() << " to ptr" << dbgSuffix << "\n";
+                            elemPtr = p.str();
+                        } else if (v.k == ValKind::F64) {
+                            std::ostringstream w;
+                            w << "%t" << temp++;
+                            usedBoxFloat = true;
+                            ir << "  " << w.str() << " = call ptr @pycc_box_float(double " << v.s << ")" << dbgSuffix <<
+                                    "\n";
+                            elemPtr = w.str();
+                        } else { elemPtr = v.s; }
+                        ir << "  store ptr " << elemPtr << ", ptr " << addr << dbgSuffix << "\n";
+                        if (heap) {
+                            std::ostringstream ca;
+                            ca << "@pycc_gc_store_barrier(ptr " << addr << ", ptr " << elemPtr << ")";
+                            emitCallOrInvokeVoid(ca.str());
+                        }
+                    }
+                    Slot s{base, ValKind::Ptr, PtrTag::StackList};
+                    s.stackLen = vals.size();
+                    for (const auto &v: vals) { s.stackKinds.push_back(v.k); }
+                    slots[name] = s;
+                }
 
                 // Emit a call that may be turned into invoke (void return)
                 void emitCallOrInvokeVoid(const std::string &calleeAndArgs) {
@@ -6418,13 +7093,18 @@ namespace pycc::codegen {
                             return;
                         }
                     }
-                    auto val = eval(asg.value.get());
                     // Prefer legacy simple name, else derive name from single-name target
                     std::string varName = asg.target;
                     if (varName.empty() && asg.targets.size() == 1 && asg.targets[0] && asg.targets[0]->kind ==
                         ast::NodeKind::Name) {
                         varName = static_cast<const ast::Name *>(asg.targets[0].get())->id;
                     }
+                    if (stackLists != nullptr && stackLists->contains(varName) && asg.value &&
+                        asg.value->kind == ast::NodeKind::ListLiteral) {
+                        emitStackList(varName, static_cast<const ast::ListLiteral &>(*asg.value), dbg());
+                        return;
+                    }
+                    auto val = eval(asg.value.get());
                     auto it = slots.find(varName);
                     if (it == slots.end()) {
                         std::string ptr = "%" + varName + ".addr";
@@ -6467,7 +7147,7 @@ namespace pycc::codegen {
                         ir << "  store ptr " << val.s << ", ptr " << it->second.ptr << dbg() << "\n";
                         {
                             std::ostringstream ca;
-                            ca << "@pycc_gc_write_barrier(ptr " << it->second.ptr << ", ptr " << val.s << ")";
+                            ca << "@pycc_gc_store_barrier(ptr " << it->second.ptr << ", ptr " << val.s << ")";
                             emitCallOrInvokeVoid(ca.str());
                         }
                     }
@@ -6475,6 +7155,8 @@ namespace pycc::codegen {
                         // Tag from literal kinds
                         if (asg.value->kind == ast::NodeKind::ListLiteral) { it->second.tag = PtrTag::List; } else if (
                             asg.value->kind == ast::NodeKind::DictLiteral) { it->second.tag = PtrTag::Dict; } else if (
+                            asg.value->kind == ast::NodeKind::SetLiteral ||
+                            asg.value->kind == ast::NodeKind::SetComp) { it->second.tag = PtrTag::Set; } else if (
                             asg.value->kind == ast::NodeKind::StringLiteral) { it->second.tag = PtrTag::Str; } else if (
                             asg.value->kind == ast::NodeKind::BytesLiteral) { it->second.tag = PtrTag::Bytes; } else if
                         (
@@ -6723,6 +7405,7 @@ namespace pycc::codegen {
                     // Initial branch to condition
                     ir << "  br label %" << condLbl.str() << dbg() << "\n";
                     ir << condLbl.str() << ":\n";
+                    ir << "  call void @pycc_gc_poll()" << dbg() << "\n"; // safepoint; never unwinds
                     auto c = eval(ws.cond.get());
                     std::string cond = c.s;
                     if (c.k == ValKind::I32) {
@@ -6880,7 +7563,10 @@ namespace pycc::codegen {
                             if (kind == ValKind::I32) prologue << "  " << ptr << " = alloca i32\n";
                             else if (kind == ValKind::I1) prologue << "  " << ptr << " = alloca i1\n";
                             else if (kind == ValKind::F64) prologue << "  " << ptr << " = alloca double\n";
-                            else prologue << "  " << ptr << " = alloca ptr\n";
+                            else {
+                                prologue << "  " << ptr << " = alloca ptr\n";
+                                prologue << "  call void @llvm.gcroot(ptr " << ptr << ", ptr null)\n";
+                            }
                             slots[name] = Slot{ptr, kind};
                             // Debug declare for loop-target variable on first definition
                             int varId = 0;
@@ -6914,12 +7600,65 @@ namespace pycc::codegen {
                             ir << "  store ptr " << v.s << ", ptr " << addr << dbg() << "\n";
                             {
                                 std::ostringstream ca;
-                                ca << "@pycc_gc_write_barrier(ptr " << addr << ", ptr " << v.s << ")";
+                                ca << "@pycc_gc_store_barrier(ptr " << addr << ", ptr " << v.s << ")";
                                 emitCallOrInvokeVoid(ca.str());
                             }
                         }
                         (void) emitStmtList(fs.thenBody);
                     };
+                    // Drive a dict/set iterator over an evaluated container, binding each key/element to the target
+                    auto emitIterLoop = [&](const std::string &container, const char *iterApi) {
+                        std::ostringstream itv, itSlot, itCur, key, condLbl, bodyLbl, endLbl;
+                        itv << "%t" << temp++;
+                        {
+                            std::ostringstream args;
+                            args << "@" << iterApi << "_new(ptr " << container << ")";
+                            emitCallOrInvokePtr(itv.str(), args.str());
+                        }
+                        // The iterator lives in a root slot so collections at the header poll see it
+                        itSlot << "%for.it" << ifCounter;
+                        prologue << "  " << itSlot.str() << " = alloca ptr\n";
+                        prologue << "  call void @llvm.gcroot(ptr " << itSlot.str() << ", ptr null)\n";
+                        ir << "  store ptr " << itv.str() << ", ptr " << itSlot.str() << dbg() << "\n";
+                        {
+                            std::ostringstream ca;
+                            ca << "@pycc_gc_store_barrier(ptr " << itSlot.str() << ", ptr " << itv.str() << ")";
+                            emitCallOrInvokeVoid(ca.str());
+                        }
+                        condLbl << "for.cond" << ifCounter;
+                        bodyLbl << "for.body" << ifCounter;
+                        endLbl << "for.end" << ifCounter;
+                        ++ifCounter;
+                        ir << "  br label %" << condLbl.str() << dbg() << "\n";
+                        ir << condLbl.str() << ":\n";
+                        ir << "  call void @pycc_gc_poll()" << dbg() << "\n"; // safepoint; never unwinds
+                        itCur << "%t" << temp++;
+                        ir << "  " << itCur.str() << " = load ptr, ptr " << itSlot.str() << dbg() << "\n";
+                        key << "%t" << temp++;
+                        {
+                            std::ostringstream args;
+                            args << "@" << iterApi << "_next(ptr " << itCur.str() << ")";
+                            emitCallOrInvokePtr(key.str(), args.str());
+                        }
+                        std::ostringstream test;
+                        test << "%t" << temp++;
+                        ir << "  " << test.str() << " = icmp ne ptr " << key.str() << ", null" << dbg() << "\n";
+                        ir << "  br i1 " << test.str() << ", label %" << bodyLbl.str() << ", label %" << endLbl.
+                                str() << dbg() << "\n";
+                        ir << bodyLbl.str() << ":\n";
+                        // bind key to target
+                        const std::string addr = ensureSlotFor(tgt->id, ValKind::Ptr);
+                        ir << "  store ptr " << key.str() << ", ptr " << addr << dbg() << "\n";
+                        {
+                            std::ostringstream ca;
+                            ca << "@pycc_gc_store_barrier(ptr " << addr << ", ptr " << key.str() << ")";
+                            emitCallOrInvokeVoid(ca.str());
+                        }
+                        (void) emitStmtList(fs.thenBody);
+                        ir << "  br label %" << condLbl.str() << dbg() << "\n";
+                        ir << endLbl.str() << ":\n";
+                        (void) emitStmtList(fs.elseBody);
+                    };
                     if (fs.iterable && fs.iterable->kind == ast::NodeKind::ListLiteral) {
                         const auto *lst = static_cast<const ast::ListLiteral *>(fs.iterable.get());
                         for (const auto &el: lst->elements) {
@@ -6935,49 +7674,31 @@ namespace pycc::codegen {
                             emitBodyWithValue(v);
                         }
                     } else if (fs.iterable && fs.iterable->kind == ast::NodeKind::Name) {
-                        // If dict, iterate keys using iterator API
+                        // If dict or set, iterate keys/elements using iterator API
                         const auto *nm = static_cast<const ast::Name *>(fs.iterable.get());
                         auto itn = slots.find(nm->id);
-                        if (itn != slots.end() && itn->second.kind == ValKind::Ptr && itn->second.tag == PtrTag::Dict) {
-                            std::ostringstream itv, key, condLbl, bodyLbl, endLbl;
-                            itv << "%t" << temp++;
-                            {
-                                std::ostringstream args;
-                                args << "@pycc_dict_iter_new(ptr " << itn->second.ptr << ")";
-                                emitCallOrInvokePtr(itv.str(), args.str());
-                            }
-                            condLbl << "for.cond" << ifCounter;
-                            bodyLbl << "for.body" << ifCounter;
-                            endLbl << "for.end" << ifCounter;
-                            ++ifCounter;
-                            ir << "  br label %" << condLbl.str() << dbg() << "\n";
-                            ir << condLbl.str() << ":\n";
-                            key << "%t" << temp++;
-                            {
-                                std::ostringstream args;
-                                args << "@pycc_dict_iter_next(ptr " << itv.str() << ")";
-                                emitCallOrInvokePtr(key.str(), args.str());
+                        if (itn != slots.end() && itn->second.tag == PtrTag::StackList) {
+                            // Fixed-length stack list: unroll like a literal, one slot load per element
+                            const Slot stackSlot = itn->second;
+                            for (std::size_t i = 0; i < stackSlot.stackLen; ++i) {
+                                emitBodyWithValue(Value{stackSlot.loadStackElem(ir, temp, i, dbg()),
+                                                        stackSlot.stackKinds[i]});
                             }
-                            std::ostringstream test;
-                            test << "%t" << temp++;
-                            ir << "  " << test.str() << " = icmp ne ptr " << key.str() << ", null" << dbg() << "\n";
-                            ir << "  br i1 " << test.str() << ", label %" << bodyLbl.str() << ", label %" << endLbl.
-                                    str() << dbg() << "\n";
-                            ir << bodyLbl.str() << ":\n";
-                            // bind key to target
-                            const std::string addr = ensureSlotFor(tgt->id, ValKind::Ptr);
-                            ir << "  store ptr " << key.str() << ", ptr " << addr << dbg() << "\n";
-                            {
-                                std::ostringstream ca;
-                                ca << "@pycc_gc_write_barrier(ptr " << addr << ", ptr " << key.str() << ")";
-                                emitCallOrInvokeVoid(ca.str());
-                            }
-                            (void) emitStmtList(fs.thenBody);
-                            ir << "  br label %" << condLbl.str() << dbg() << "\n";
-                            ir << endLbl.str() << ":\n";
-                            (void) emitStmtList(fs.elseBody);
+                        } else if (itn != slots.end() && itn->second.kind == ValKind::Ptr &&
+                                   (itn->second.tag == PtrTag::Dict || itn->second.tag == PtrTag::Set)) {
+                            const char *iterApi = itn->second.tag == PtrTag::Set ? "pycc_set_iter" : "pycc_dict_iter";
+                            std::ostringstream dictv;
+                            dictv << "%t" << temp++;
+                            ir << "  " << dictv.str() << " = load ptr, ptr " << itn->second.ptr << dbg() << "\n";
+                            emitIterLoop(dictv.str(), iterApi);
                             return;
                         }
+                    } else if (fs.iterable && (fs.iterable->kind == ast::NodeKind::SetLiteral ||
+                                               fs.iterable->kind == ast::NodeKind::SetComp)) {
+                        // Set literal or comprehension: build the set, then walk it like a set-tagged name
+                        const auto setv = eval(fs.iterable.get());
+                        emitIterLoop(setv.s, "pycc_set_iter");
+                        return;
                     } else {
                         // Unsupported iterator in this subset; no-op
                     }
@@ -7056,14 +7777,11 @@ namespace pycc::codegen {
                             };
                             std::ostringstream gname;
                             gname << ".str_" << std::hex << hash(n->id);
-                            std::ostringstream dataPtr, sObj, eq;
-                            dataPtr << "%t" << temp++;
+                            std::ostringstream sObj, eq;
                             sObj << "%t" << temp++;
                             eq << "%t" << temp++;
-                            ir << "  " << dataPtr.str() << " = getelementptr inbounds i8, ptr @" << gname.str() <<
-                                    ", i64 0" << dbg() << "\n";
-                            ir << "  " << sObj.str() << " = call ptr @pycc_string_new(ptr " << dataPtr.str() << ", i64 "
-                                    << (long long) n->id.size() << ")" << dbg() << "\n";
+                            ir << "  " << sObj.str() << " = getelementptr inbounds i8, ptr @" << staticStrObject(gname.str())
+                                    << ", i64 8" << dbg() << "\n";
                             ir << "  " << eq.str() << " = call i1 @pycc_string_eq(ptr " << tyReg.str() << ", ptr " <<
                                     sObj.str() << ")" << dbg() << "\n";
                             ir << "  br i1 " << eq.str() << ", label %" << handlerLabels.back() << ", label %" << (
@@ -7090,12 +7808,13 @@ namespace pycc::codegen {
                                 std::string ptr = "%" + h->name + ".addr";
                                 // allocate slot (ptr) in prologue
                                 prologue << "  " << ptr << " = alloca ptr\n";
+                                prologue << "  call void @llvm.gcroot(ptr " << ptr << ", ptr null)\n";
                                 slots[h->name] = Slot{ptr, ValKind::Ptr};
                                 // dbg.declare omitted for brevity (could be added similarly to assigns)
                                 ir << "  store ptr " << excReg.str() << ", ptr " << ptr << dbg() << "\n";
                                 {
                                     std::ostringstream ca;
-                                    ca << "@pycc_gc_write_barrier(ptr " << ptr << ", ptr " << excReg.str() << ")";
+                                    ca << "@pycc_gc_store_barrier(ptr " << ptr << ", ptr " << excReg.str() << ")";
                                     emitCallOrInvokeVoid(ca.str());
                                 }
                             }
@@ -7118,11 +7837,12 @@ namespace pycc::codegen {
                         if (!h->name.empty()) {
                             std::string ptr = "%" + h->name + ".addr";
                             prologue << "  " << ptr << " = alloca ptr\n";
+                            prologue << "  call void @llvm.gcroot(ptr " << ptr << ", ptr null)\n";
                             slots[h->name] = Slot{ptr, ValKind::Ptr};
                             ir << "  store ptr " << excReg.str() << ", ptr " << ptr << dbg() << "\n";
                             {
                                 std::ostringstream ca;
-                                ca << "@pycc_gc_write_barrier(ptr " << ptr << ", ptr " << excReg.str() << ")";
+                                ca << "@pycc_gc_store_barrier(ptr " << ptr << ", ptr " << excReg.str() << ")";
                                 emitCallOrInvokeVoid(ca.str());
                             }
                         }
@@ -7259,6 +7979,7 @@ namespace pycc::codegen {
                         // Propagate exception/landingpad context into nested emitter
                         child.excCheckLabel = excCheckLabel;
                         child.lpadLabel = lpadLabel;
+                        child.stackLists = stackLists;
                         st->accept(child);
                         if (child.returned) brReturned = true;
                     }
@@ -7272,6 +7993,8 @@ namespace pycc::codegen {
                 subDbgId, nextDbgId, dbgLocs, dbgLocKeyToId, varMdId, dbgVars, diIntId, diBoolId, diDoubleId,
                 diPtrId, diExprId, usedBoxInt, usedBoxFloat, usedBoxBool
             };
+            const auto stackLists = StackListScan::run(*func);
+            root.stackLists = &stackLists;
             returned = root.emitStmtList(func->body);
             if (!returned) {
                 // default return based on function type
@@ -7306,8 +8029,7 @@ namespace pycc::codegen {
                 }
             }
             // Flush function prologue + body
-            irStream << fnPrologue.str();
-            irStream << fnBody.str();
+            irStream << locateCalls(fnPrologue.str() + fnBody.str(), ensureLocId(func->line, func->col));
             irStream << "}\n\n";
         }
 
@@ -7382,8 +8104,15 @@ namespace pycc::codegen {
         for (const auto &[content, info]: strGlobals) {
             const auto &name = info.first;
             const size_t count = info.second; // includes NUL
-            irStream << "@" << name << " = private unnamed_addr constant [" << count << " x i8] c\"" <<
-                    escapeIR(content) << "\\00\", align 1\n";
+            // One immortal string object per constant, its bytes doubling as the C string
+            const std::string objTy = "{ i8, i8, i8, i8, i32, i64, i64, [" + std::to_string(count) + " x i8] }";
+            irStream << "@" << staticStrObject(name) << " = private unnamed_addr constant " << objTy << " { i8 "
+                    << static_cast<int>(rt::TypeTag::String) << ", i8 1, i8 0, i8 " << static_cast<int>(rt::kFlagImmortal)
+                    << ", i32 " << (8U + 16U + count) << ", i64 " << (count - 1U) << ", i64 "
+                    << static_cast<int64_t>(rt::string_content_hash(content)) << ", [" << count << " x i8] c\""
+                    << escapeIR(content) << "\\00\" }, align 16\n";
+            irStream << "@" << name << " = private alias [" << count << " x i8], getelementptr inbounds (" << objTy
+                    << ", ptr @" << staticStrObject(name) << ", i32 0, i32 7)\n";
         }
 
         // Emit lightweight debug metadata at end of module
@@ -7409,11 +8138,13 @@ namespace pycc::codegen {
         irStream << "!" << diDoubleId << " = !DIBasicType(name: \"double\", size: 64, encoding: DW_ATE_float)\n";
         irStream << "!" << diPtrId << " = !DIBasicType(name: \"ptr\", size: 64, encoding: DW_ATE_unsigned)\n";
         irStream << "!" << diExprId << " = !DIExpression()\n";
+        // Subprograms need a type for DWARF emission; parameters are described by their variables
+        irStream << "!" << diSubTyId << " = !DISubroutineType(types: !{})\n";
         for (const auto &ds: dbgSubs) {
             irStream << "!" << ds.id << " = distinct !DISubprogram(name: \"" << ds.name
                     << "\", linkageName: \"" << ds.name
                     << "\", scope: !1, file: !1, line: " << ds.line << ", scopeLine: " << ds.line
-                    << ", unit: !0, spFlags: DISPFlagDefinition)\n";
+                    << ", type: !" << diSubTyId << ", unit: !0, spFlags: DISPFlagDefinition)\n";
         }
         for (const auto &dv: dbgVars) {
             irStream << "!" << dv.id << " = !DILocalVariable(name: \"" << dv.name << "\", scope: !" << dv.scope
@@ -7425,6 +8156,11 @@ namespace pycc::codegen {
             irStream << "!" << dl.id << " = !DILocation(line: " << dl.line << ", column: " << dl.col << ", scope: !" <<
                     dl.scope << ")\n";
         }
+        // Without a debug info version LLVM drops all of the above, and heap profiles and
+        // backtraces of compiled programs could not be mapped back to source lines
+        irStream << "!llvm.module.flags = !{!" << nextDbgId << ", !" << (nextDbgId + 1) << "}\n";
+        irStream << "!" << nextDbgId << " = !{i32 2, !\"Debug Info Version\", i32 3}\n";
+        irStream << "!" << (nextDbgId + 1) << " = !{i32 7, !\"Dwarf Version\", i32 5}\n";
         // NOLINTEND
         return irStream.str();
     }
@@ -663,11 +663,26 @@ namespace pycc {
             metrics.setGauge("rt.bytes_live", st.bytesLive);
             metrics.setGauge("rt.bytes_allocated", st.bytesAllocated);
             metrics.setCounter("rt.collections", st.numCollections);
+            metrics.setCounter("rt.collections_minor", st.numMinorCollections);
+            metrics.setCounter("rt.collections_major", st.numMajorCollections);
             // Store telemetry as integer gauges for stability in JSON
             metrics.setGauge("rt.alloc_rate_bps",
                              static_cast<uint64_t>(telem.allocRateBytesPerSec >= 0 ? telem.allocRateBytesPerSec : 0.0));
             metrics.setGauge("rt.pressure_ppm",
                              static_cast<uint64_t>((telem.pressure >= 0 ? telem.pressure : 0.0) * 1000000.0));
+            // GC timing percentiles (ns) for pause SLOs and threshold tuning
+            const auto setTimings = [&](const std::string &prefix, const rt::GcPauseSummary &sum) {
+                metrics.setCounter(prefix + "_count", sum.count);
+                metrics.setGauge(prefix + "_p50_ns", sum.p50Ns);
+                metrics.setGauge(prefix + "_p90_ns", sum.p90Ns);
+                metrics.setGauge(prefix + "_p99_ns", sum.p99Ns);
+                metrics.setGauge(prefix + "_max_ns", sum.maxNs);
+            };
+            setTimings("rt.gc_pause", telem.pause);
+            setTimings("rt.gc_mark", telem.mark);
+            setTimings("rt.gc_sweep", telem.sweep);
+            metrics.setGauge("rt.gc_trigger_bytes", telem.triggerBytes);
+            metrics.setGauge("rt.gc_heap_goal_bytes", telem.heapGoalBytes);
         }
 
         if (logsEnabled) {
@@ -1,5 +1,6 @@
 // SPDX-License-Identifier: MIT
-// ElideGCBarrierPass: Remove calls to pycc_gc_write_barrier for stack (alloca) writes.
+// ElideGCBarrierPass: Remove calls to pycc_gc_write_barrier (or its inline fast path,
+// pycc_gc_store_barrier, when run before inlining) for stack (alloca) writes.
 
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/IR/Function.h"
@@ -51,7 +52,7 @@ struct ElideGCBarrierPass : public PassInfoMixin<ElideGCBarrierPass> {
       if (!CB) continue;
       Function *Callee = CB->getCalledFunction();
       if (!Callee) continue; // skip indirect
-      if (Callee->getName() != "pycc_gc_write_barrier") continue;
+      if (Callee->getName() != "pycc_gc_write_barrier" && Callee->getName() != "pycc_gc_store_barrier") continue;
       if (CB->arg_size() < 1) continue;
       Value *Addr = CB->getArgOperand(0);
       if (originatesFromAlloca(Addr)) {
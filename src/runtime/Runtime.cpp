@@ -3,6 +3,7 @@
  * Purpose: Minimal precise mark-sweep GC and string objects.
  */
 #include "runtime/All.h"
+#include "runtime/c_api.h"
 #include "runtime/detail/JsonTypes.h"
 #include "runtime/detail/JsonHandlers.h"
 #include "runtime/detail/RuntimeIntrospection.h"
@@ -13,6 +14,7 @@
 #include "runtime/detail/ArgparseHandlers.h"
 #include <algorithm>
 #include <atomic>
+#include <bit>
 #include <chrono>
 #include <cinttypes>
 #include <condition_variable>
@@ -20,7 +22,9 @@
 #include <cstdint>
 #include <cstring>
 #include <deque>
+#include <memory>
 #include <mutex>
+#include <new>
 #include <optional>
 #ifdef PYCC_WITH_ICU
 #include <unicode/uchar.h>
@@ -38,23 +42,33 @@
 #include <cstdlib>
 #include <cstring>
 #include <cerrno>
+#include <execinfo.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #if defined(__APPLE__) || defined(__linux__) || defined(__unix__)
 #include <sys/utsname.h>
 #endif
 #include <unistd.h>
+#include <sys/mman.h>
 #include <filesystem>
 #include <system_error>
 #include <cmath>
 #include <random>
 
+// Head of the calling thread's LLVM shadow stack; compiled modules carry a linkonce
+// thread_local copy that resolves to this one.
+extern "C" {
+thread_local pycc_gc_stack_entry* llvm_gc_root_chain = nullptr; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+uint8_t pycc_gc_marking = 0; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables) mirrors GCPhase::Mark for compiled barriers
+uint8_t pycc_gc_safepoint_requested = 0; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables) polled by compiled loops
+}
+
 namespace pycc::rt {
 
 // GC and runtime tuning constants
 static constexpr std::size_t kDefaultListCapacity = 4;
-static constexpr uint64_t kDefaultThresholdBytes = 1ULL << 20U;
-static constexpr std::size_t kStackSliceWords = 1024;
+static constexpr uint64_t kDefaultThresholdBytes = 1ULL << 20U; // minimum major trigger
+static constexpr int kDefaultGcPercent = 100;
 static constexpr uint64_t kMinLockHoldNs = 2000;
 static constexpr uint64_t kSliceIncrementUs = 100;
 static constexpr uint64_t kMaxSliceUs = 5000;
@@ -71,24 +85,63 @@ static constexpr std::size_t kBatchLowerTrigger = 64;
 static constexpr std::size_t kBatchDecrement = 16;
 static constexpr std::size_t kBatchDefault = 32;
 
+// One 8-byte word per object. Mark bits live in side bitmaps of the object's span and the
+// heap is walked through span metadata, so the header carries no mark word or list link.
 struct ObjectHeader {
-  uint32_t mark{0};
-  uint32_t tag{0};
-  std::size_t size{0}; // total allocation size including header
-  uint8_t gen{0};      // 0 = young, 1 = old
-  uint8_t age{0};      // survival count in young gen
-  uint16_t pad{0};
-  ObjectHeader* next{nullptr};
+  uint8_t tag{0};    // TypeTag; 0 marks a free slot
+  uint8_t gen{0};    // 0 = young, 1 = old
+  uint8_t age{0};    // survival count in young gen
+  uint8_t flags{0};  // kFlag* bits
+  uint32_t size{0};  // total allocation size including header (large spans keep the exact figure)
 };
-
-struct StringPayload { std::size_t len{}; /* char data[] follows */ };
+static_assert(sizeof(ObjectHeader) == 8U, "object header must stay one word");
+
+// Header flag: object is already queued in the remembered set
+static constexpr uint8_t kFlagRemembered = 1U;
+// Header flag: object was evacuated by compaction; its first payload word holds the new address
+static constexpr uint8_t kFlagForwarded = 2U;
+// Header flag: object was picked by the heap profiler and counts as in use at its site
+static constexpr uint8_t kFlagSampled = 4U;
+// kFlagImmortal (runtime/StaticString.h) marks objects outside the heap, which no span maps:
+// compiled string constants and interned strings.
+
+// Immediate values live in the pointer itself and have no header. Heap payloads start one
+// word into a 16-byte granule, so their low three bits are clear; an odd value is a 63-bit
+// int (value << 1 | 1) and 0b010 a bool with its value in bit 3. None stays nullptr.
+static constexpr uintptr_t kImmediateMask = 7U;
+static constexpr uintptr_t kImmediateInt = 1U;
+static constexpr uintptr_t kImmediateBool = 2U;
+static constexpr uintptr_t kImmediateBoolValue = 8U;
+
+bool is_immediate(const void* value) { return (reinterpret_cast<uintptr_t>(value) & kImmediateMask) != 0U; } // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+
+static inline bool is_immediate_int(const void* value) { return (reinterpret_cast<uintptr_t>(value) & kImmediateInt) != 0U; } // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+
+// Type of any value: immediates by their bit pattern, heap objects by header tag.
+static inline TypeTag value_tag(const void* value) {
+  if (value == nullptr) { return TypeTag::Object; }
+  if (is_immediate(value)) { return is_immediate_int(value) ? TypeTag::Int : TypeTag::Bool; }
+  const auto* header = reinterpret_cast<const ObjectHeader*>(static_cast<const unsigned char*>(value) - sizeof(ObjectHeader)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  return static_cast<TypeTag>(header->tag);
+}
+
+struct StringPayload { std::size_t len{}; std::size_t hash{}; /* char data[] follows; hash is 0 until computed */ };
+static_assert(sizeof(ObjectHeader) + offsetof(StringPayload, hash) == offsetof(StaticStringObject<1>, hash) &&
+              sizeof(ObjectHeader) + sizeof(StringPayload) == offsetof(StaticStringObject<1>, data), "compiled string constants share the heap layout");
 struct BytesPayload  { std::size_t len{}; /* uint8_t data[] follows */ };
 struct ByteArrayPayload { std::size_t len{}; std::size_t cap{}; /* uint8_t data[] follows */ };
 
 static std::mutex g_mu; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
-static ObjectHeader* g_head = nullptr; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
 static std::vector<void**> g_roots; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
-static std::size_t g_threshold = kDefaultThresholdBytes; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+static std::size_t g_threshold = kDefaultThresholdBytes; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables) old-space bytes that trigger a major cycle
+// Heap pacer (g_mu): unless gc_set_threshold pinned g_threshold, it is recomputed after each
+// major collection from the live bytes left, the growth percentage or absolute heap target,
+// and the allocation expected while a background cycle runs.
+static bool g_threshold_pinned = false; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+static int g_gc_percent = kDefaultGcPercent; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables) < 0: no growth trigger
+static std::size_t g_heap_target = 0; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables) 0: goal from g_gc_percent
+static uint64_t g_live_after_major = 0; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+static std::size_t g_heap_goal = kDefaultThresholdBytes; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
 static bool g_conservative = false; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
 static RuntimeStats g_stats; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
 static std::atomic<bool> g_bg_enabled{true}; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
@@ -97,34 +150,171 @@ static std::condition_variable g_bg_cv; // NOLINT(cppcoreguidelines-avoid-non-co
 static std::mutex g_bg_mu; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
 static std::thread g_bg_thread; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
 static bool g_bg_started = false; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+static std::atomic<bool> g_bg_stop{false}; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables) set at process exit
 // Synchronous collection coordination (for gc_collect when background is enabled)
 static std::mutex g_gc_done_mu; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
 static std::condition_variable g_gc_done_cv; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
 static std::atomic<uint64_t> g_gc_completed_count{0}; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
 
-// Reserved for future phase tracking in background GC
-enum class GCPhase { Idle, Mark, Sweep };
-static ObjectHeader* g_sweep_cur = nullptr; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
-static ObjectHeader* g_sweep_prev = nullptr; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
-static std::uintptr_t* g_stack_scan_cur = nullptr; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
-static std::uintptr_t* g_stack_scan_end = nullptr; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
-static std::mutex g_rem_mu; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
-static std::vector<void*> g_remembered; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+// Background major cycle phase. Mark: roots are shaded and the gray worklist is drained in
+// time-budgeted slices between which mutators run; Sweep: old-space spans are swept in batches.
+enum class GCPhase : uint8_t { Idle, Mark, Sweep };
+static std::atomic<GCPhase> g_gc_phase{GCPhase::Idle}; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+struct HeapSpan;
+static std::vector<HeapSpan*> g_sweep_spans; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables) spans left to sweep (g_mu)
+static std::size_t g_sweep_next = 0; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables) next index into g_sweep_spans
+static std::size_t g_sweep_word = 0; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables) next bitmap word of that span
+
+// Phase changes go through here so the byte compiled code polls before its barrier call
+// (pycc_gc_marking) follows the phase; it is read without synchronization on the fast path.
+// Skipping the call outside Mark is sound because slots are only walked with their thread
+// stopped: the first slice stops the mutators after raising the byte, and the remark stops
+// them again and finishes marking before the byte drops, so no slot store made in between
+// escapes both the barrier and a stopped walk.
+static GCPhase set_gc_phase(GCPhase phase) {
+  std::atomic_ref<uint8_t>(pycc_gc_marking).store(phase == GCPhase::Mark ? 1U : 0U, std::memory_order_relaxed);
+  return g_gc_phase.exchange(phase, std::memory_order_relaxed);
+}
+static std::vector<void*> g_remembered; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables) barrier records handed to the collector (g_mu)
 static std::atomic<uint64_t> g_slice_us{kSliceDefaultUs}; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
 static std::atomic<std::size_t> g_sweep_batch{kBatchDefault}; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
 static std::atomic<uint64_t> g_last_bytes_alloc{0}; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
 static std::atomic<uint64_t> g_last_time_ms{0}; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
-static double g_ewma_alloc_rate = 0.0; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables) bytes/ms
+static double g_ewma_alloc_rate = 0.0; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables) bytes/ms (g_mu)
 static double g_ewma_pressure = 0.0;    // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+static double g_ewma_cycle_ms = 0.0; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables) background major cycle wall time (g_mu)
+static std::atomic<uint64_t> g_last_cycle_ns{0}; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables) set by the collector thread
 static std::atomic<int> g_barrier_mode{0}; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables) 0=incremental-update, 1=SATB
 static bool g_debug = (std::getenv("PYCC_RT_DEBUG") != nullptr); // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
 
+// Event tracing: each thread appends TraceEvents to a ring buffer only it writes, publishing
+// each record by advancing the ring's head, so recording takes no lock. trace_flush copies
+// the rings and drops records the writer may have overwritten meanwhile. Rings go back to a
+// pool when their thread exits and are reused by later threads; records keep the number
+// of the thread that wrote them.
+static constexpr std::size_t kTraceRingEvents = std::size_t{1} << 14U;
+
+struct TraceRing {
+  std::array<TraceEvent, kTraceRingEvents> events{};
+  std::atomic<uint64_t> head{0}; // records ever written
+  uint64_t flushed{0};           // records already written out (g_trace_mu)
+  bool inUse{true};              // (g_trace_mu)
+};
+
+static std::mutex g_trace_mu; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables) ring pool and flushes
+static std::vector<std::unique_ptr<TraceRing>> g_trace_rings; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+static std::atomic<bool> g_trace_enabled{false}; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+static std::atomic<uint16_t> g_trace_threads{0}; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+static std::string g_trace_path; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables,cert-err58-cpp)
+
+// Plain thread_locals: one with a destructor at namespace scope would have the first trace
+// event of any thread (a background collector, say) construct every thread_local of this file,
+// t_mutator included.
+static thread_local TraceRing* t_trace_ring = nullptr; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+static thread_local uint16_t t_trace_number = 0; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+static thread_local bool t_trace_exited = false; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables) ring handed back
+
+// Hands the thread's ring back to the pool on exit; later events of the thread are dropped.
+struct TraceRingRelease {
+  TraceRingRelease() = default;
+  ~TraceRingRelease() {
+    const std::lock_guard<std::mutex> lock(g_trace_mu);
+    t_trace_ring->inUse = false;
+    t_trace_ring = nullptr;
+    t_trace_exited = true;
+  }
+  TraceRingRelease(const TraceRingRelease&) = delete;
+  TraceRingRelease& operator=(const TraceRingRelease&) = delete;
+  TraceRingRelease(TraceRingRelease&&) = delete;
+  TraceRingRelease& operator=(TraceRingRelease&&) = delete;
+};
+
+static uint64_t trace_now_ns() {
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+[[gnu::noinline]] static void trace_record(TraceKind kind, TracePhase phase, uint32_t arg) {
+  TraceRing* ring = t_trace_ring;
+  if (ring == nullptr) {
+    if (t_trace_exited) { return; }
+    {
+      const std::lock_guard<std::mutex> lock(g_trace_mu);
+      const auto it = std::find_if(g_trace_rings.begin(), g_trace_rings.end(), [](const auto& r) { return !r->inUse; });
+      ring = it != g_trace_rings.end() ? it->get() : g_trace_rings.emplace_back(std::make_unique<TraceRing>()).get();
+      ring->inUse = true;
+      t_trace_ring = ring;
+      t_trace_number = static_cast<uint16_t>(g_trace_threads.fetch_add(1U, std::memory_order_relaxed) + 1U);
+    }
+    thread_local TraceRingRelease release;
+  }
+  const uint64_t head = ring->head.load(std::memory_order_relaxed);
+  ring->events[head % kTraceRingEvents] = TraceEvent{trace_now_ns(), arg, t_trace_number, kind, phase};
+  ring->head.store(head + 1U, std::memory_order_release);
+}
+
+static inline void trace_event(TraceKind kind, TracePhase phase, uint32_t arg = 0) {
+  if (g_trace_enabled.load(std::memory_order_relaxed)) [[unlikely]] { trace_record(kind, phase, arg); }
+}
+
+// Begin/end pair around a scope; the end is recorded even if tracing stopped in between.
+class TraceScope {
+public:
+  explicit TraceScope(TraceKind kind) : kind_(kind), active_(g_trace_enabled.load(std::memory_order_relaxed)) {
+    if (active_) { trace_record(kind_, TracePhase::Begin, 0); }
+  }
+  ~TraceScope() { if (active_) { trace_record(kind_, TracePhase::End, 0); } }
+  TraceScope(const TraceScope&) = delete;
+  TraceScope& operator=(const TraceScope&) = delete;
+  TraceScope(TraceScope&&) = delete;
+  TraceScope& operator=(TraceScope&&) = delete;
+private:
+  TraceKind kind_;
+  bool active_;
+};
+
+static bool write_trace(const char* path) {
+  std::vector<TraceEvent> events;
+  {
+    const std::lock_guard<std::mutex> lock(g_trace_mu);
+    for (const auto& ring : g_trace_rings) {
+      const uint64_t head = ring->head.load(std::memory_order_acquire);
+      const uint64_t first = std::max(ring->flushed, head > kTraceRingEvents ? head - kTraceRingEvents : 0U);
+      const std::size_t mark = events.size();
+      for (uint64_t i = first; i < head; ++i) { events.push_back(ring->events[i % kTraceRingEvents]); }
+      // Slots the writer reused while they were copied hold newer records: drop those
+      const uint64_t after = ring->head.load(std::memory_order_acquire);
+      const uint64_t stale = after > kTraceRingEvents + first ? std::min(after - kTraceRingEvents - first, head - first) : 0U;
+      events.erase(events.begin() + static_cast<std::ptrdiff_t>(mark), events.begin() + static_cast<std::ptrdiff_t>(mark + stale));
+      ring->flushed = head;
+    }
+  }
+  std::stable_sort(events.begin(), events.end(), [](const TraceEvent& a, const TraceEvent& b) { return a.timeNs < b.timeNs; });
+  std::FILE* out = std::fopen(path, "wb");
+  if (out == nullptr) { return false; }
+  TraceFileHeader header;
+  header.count = events.size();
+  bool ok = std::fwrite(&header, sizeof(header), 1, out) == 1;
+  ok = ok && (events.empty() || std::fwrite(events.data(), sizeof(TraceEvent), events.size(), out) == events.size());
+  return std::fclose(out) == 0 && ok;
+}
+
+// PYCC_RT_TRACE=<path> records from startup and writes the trace there at exit.
+[[maybe_unused]] static const bool g_trace_from_env = [] { // NOLINT(cert-err58-cpp)
+  const char* path = std::getenv("PYCC_RT_TRACE");
+  if (path == nullptr || *path == '\0') { return false; }
+  g_trace_path = path;
+  g_trace_enabled.store(true, std::memory_order_relaxed);
+  std::atexit([] { (void)write_trace(g_trace_path.c_str()); });
+  return true;
+}();
+static std::atomic<bool> g_major_requested{false}; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+static bool g_minor_marking = false; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables) old objects are implicitly live
+
 // Segregated free lists for small object sizes (total bytes including header)
-static constexpr std::size_t kClassSizes[] = { 64, 128, 256, 512, 1024, 2048, 4096 };
+static constexpr std::size_t kClassSizes[] = { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
 static constexpr int kNumClasses = static_cast<int>(sizeof(kClassSizes) / sizeof(kClassSizes[0]));
 static std::vector<ObjectHeader*> g_free_lists[kNumClasses]; // NOLINT
-// Thread-local caches for segregated size classes. Mutators steal batches from global lists.
-static thread_local std::vector<ObjectHeader*> t_free_lists[kNumClasses]; // NOLINT
+// Mutators steal batches from the global lists into caches of their own (MutatorState::freeCache).
 static constexpr std::size_t kStealBatch = 16;
 
 static inline int class_index_for(std::size_t total) {
@@ -132,10 +322,648 @@ static inline int class_index_for(std::size_t total) {
   return -1;
 }
 
+// Address-indexed heap: small objects are carved from per-class spans and large
+// objects get mappings of their own, listed in g_large_spans and unmapped when they
+// die. Every heap page is registered in a two-level radix map so any interior pointer
+// resolves to its header and span in O(1).
+//
+// Span metadata also replaces per-object list links and mark words: small spans and
+// nursery chunks keep one start bit per kGranule for each allocated object and a
+// parallel mark bitmap, so sweeping scans bitmaps instead of chasing pointers.
+static constexpr unsigned kPageShift = 12U;
+static constexpr std::size_t kPageBytes = std::size_t{1} << kPageShift;
+static constexpr std::size_t kSpanBytes = std::size_t{64} << 10U;
+static constexpr unsigned kAddrBits = 48U;
+static constexpr unsigned kRadixLeafBits = 18U;
+static constexpr unsigned kRadixRootBits = kAddrBits - kPageShift - kRadixLeafBits;
+static constexpr std::size_t kRadixLeafEntries = std::size_t{1} << kRadixLeafBits;
+static constexpr std::size_t kRadixRootEntries = std::size_t{1} << kRadixRootBits;
+
+static constexpr std::size_t kGranule = 16;
+static constexpr std::size_t kGranulesPerChunk = kSpanBytes / kGranule;
+static constexpr std::size_t kBitmapWords = kGranulesPerChunk / 64U;
+
+enum class SpanKind : uint8_t { Small, Large, Nursery };
+
+struct LocalHeap;
+struct HeapArena;
+
+struct HeapSpan {
+  unsigned char* base{nullptr};
+  std::size_t bytes{0};    // span length (multiple of kPageBytes)
+  std::size_t slotSize{0}; // size-class slot (power of two); Small spans only
+  int classIndex{-1};
+  SpanKind kind{SpanKind::Small};
+  std::size_t objectBytes{0}; // Large spans: exact size of their object
+  // Nursery chunks: bump cursor and live object count
+  std::size_t cursor{0};
+  std::size_t live{0};
+  bool retired{false}; // holds promoted survivors; recycled once they all die
+  bool sweepPending{false}; // queued for the background sweep and not yet reached
+  std::vector<uint64_t> starts; // one bit per granule where an allocated object begins (not Large)
+  std::vector<uint64_t> marks;  // mark bit per object, at its first granule (one word for Large)
+  uint32_t releasedPages{0}; // pages handed back by the scavenger (one bit per kPageBytes)
+  LocalHeap* owner{nullptr}; // set for spans of an rt_spawn thread's private heap
+  HeapArena* arena{nullptr}; // reservation the span was carved from (not Large)
+  // Compaction, within one collection: referenced from a scanned stack, or being emptied
+  bool pinned{false};
+  bool evacuating{false};
+};
+
+static HeapSpan** g_page_map[kRadixRootEntries]; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+static std::mutex g_page_map_mu; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables) leaf creation; thread-local heaps map spans without g_mu
+static std::vector<HeapSpan*> g_spans; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables) small-class spans
+static std::vector<HeapSpan*> g_large_spans; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables) large-object space
+
+static inline HeapSpan* span_for_address(const void* ptr) {
+  const std::uintptr_t page = reinterpret_cast<std::uintptr_t>(ptr) >> kPageShift; // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+  const std::uintptr_t root = page >> kRadixLeafBits;
+  if (root >= kRadixRootEntries) { return nullptr; }
+  // Write barriers look pages up without g_mu while refills register new spans
+  HeapSpan** leaf = std::atomic_ref<HeapSpan**>(g_page_map[root]).load(std::memory_order_acquire);
+  if (leaf == nullptr) { return nullptr; }
+  return std::atomic_ref<HeapSpan*>(leaf[page & (kRadixLeafEntries - 1U)]).load(std::memory_order_acquire); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+}
+
+static void page_map_assign(const unsigned char* base, std::size_t bytes, HeapSpan* span) {
+  const std::uintptr_t first = reinterpret_cast<std::uintptr_t>(base) >> kPageShift; // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+  const std::uintptr_t last = first + (bytes >> kPageShift);
+  for (std::uintptr_t page = first; page < last; ++page) {
+    HeapSpan** leaf = std::atomic_ref<HeapSpan**>(g_page_map[page >> kRadixLeafBits]).load(std::memory_order_acquire);
+    if (leaf == nullptr) {
+      const std::lock_guard<std::mutex> lock(g_page_map_mu);
+      leaf = g_page_map[page >> kRadixLeafBits];
+      if (leaf == nullptr) {
+        // calloc keeps untouched leaf pages lazily zero-mapped
+        leaf = static_cast<HeapSpan**>(std::calloc(kRadixLeafEntries, sizeof(HeapSpan*)));
+        if (leaf == nullptr) { throw std::bad_alloc(); }
+        std::atomic_ref<HeapSpan**>(g_page_map[page >> kRadixLeafBits]).store(leaf, std::memory_order_release);
+      }
+    }
+    std::atomic_ref<HeapSpan*>(leaf[page & (kRadixLeafEntries - 1U)]).store(span, std::memory_order_release); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  }
+}
+
+// Heap arenas: small-class spans and nursery chunks are carved from 2 MiB reservations
+// aligned to 2 MiB, which the kernel may back with one transparent huge page each
+// (MADV_HUGEPAGE), so tracing through List and Dict payloads misses the dTLB less often.
+// Large objects keep mappings of their own. A span given back returns its slot to the
+// arena, zeroed when handed out again; an arena with no spans left is unmapped.
+// PYCC_GC_HUGE_PAGES=0 or gc_set_huge_pages(false) leaves new arenas on base pages.
+static constexpr std::size_t kArenaBytes = std::size_t{2} << 20U;
+static constexpr std::size_t kSpansPerArena = kArenaBytes / kSpanBytes;
+static_assert(kSpansPerArena == 32U, "arena slot masks are 32 bits wide");
+
+struct HeapArena {
+  unsigned char* base{nullptr};
+  uint32_t used{0};  // one bit per span slot handed out
+  uint32_t dirty{0}; // slots whose memory held a span before
+  bool hugePages{false}; // MADV_HUGEPAGE accepted
+};
+
+static std::mutex g_arena_mu; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables) thread-local heaps take spans without g_mu
+static std::vector<HeapArena*> g_arenas; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+static std::atomic<bool> g_huge_pages{true}; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+static std::atomic<uint64_t> g_arena_bytes{0}; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+static std::atomic<uint64_t> g_huge_page_bytes{0}; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+
+// Over-reserve by one arena and trim, so the kept range starts on a 2 MiB boundary.
+static HeapArena* arena_reserve() {
+  void* mem = ::mmap(nullptr, kArenaBytes * 2U, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0); // NOLINT(hicpp-signed-bitwise)
+  if (mem == MAP_FAILED) { throw std::bad_alloc(); } // NOLINT(cppcoreguidelines-pro-type-cstyle-cast,performance-no-int-to-ptr)
+  auto* raw = static_cast<unsigned char*>(mem);
+  const std::uintptr_t addr = reinterpret_cast<std::uintptr_t>(raw); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+  const std::size_t lead = ((addr + kArenaBytes - 1U) & ~(kArenaBytes - 1U)) - addr;
+  if (lead != 0U) { ::munmap(raw, lead); }
+  ::munmap(raw + lead + kArenaBytes, kArenaBytes - lead); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  auto* arena = new HeapArena{};
+  arena->base = raw + lead; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  g_arena_bytes.fetch_add(kArenaBytes, std::memory_order_relaxed);
+  if (g_huge_pages.load(std::memory_order_relaxed) && ::madvise(arena->base, kArenaBytes, MADV_HUGEPAGE) == 0) {
+    arena->hugePages = true;
+    g_huge_page_bytes.fetch_add(kArenaBytes, std::memory_order_relaxed);
+  }
+  return arena;
+}
+
+static unsigned char* arena_take_span(HeapArena*& from) {
+  const std::lock_guard<std::mutex> lock(g_arena_mu);
+  // Newer arenas fill first; older ones regain slots as their spans are freed
+  auto it = std::find_if(g_arenas.rbegin(), g_arenas.rend(), [](const HeapArena* arena) { return arena->used != UINT32_MAX; });
+  HeapArena* arena = it != g_arenas.rend() ? *it : g_arenas.emplace_back(arena_reserve());
+  const auto slot = static_cast<unsigned>(std::countr_one(arena->used));
+  const uint32_t bit = 1U << slot;
+  unsigned char* base = arena->base + (slot * kSpanBytes); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  arena->used |= bit;
+  if ((arena->dirty & bit) != 0U) { std::memset(base, 0, kSpanBytes); }
+  from = arena;
+  return base;
+}
+
+static void arena_return_span(HeapArena* arena, const unsigned char* base) {
+  const std::lock_guard<std::mutex> lock(g_arena_mu);
+  const uint32_t bit = 1U << (static_cast<std::size_t>(base - arena->base) / kSpanBytes);
+  arena->used &= ~bit;
+  arena->dirty |= bit;
+  if (arena->used != 0U) { return; }
+  std::erase(g_arenas, arena);
+  ::munmap(arena->base, kArenaBytes);
+  g_arena_bytes.fetch_sub(kArenaBytes, std::memory_order_relaxed);
+  if (arena->hugePages) { g_huge_page_bytes.fetch_sub(kArenaBytes, std::memory_order_relaxed); }
+  delete arena;
+}
+
+static HeapSpan* span_new_locked(std::size_t bytes, SpanKind kind, std::size_t slotSize, int classIndex, LocalHeap* owner = nullptr) {
+  HeapArena* arena = nullptr;
+  unsigned char* base = nullptr;
+  if (kind != SpanKind::Large) {
+    base = arena_take_span(arena);
+  } else {
+    void* mem = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0); // NOLINT(hicpp-signed-bitwise)
+    if (mem == MAP_FAILED) { throw std::bad_alloc(); } // NOLINT(cppcoreguidelines-pro-type-cstyle-cast,performance-no-int-to-ptr)
+    base = static_cast<unsigned char*>(mem);
+  }
+  auto* span = new HeapSpan{};
+  span->base = base; span->bytes = bytes; span->kind = kind; span->arena = arena;
+  span->slotSize = slotSize; span->classIndex = classIndex; span->owner = owner;
+  if (kind != SpanKind::Large) { span->starts.assign(kBitmapWords, 0U); }
+  span->marks.assign(kind == SpanKind::Large ? 1U : kBitmapWords, 0U);
+  page_map_assign(base, bytes, span);
+  return span;
+}
+
+static void span_delete_locked(HeapSpan* span) {
+  page_map_assign(span->base, span->bytes, nullptr);
+  if (span->arena != nullptr) { arena_return_span(span->arena, span->base); }
+  else { ::munmap(span->base, span->bytes); }
+  delete span;
+}
+
+// Bit of an object's first granule in its span's start and mark bitmaps.
+static inline std::size_t granule_of(const HeapSpan* span, const ObjectHeader* header) {
+  return static_cast<std::size_t>(reinterpret_cast<const unsigned char*>(header) - span->base) / kGranule; // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+}
+
+static inline uint64_t granule_bit(std::size_t granule) { return uint64_t{1} << (granule % 64U); }
+
+static inline bool is_marked(const HeapSpan* span, const ObjectHeader* header) {
+  const std::size_t granule = granule_of(span, header);
+  return (span->marks[granule / 64U] & granule_bit(granule)) != 0U;
+}
+
+static inline void set_mark(HeapSpan* span, const ObjectHeader* header) {
+  const std::size_t granule = granule_of(span, header);
+  span->marks[granule / 64U] |= granule_bit(granule);
+}
+
+// Parallel markers race for the same bit; true when this caller set it.
+static inline bool claim_mark_atomic(HeapSpan* span, const ObjectHeader* header) {
+  const std::size_t granule = granule_of(span, header);
+  const uint64_t bit = granule_bit(granule);
+  return (std::atomic_ref<uint64_t>(span->marks[granule / 64U]).fetch_or(bit, std::memory_order_relaxed) & bit) == 0U;
+}
+
+// Large objects may outgrow the 32-bit header size; their span keeps the exact figure.
+static inline std::size_t object_size(const HeapSpan* span, const ObjectHeader* header) {
+  return span->kind == SpanKind::Large ? span->objectBytes : header->size;
+}
+
+// Push the slots of a fresh small span onto a free list (lowest addresses handed out first).
+static void push_span_slots(HeapSpan* span, std::vector<ObjectHeader*>& freeList) {
+  const std::size_t slot = span->slotSize;
+  for (std::size_t off = kSpanBytes; off >= slot; off -= slot) {
+    auto* header = reinterpret_cast<ObjectHeader*>(span->base + (off - slot)); // NOLINT
+    *header = ObjectHeader{}; // tag 0 marks a free slot
+    freeList.push_back(header);
+  }
+}
+
+// Carve a fresh span into free slots for class ci.
+static void carve_span_locked(int ci) {
+  HeapSpan* span = span_new_locked(kSpanBytes, SpanKind::Small, kClassSizes[ci], ci);
+  g_spans.push_back(span);
+  push_span_slots(span, g_free_lists[ci]);
+}
+
+// Thread-local heaps. A thread started by rt_spawn allocates from a private heap of its own
+// spans and collects it on that thread, from the roots it registered plus a conservative scan
+// of its own stack: no g_mu, no CollectorLock, and nothing for the global collector to stop.
+// Lookups only resolve spans of the calling thread's heap, so neither collector ever traces
+// into the other's objects. Channels keep the heaps disjoint: chan_send copies an immutable
+// value into the shared message heap (plain malloc, outside every page map), and chan_recv
+// moves it into the receiver's heap and frees it.
+static void profile_forget_heap(const LocalHeap* heap);
+
+struct LocalHeap {
+  std::array<std::vector<ObjectHeader*>, kNumClasses> freeLists;
+  std::vector<HeapSpan*> spans; // small-class spans
+  std::vector<HeapSpan*> largeSpans;
+  std::vector<void**> roots; // gc_register_root calls made on the owning thread
+  std::vector<ObjectHeader*> markStack;
+  const std::uintptr_t* stackTop{nullptr}; // above every frame of the thread's entry function
+  std::size_t bytesLive{0};
+  std::size_t trigger{kDefaultThresholdBytes};
+  LocalHeap() = default;
+  ~LocalHeap() {
+    profile_forget_heap(this);
+    for (HeapSpan* span : spans) { span_delete_locked(span); }
+    for (HeapSpan* span : largeSpans) { span_delete_locked(span); }
+  }
+  LocalHeap(const LocalHeap&) = delete;
+  LocalHeap& operator=(const LocalHeap&) = delete;
+  LocalHeap(LocalHeap&&) = delete;
+  LocalHeap& operator=(LocalHeap&&) = delete;
+};
+
+static thread_local LocalHeap* t_local_heap = nullptr; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables) set on rt_spawn threads
+static std::atomic<uint64_t> g_local_collections{0}; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+static std::atomic<uint64_t> g_published{0}; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+
+// Young generation: objects up to the largest size class are bump-allocated into
+// nursery chunks. Minor collections trace from roots plus the remembered set,
+// promote survivors in place (gen=1) and recycle chunks whose young objects all died.
+// Chunks holding survivors are retired, and swept as old space, until those die too.
+static constexpr std::size_t kDefaultNurseryBytes = std::size_t{1} << 20U;
+static std::vector<HeapSpan*> g_nursery_full; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables) filled, awaiting collection
+static std::vector<HeapSpan*> g_nursery_free; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables) empty, ready for reuse
+static std::vector<HeapSpan*> g_nursery_all; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables) every chunk, in any state
+static std::size_t g_nursery_chunks = kDefaultNurseryBytes / kSpanBytes; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+static std::size_t g_nursery_tlabs = 0; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables) chunks currently owned as a thread's TLAB
+static std::atomic<bool> g_nursery_enabled{true}; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+static bool g_minor_pending = false; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+static uint64_t g_young_bytes = 0; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables) live bytes still in the nursery
+
+static void nursery_chunk_reset(HeapSpan* chunk) {
+  chunk->cursor = 0; chunk->live = 0; chunk->retired = false; chunk->sweepPending = false;
+  std::fill(chunk->starts.begin(), chunk->starts.end(), 0U);
+  std::fill(chunk->marks.begin(), chunk->marks.end(), 0U);
+}
+
+// Hand out an empty nursery chunk to become a thread's TLAB; nullptr once the nursery
+// budget is used up, in which case a minor collection is requested and the caller pretenures.
+static HeapSpan* nursery_take_chunk_locked() {
+  if (g_nursery_full.size() + g_nursery_tlabs >= g_nursery_chunks) {
+    g_minor_pending = true;
+    return nullptr;
+  }
+  HeapSpan* chunk = nullptr;
+  if (!g_nursery_free.empty()) {
+    chunk = g_nursery_free.back(); g_nursery_free.pop_back();
+    chunk->releasedPages = 0; // refaulted on demand
+  } else {
+    chunk = span_new_locked(kSpanBytes, SpanKind::Nursery, 0, -1);
+    g_nursery_all.push_back(chunk);
+  }
+  ++g_nursery_tlabs;
+  return chunk;
+}
+
+// Bump-allocate from a TLAB chunk. Only the owning thread writes the cursor and start bits;
+// write barriers on other threads may read them, hence the atomic (but uncontended) stores.
+static inline unsigned char* tlab_bump(HeapSpan* chunk, std::size_t total) {
+  const std::size_t bytes = (total + kGranule - 1U) & ~(kGranule - 1U);
+  const std::size_t off = chunk->cursor;
+  if (off + bytes > chunk->bytes) { return nullptr; }
+  uint64_t& word = chunk->starts[(off / kGranule) / 64U];
+  std::atomic_ref<uint64_t>(word).store(word | (uint64_t{1} << ((off / kGranule) % 64U)), std::memory_order_relaxed);
+  std::atomic_ref<std::size_t>(chunk->cursor).store(off + bytes, std::memory_order_release);
+  chunk->live++;
+  return chunk->base + off; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+}
+
+// Start offset of the nursery object covering offset, or kSpanBytes when none.
+static std::size_t nursery_object_start(HeapSpan* chunk, std::size_t offset) {
+  if (offset >= std::atomic_ref<std::size_t>(chunk->cursor).load(std::memory_order_acquire)) { return kSpanBytes; }
+  std::size_t word = (offset / kGranule) / 64U;
+  const unsigned bit = static_cast<unsigned>((offset / kGranule) % 64U);
+  const auto loadWord = [chunk](std::size_t w) { return std::atomic_ref<uint64_t>(chunk->starts[w]).load(std::memory_order_relaxed); };
+  uint64_t bits = loadWord(word) & (bit == 63U ? ~uint64_t{0} : ((uint64_t{1} << (bit + 1U)) - 1U));
+  while (bits == 0U) {
+    if (word == 0U) { return kSpanBytes; }
+    bits = loadWord(--word);
+  }
+  return ((word * 64U) + (63U - static_cast<std::size_t>(std::countl_zero(bits)))) * kGranule;
+}
+
 // Thread-local exception state
 static thread_local void* t_last_exception = nullptr; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
 static thread_local bool t_exc_root_registered = false; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
 
+// Mutator/collector handshake. Allocation entry points run inside a MutatorScope: the
+// fast path merely flags its thread's MutatorState as busy and bump-allocates from that
+// thread's TLAB (a nursery chunk it owns) without touching g_mu. TLAB refills, old-space
+// allocation and collections synchronize on g_mu. A collector takes a CollectorLock: it
+// raises g_collectors_waiting, waits until no thread is inside a fast scope, then holds
+// g_mu; scopes opened while a collector waits fall back to holding g_mu themselves.
+//
+// Write barriers log into the calling thread's sequential store buffer, also inside a
+// MutatorScope and without locking. A full buffer is pushed onto g_full_store_buffers with
+// a CAS and replaced; the CollectorLock handshake moves the full buffers and every thread's
+// partial one into g_remembered.
+static constexpr std::size_t kStoreBufferEntries = 256;
+
+struct StoreBuffer {
+  StoreBuffer* next{nullptr}; // link in g_full_store_buffers
+  std::size_t len{0};
+  std::array<void*, kStoreBufferEntries> entries{};
+};
+
+static std::atomic<StoreBuffer*> g_full_store_buffers{nullptr}; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+
+struct MutatorState {
+  std::atomic<bool> inFastScope{false};
+  bool holdsLock{false}; // current scope fell back to g_mu
+  unsigned depth{0};
+  HeapSpan* tlab{nullptr};
+  // TLAB allocations not yet folded into g_stats (folded on refill and by collectors)
+  uint64_t numAllocated{0};
+  uint64_t bytesAllocated{0};
+  std::unique_ptr<StoreBuffer> ssb{std::make_unique<StoreBuffer>()};
+  std::array<std::vector<ObjectHeader*>, kNumClasses> freeCache; // slots stolen from g_free_lists
+  // Safepoint handshake: the top of the thread's stack, and while parked the lowest address
+  // a collector has to scan (null while the thread runs)
+  const std::uintptr_t* stackHigh{nullptr};
+  std::atomic<const std::uintptr_t*> stackLow{nullptr};
+  pycc_gc_stack_entry** rootChain{nullptr}; // the thread's llvm_gc_root_chain
+};
+
+static std::mutex g_mutators_mu; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables) guards g_mutators
+static std::vector<MutatorState*> g_mutators; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+static std::atomic<unsigned> g_collectors_waiting{0}; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+
+static void fold_mutator_counters_locked(MutatorState& mutator) {
+  g_stats.numAllocated += mutator.numAllocated;
+  g_stats.bytesAllocated += mutator.bytesAllocated;
+  g_stats.bytesLive += mutator.bytesAllocated;
+  g_stats.peakBytesLive = std::max(g_stats.peakBytesLive, g_stats.bytesLive);
+  g_young_bytes += mutator.bytesAllocated;
+  mutator.numAllocated = 0;
+  mutator.bytesAllocated = 0;
+}
+
+static void store_buffer_record(MutatorState& self, void* value) {
+  StoreBuffer* buf = self.ssb.get();
+  buf->entries[buf->len++] = value;
+  if (buf->len < kStoreBufferEntries) { return; }
+  trace_event(TraceKind::BarrierFlush, TracePhase::Instant, static_cast<uint32_t>(kStoreBufferEntries));
+  buf->next = g_full_store_buffers.load(std::memory_order_relaxed);
+  while (!g_full_store_buffers.compare_exchange_weak(buf->next, buf, std::memory_order_release, std::memory_order_relaxed)) {}
+  (void)self.ssb.release();
+  self.ssb = std::make_unique<StoreBuffer>();
+}
+
+static void flush_store_buffer_locked(MutatorState& mutator) {
+  StoreBuffer& buf = *mutator.ssb;
+  if (buf.len != 0U) { trace_event(TraceKind::BarrierFlush, TracePhase::Instant, static_cast<uint32_t>(buf.len)); }
+  g_remembered.insert(g_remembered.end(), buf.entries.begin(), buf.entries.begin() + static_cast<std::ptrdiff_t>(buf.len));
+  buf.len = 0;
+}
+
+static void take_full_store_buffers_locked() {
+  StoreBuffer* buf = g_full_store_buffers.exchange(nullptr, std::memory_order_acquire);
+  while (buf != nullptr) {
+    const std::unique_ptr<StoreBuffer> owned(buf);
+    g_remembered.insert(g_remembered.end(), buf->entries.begin(), buf->entries.end());
+    buf = buf->next;
+  }
+}
+
+static void return_free_cache_locked(MutatorState& mutator) {
+  for (int ci = 0; ci < kNumClasses; ++ci) {
+    auto& cache = mutator.freeCache[static_cast<std::size_t>(ci)];
+    g_free_lists[ci].insert(g_free_lists[ci].end(), cache.begin(), cache.end());
+    cache.clear();
+  }
+}
+
+static void retire_tlab_locked(MutatorState& mutator) {
+  if (mutator.tlab == nullptr) { return; }
+  g_nursery_full.push_back(mutator.tlab);
+  mutator.tlab = nullptr;
+  --g_nursery_tlabs;
+}
+
+// Safepoints. A collector about to scan roots raises pycc_gc_safepoint_requested and waits
+// until every other registered mutator is parked: stopped at a poll in compiled code (or
+// gc_safepoint), blocked on g_mu at the start of a MutatorScope, or blocked in the runtime
+// (channel waits, joins, waiting for a collection). Parking spills the callee-saved registers
+// and publishes the stack pointer, so [stackLow, stackHigh) holds every pointer the thread
+// owns and its shadow-stack frames hold still; the thread stays parked until the collector
+// lowers the flag again.
+static std::mutex g_safepoint_mu; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+static std::condition_variable g_safepoint_cv; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+static thread_local MutatorState* t_self_state = nullptr; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables) set once the thread registers
+
+using StackRanges = std::vector<std::pair<const std::uintptr_t*, const std::uintptr_t*>>;
+static std::optional<std::pair<void*, void*>> get_stack_bounds_pair();
+static StackRanges stop_mutators_locked();
+static void resume_mutators();
+
+static inline bool safepoint_requested() {
+  return std::atomic_ref<uint8_t>(pycc_gc_safepoint_requested).load(std::memory_order_seq_cst) != 0U;
+}
+
+// Run block, which must not touch the heap, with the calling thread parked.
+template <typename Fn>
+[[gnu::noinline]] static void run_parked(MutatorState& self, Fn&& block) {
+#if defined(__GNUC__) || defined(__clang__)
+  __builtin_unwind_init(); // spill callee-saved registers into this frame
+#endif
+  std::uintptr_t marker = 0;
+  const TraceScope trace(TraceKind::SafepointPark);
+  self.stackLow.store(&marker, std::memory_order_seq_cst);
+  block();
+  for (;;) {
+    self.stackLow.store(nullptr, std::memory_order_seq_cst);
+    if (!safepoint_requested()) { return; }
+    // A stop may have found this thread parked and be scanning its stack: wait for it parked
+    self.stackLow.store(&marker, std::memory_order_seq_cst);
+    std::unique_lock<std::mutex> lock(g_safepoint_mu);
+    g_safepoint_cv.wait(lock, [] { return !safepoint_requested(); });
+  }
+}
+
+// Blocking runtime calls park their thread, so a stop never waits on a sleeping mutator.
+template <typename Fn>
+static void blocking_region(Fn&& block) {
+  if (MutatorState* self = t_self_state) { run_parked(*self, block); } else { block(); }
+}
+
+// g_mu taken by a mutator outside a MutatorScope: the holder may be a collector about to scan
+// this thread's stack, so wait for it parked.
+static void lock_parked() {
+  if (MutatorState* self = t_self_state) { run_parked(*self, [] { g_mu.lock(); }); } else { g_mu.lock(); }
+}
+
+// Registers each allocating thread; on thread exit its TLAB goes to the collector.
+struct MutatorRegistration {
+  MutatorState* state{new MutatorState{}};
+  MutatorRegistration() {
+    if (const auto bounds = get_stack_bounds_pair()) { state->stackHigh = static_cast<const std::uintptr_t*>(bounds->second); }
+    state->rootChain = &llvm_gc_root_chain;
+    t_self_state = state;
+    const std::lock_guard<std::mutex> lock(g_mutators_mu);
+    g_mutators.push_back(state);
+  }
+  ~MutatorRegistration() {
+    lock_parked();
+    const std::lock_guard<std::mutex> lock(g_mu, std::adopt_lock);
+    t_self_state = nullptr;
+    {
+      const std::lock_guard<std::mutex> mlock(g_mutators_mu);
+      g_mutators.erase(std::find(g_mutators.begin(), g_mutators.end(), state));
+    }
+    fold_mutator_counters_locked(*state);
+    flush_store_buffer_locked(*state);
+    retire_tlab_locked(*state);
+    return_free_cache_locked(*state);
+    delete state;
+  }
+  MutatorRegistration(const MutatorRegistration&) = delete;
+  MutatorRegistration& operator=(const MutatorRegistration&) = delete;
+  MutatorRegistration(MutatorRegistration&&) = delete;
+  MutatorRegistration& operator=(MutatorRegistration&&) = delete;
+};
+static thread_local MutatorRegistration t_mutator; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+
+// A thread with its own heap never meets a global collector, so its scopes are empty.
+class MutatorScope {
+public:
+  MutatorScope() : self_((t_local_heap == nullptr) ? t_mutator.state : nullptr) {
+    if (self_ == nullptr || self_->depth++ != 0U) { return; }
+    self_->inFastScope.store(true, std::memory_order_seq_cst);
+    if (g_collectors_waiting.load(std::memory_order_seq_cst) != 0U) {
+      self_->inFastScope.store(false, std::memory_order_release);
+      run_parked(*self_, [] { g_mu.lock(); }); // entering the runtime doubles as a safepoint
+      self_->holdsLock = true;
+    }
+  }
+  ~MutatorScope() {
+    if (self_ == nullptr || --self_->depth != 0U) { return; }
+    if (self_->holdsLock) {
+      self_->holdsLock = false;
+      g_mu.unlock();
+    } else {
+      self_->inFastScope.store(false, std::memory_order_release);
+    }
+  }
+  MutatorScope(const MutatorScope&) = delete;
+  MutatorScope& operator=(const MutatorScope&) = delete;
+  MutatorScope(MutatorScope&&) = delete;
+  MutatorScope& operator=(MutatorScope&&) = delete;
+private:
+  MutatorState* self_;
+};
+
+class CollectorLock {
+public:
+  CollectorLock() {
+    g_collectors_waiting.fetch_add(1U, std::memory_order_seq_cst);
+    {
+      const std::lock_guard<std::mutex> mlock(g_mutators_mu);
+      for (MutatorState* mutator : g_mutators) {
+        while (mutator->inFastScope.load(std::memory_order_seq_cst)) { std::this_thread::yield(); }
+      }
+    }
+    lock_parked();
+    const std::lock_guard<std::mutex> mlock(g_mutators_mu);
+    for (MutatorState* mutator : g_mutators) {
+      fold_mutator_counters_locked(*mutator);
+      flush_store_buffer_locked(*mutator);
+    }
+    take_full_store_buffers_locked();
+  }
+  ~CollectorLock() {
+    if (safepoint_requested()) { resume_mutators(); } // stopped by a root scan under this lock
+    g_mu.unlock();
+    g_collectors_waiting.fetch_sub(1U, std::memory_order_seq_cst);
+  }
+  CollectorLock(const CollectorLock&) = delete;
+  CollectorLock& operator=(const CollectorLock&) = delete;
+  CollectorLock(CollectorLock&&) = delete;
+  CollectorLock& operator=(CollectorLock&&) = delete;
+};
+
+// Lock-free log-linear histogram of durations in ns: exact below 16 ns, then eight sub-buckets
+// per power of two, so a reported percentile is at most 12.5% above the true value.
+class DurationHistogram {
+public:
+  void record(uint64_t ns) {
+    counts_[bucket_of(ns)].fetch_add(1U, std::memory_order_relaxed);
+    uint64_t prev = max_.load(std::memory_order_relaxed);
+    while (ns > prev && !max_.compare_exchange_weak(prev, ns, std::memory_order_relaxed)) {}
+  }
+  [[nodiscard]] GcPauseSummary summary() const {
+    std::array<uint64_t, kBuckets> snap{};
+    uint64_t total = 0;
+    for (std::size_t i = 0; i < kBuckets; ++i) { snap[i] = counts_[i].load(std::memory_order_relaxed); total += snap[i]; }
+    GcPauseSummary out;
+    out.count = total;
+    out.maxNs = max_.load(std::memory_order_relaxed);
+    if (total == 0U) { return out; }
+    const auto at = [&](uint64_t permille) {
+      const uint64_t rank = ((total * permille) + 999U) / 1000U; // 1-based, rounded up
+      uint64_t seen = 0;
+      for (std::size_t i = 0; i < kBuckets; ++i) {
+        seen += snap[i];
+        if (seen >= rank) { return std::min(upper_bound_of(i), out.maxNs); }
+      }
+      return out.maxNs;
+    };
+    out.p50Ns = at(500U); // NOLINT(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+    out.p90Ns = at(900U); // NOLINT(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+    out.p99Ns = at(990U); // NOLINT(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers)
+    return out;
+  }
+  void reset() {
+    for (auto& c : counts_) { c.store(0U, std::memory_order_relaxed); }
+    max_.store(0U, std::memory_order_relaxed);
+  }
+private:
+  static constexpr unsigned kSubBits = 3;
+  static constexpr uint64_t kLinear = 1ULL << (kSubBits + 1U);
+  static constexpr std::size_t kBuckets = kLinear + ((64U - (kSubBits + 1U)) << kSubBits);
+  static std::size_t bucket_of(uint64_t ns) {
+    if (ns < kLinear) { return static_cast<std::size_t>(ns); }
+    const unsigned exp = static_cast<unsigned>(std::bit_width(ns)) - 1U; // >= kSubBits + 1
+    const uint64_t sub = (ns >> (exp - kSubBits)) & ((1ULL << kSubBits) - 1U);
+    return static_cast<std::size_t>(kLinear + ((exp - (kSubBits + 1U)) << kSubBits) + sub);
+  }
+  static uint64_t upper_bound_of(std::size_t bucket) {
+    if (bucket < kLinear) { return bucket; }
+    const std::size_t rel = bucket - kLinear;
+    const unsigned exp = static_cast<unsigned>(rel >> kSubBits) + kSubBits + 1U;
+    const uint64_t sub = rel & ((1U << kSubBits) - 1U);
+    const uint64_t next = ((1ULL << kSubBits) + sub + 1U) << (exp - kSubBits);
+    return (next == 0U) ? UINT64_MAX : next - 1U; // the last bucket's bound wraps
+  }
+  std::array<std::atomic<uint64_t>, kBuckets> counts_{};
+  std::atomic<uint64_t> max_{0};
+};
+
+static DurationHistogram g_pause_hist; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+static DurationHistogram g_mark_hist;  // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+static DurationHistogram g_sweep_hist; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+
+static uint64_t elapsed_ns(std::chrono::steady_clock::time_point since) {
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - since).count());
+}
+
+// A collection's stop-the-world section: the handshake that stops the mutators plus the
+// CollectorLock hold, recorded into the pause histogram when it ends.
+class CollectionPause {
+public:
+  CollectionPause() = default;
+  ~CollectionPause() { g_pause_hist.record(elapsed_ns(start_)); }
+  CollectionPause(const CollectionPause&) = delete;
+  CollectionPause& operator=(const CollectionPause&) = delete;
+  CollectionPause(CollectionPause&&) = delete;
+  CollectionPause& operator=(CollectionPause&&) = delete;
+private:
+  std::chrono::steady_clock::time_point start_ = std::chrono::steady_clock::now();
+  CollectorLock lock_;
+};
+
 // Forward decl for adaptive controller
 static void adapt_controller();
 static void start_bg_thread_if_needed();
@@ -143,83 +971,343 @@ static void start_bg_thread_if_needed();
 // Request background GC if pressure is above the threshold.
 // Requires caller to hold g_mu; avoids synchronous collection during allocation
 // to prevent collecting newly allocated yet-unrooted objects (UAF risk).
+// A full nursery asks for a minor cycle; old-space growth past the threshold for a major one.
 static inline void maybe_request_bg_gc_unlocked() {
-  if (g_stats.bytesLive <= g_threshold) { return; }
+  const bool major = (g_stats.bytesLive - g_young_bytes) > g_threshold;
+  if (!major && !g_minor_pending) { return; }
   if (!g_bg_enabled.load(std::memory_order_relaxed)) { return; }
   if (!g_bg_started) { start_bg_thread_if_needed(); }
+  if (major) { g_major_requested.store(true, std::memory_order_relaxed); }
   g_bg_requested.store(true, std::memory_order_relaxed);
   const std::lock_guard<std::mutex> nlk(g_bg_mu);
   g_bg_cv.notify_one();
 }
 
-static void* alloc_raw(std::size_t size, TypeTag tag) {
-  // allocate size bytes for payload plus header
-  const std::size_t total = sizeof(ObjectHeader) + size;
+// Slow path under g_mu: refill the TLAB, or fall back to an old-space size-class slot or large span.
+static void* alloc_slow(MutatorState& self, std::size_t total, int ci, TypeTag tag) {
+  std::unique_lock<std::mutex> lock(g_mu, std::defer_lock);
+  if (!self.holdsLock) { lock.lock(); }
+  fold_mutator_counters_locked(self);
   unsigned char* mem = nullptr;
-  // Try segregated free list first (callers generally hold g_mu)
-  if (const int ci = class_index_for(total); ci >= 0) {
+  uint8_t gen = 1; // objects outside the nursery are born old
+  if (ci >= 0 && g_nursery_enabled.load(std::memory_order_relaxed)) {
+    retire_tlab_locked(self);
+    self.tlab = nursery_take_chunk_locked();
+    if (self.tlab != nullptr) { mem = tlab_bump(self.tlab, total); gen = 0; }
+  }
+  if (mem == nullptr && ci >= 0) {
     // Prefer thread-local cache
-    if (!t_free_lists[ci].empty()) {
-      ObjectHeader* h = t_free_lists[ci].back(); t_free_lists[ci].pop_back();
+    auto& cache = self.freeCache[static_cast<std::size_t>(ci)];
+    if (!cache.empty()) {
+      ObjectHeader* h = cache.back(); cache.pop_back();
       mem = reinterpret_cast<unsigned char*>(h);
-    } else if (!g_free_lists[ci].empty()) {
+    } else {
+      if (g_free_lists[ci].empty()) { carve_span_locked(ci); }
       // Steal a small batch from global to seed thread-local cache
       const std::size_t toSteal = std::min<std::size_t>(kStealBatch, g_free_lists[ci].size());
       for (std::size_t i = 0; i < toSteal; ++i) {
         ObjectHeader* h = g_free_lists[ci].back(); g_free_lists[ci].pop_back();
-        if (i + 1U < toSteal) { t_free_lists[ci].push_back(h); } else { mem = reinterpret_cast<unsigned char*>(h); }
+        if (i + 1U < toSteal) { cache.push_back(h); } else { mem = reinterpret_cast<unsigned char*>(h); }
       }
     }
   }
-  if (mem == nullptr) { mem = static_cast<unsigned char*>(::operator new(total)); }
+  HeapSpan* span = nullptr;
+  if (mem == nullptr) {
+    // Large object: a mapping of its own, indexed page by page
+    span = span_new_locked((total + kPageBytes - 1U) & ~(kPageBytes - 1U), SpanKind::Large, 0, -1);
+    span->objectBytes = total;
+    g_large_spans.push_back(span);
+    mem = span->base;
+  } else {
+    span = (gen == 0U) ? self.tlab : span_for_address(mem);
+  }
   auto* header = reinterpret_cast<ObjectHeader*>(mem); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
-  header->mark = 0;
-  header->tag = static_cast<uint32_t>(tag);
-  header->size = total;
-  header->gen = 0; header->age = 0; header->pad = 0;
-  header->next = g_head;
-  g_head = header;
+  header->tag = static_cast<uint8_t>(tag);
+  header->size = static_cast<uint32_t>(std::min<std::size_t>(total, UINT32_MAX));
+  header->gen = gen; header->age = 0; header->flags = 0;
+  if (gen != 0U) {
+    if (span->kind == SpanKind::Small) {
+      const std::size_t granule = granule_of(span, header);
+      span->starts[granule / 64U] |= granule_bit(granule);
+    }
+    // Allocated black while a background cycle runs: during marking so allocation adds no
+    // mark work, during sweeping so the sweep does not take the object for dead
+    if (g_gc_phase.load(std::memory_order_relaxed) != GCPhase::Idle) { set_mark(span, header); }
+    // Payloads of old-space objects are filled without barriers; let the next minor GC scan them once
+    if (g_nursery_enabled.load(std::memory_order_relaxed)) {
+      header->flags = kFlagRemembered;
+      g_remembered.push_back(mem + sizeof(ObjectHeader)); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    }
+  } else {
+    g_young_bytes += total;
+  }
   g_stats.numAllocated++;
   g_stats.bytesAllocated += total;
   g_stats.bytesLive += total;
   g_stats.peakBytesLive = std::max(g_stats.peakBytesLive, g_stats.bytesLive);
+  // Do not synchronously collect here; request background GC instead.
+  maybe_request_bg_gc_unlocked();
   return mem + sizeof(ObjectHeader); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
 }
 
-static void free_obj(ObjectHeader* header) {
+static void* local_alloc(LocalHeap& heap, std::size_t total, TypeTag tag);
+
+// Heap profiler: alloc_raw samples about one allocation per g_sample_period bytes (a Poisson
+// process: each thread draws exponential gaps) and records the native stack above it; the
+// debug info of compiled code resolves those frames to file:line. Sampled objects carry
+// kFlagSampled and leave their site's in-use totals when freed. The profile is written in
+// the legacy heap_v2 text format pprof reads, with /proc/self/maps appended for symbols.
+static constexpr int kMaxSampleFrames = 64;
+static constexpr int64_t kSampleRecheckBytes = int64_t{1} << 20U; // while off, how often to look again
+
+struct AllocSite {
+  uint64_t allocCount{0};
+  uint64_t allocBytes{0};
+  uint64_t inuseCount{0};
+  uint64_t inuseBytes{0};
+};
+
+struct StackHash {
+  std::size_t operator()(const std::vector<void*>& frames) const noexcept {
+    std::size_t hash = frames.size();
+    for (void* frame : frames) { hash = (hash * 31U) ^ std::hash<void*>{}(frame); } // NOLINT(readability-magic-numbers)
+    return hash;
+  }
+};
+
+static std::mutex g_profile_mu; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables) also taken by thread-local heaps without g_mu
+static std::atomic<std::size_t> g_sample_period{0}; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables) mean bytes between samples; 0 = off
+static std::unordered_map<std::vector<void*>, AllocSite, StackHash> g_alloc_sites; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+static std::unordered_map<const ObjectHeader*, AllocSite*> g_sampled; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables) live sampled objects
+static thread_local int64_t t_sample_countdown = 0; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables) bytes until the next sample
+static thread_local std::size_t t_sample_period = 0; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables) period the countdown was drawn for
+
+// The allocation that ran the countdown out. The first one after the period changes only
+// draws a gap, so threads do not all sample their next allocation.
+[[gnu::noinline]] static void sample_allocation(ObjectHeader* header) {
+  const std::size_t period = g_sample_period.load(std::memory_order_relaxed);
+  if (period == 0U) { t_sample_countdown = kSampleRecheckBytes; t_sample_period = 0; return; }
+  thread_local std::mt19937_64 rng{std::random_device{}()};
+  std::exponential_distribution<double> gap(1.0 / static_cast<double>(period));
+  const bool rearm = t_sample_period != period;
+  t_sample_countdown = static_cast<int64_t>(std::min(gap(rng), static_cast<double>(INT64_MAX / 2)));
+  t_sample_period = period;
+  if (rearm) { return; }
+  std::array<void*, kMaxSampleFrames> frames{};
+  const int depth = ::backtrace(frames.data(), kMaxSampleFrames);
+  std::vector<void*> stack(frames.begin() + 1, frames.begin() + std::max(depth, 1)); // without this frame
+  const std::lock_guard<std::mutex> lock(g_profile_mu);
+  AllocSite& site = g_alloc_sites[std::move(stack)];
+  site.allocCount++; site.allocBytes += header->size;
+  site.inuseCount++; site.inuseBytes += header->size;
+  g_sampled[header] = &site;
+  std::atomic_ref<uint8_t>(header->flags).fetch_or(kFlagSampled, std::memory_order_relaxed);
+}
+
+// A sampled object died (or its memory went away with its span).
+static void profile_forget(const ObjectHeader* header) {
+  const std::lock_guard<std::mutex> lock(g_profile_mu);
+  const auto it = g_sampled.find(header);
+  if (it == g_sampled.end()) { return; }
+  it->second->inuseCount--;
+  it->second->inuseBytes -= header->size;
+  g_sampled.erase(it);
+}
+
+// A thread-local heap goes away with its thread, sampled objects and all.
+static void profile_forget_heap(const LocalHeap* heap) {
+  const std::lock_guard<std::mutex> lock(g_profile_mu);
+  std::erase_if(g_sampled, [heap](const auto& entry) {
+    if (span_for_address(entry.first)->owner != heap) { return false; }
+    entry.second->inuseCount--;
+    entry.second->inuseBytes -= entry.first->size;
+    return true;
+  });
+}
+
+// Compaction copied a sampled object.
+static void profile_move(const ObjectHeader* from, const ObjectHeader* to) {
+  const std::lock_guard<std::mutex> lock(g_profile_mu);
+  auto node = g_sampled.extract(from);
+  if (node.empty()) { return; }
+  node.key() = to;
+  g_sampled.insert(std::move(node));
+}
+
+static bool write_heap_profile(const char* path) {
+  std::FILE* out = std::fopen(path, "w");
+  if (out == nullptr) { return false; }
+  {
+    const std::lock_guard<std::mutex> lock(g_profile_mu);
+    AllocSite total;
+    for (const auto& [stack, site] : g_alloc_sites) {
+      total.allocCount += site.allocCount; total.allocBytes += site.allocBytes;
+      total.inuseCount += site.inuseCount; total.inuseBytes += site.inuseBytes;
+    }
+    std::fprintf(out, "heap profile: %" PRIu64 ": %" PRIu64 " [%" PRIu64 ": %" PRIu64 "] @ heap_v2/%zu\n",
+                 total.inuseCount, total.inuseBytes, total.allocCount, total.allocBytes,
+                 std::max<std::size_t>(g_sample_period.load(std::memory_order_relaxed), 1U));
+    for (const auto& [stack, site] : g_alloc_sites) {
+      std::fprintf(out, "%" PRIu64 ": %" PRIu64 " [%" PRIu64 ": %" PRIu64 "] @",
+                   site.inuseCount, site.inuseBytes, site.allocCount, site.allocBytes);
+      for (void* frame : stack) { std::fprintf(out, " %p", frame); }
+      std::fputc('\n', out);
+    }
+  }
+  std::fputs("\nMAPPED_LIBRARIES:\n", out);
+  if (std::FILE* maps = std::fopen("/proc/self/maps", "r")) {
+    std::array<char, 4096> buf{}; // NOLINT(readability-magic-numbers)
+    for (std::size_t n = 0; (n = std::fread(buf.data(), 1, buf.size(), maps)) > 0;) { std::fwrite(buf.data(), 1, n, out); }
+    std::fclose(maps);
+  }
+  return std::fclose(out) == 0;
+}
+
+// Small objects normally come straight from the TLAB.
+static inline void* alloc_object(std::size_t total, TypeTag tag) {
+  if (LocalHeap* heap = t_local_heap) { return local_alloc(*heap, total, tag); }
+  const int ci = class_index_for(total);
+  MutatorState& self = *t_mutator.state;
+  unsigned char* mem = (ci >= 0 && self.tlab != nullptr) ? tlab_bump(self.tlab, total) : nullptr;
+  if (mem == nullptr) { return alloc_slow(self, total, ci, tag); }
+  auto* header = reinterpret_cast<ObjectHeader*>(mem); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+  header->tag = static_cast<uint8_t>(tag);
+  header->size = static_cast<uint32_t>(total);
+  header->gen = 0; header->age = 0; header->flags = 0;
+  self.numAllocated++;
+  self.bytesAllocated += total;
+  return mem + sizeof(ObjectHeader); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+}
+
+// Callers are inside a MutatorScope.
+static void* alloc_raw(std::size_t size, TypeTag tag) {
+  // allocate size bytes for payload plus header
+  const std::size_t total = sizeof(ObjectHeader) + size;
+  void* obj = alloc_object(total, tag);
+  if ((t_sample_countdown -= static_cast<int64_t>(total)) < 0) [[unlikely]] {
+    sample_allocation(static_cast<ObjectHeader*>(obj) - 1); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  }
+  return obj;
+}
+
+// Large spans are unmapped here; the caller drops them from g_large_spans.
+static void free_obj(HeapSpan* span, ObjectHeader* header) {
+  const std::size_t size = object_size(span, header);
+  if ((header->flags & kFlagSampled) != 0U) { profile_forget(header); }
   g_stats.numFreed++;
-  g_stats.bytesLive -= header->size;
-  if (g_debug) { std::fprintf(stderr, "[runtime] free_obj tag=%u size=%zu\n", header->tag, header->size); }
-  int ci = class_index_for(header->size);
-  if (ci >= 0) {
-    // Sweeper runs on background thread; keep pushing to global list. Mutators will steal into local caches.
-    g_free_lists[ci].push_back(header);
-  } else {
-    ::operator delete(header);
+  g_stats.bytesLive -= size;
+  if (g_debug) { std::fprintf(stderr, "[runtime] free_obj tag=%u size=%zu\n", static_cast<unsigned>(header->tag), size); }
+  if (span->kind == SpanKind::Large) { span_delete_locked(span); return; }
+  const std::size_t granule = granule_of(span, header);
+  span->starts[granule / 64U] &= ~granule_bit(granule);
+  span->marks[granule / 64U] &= ~granule_bit(granule);
+  header->tag = 0;
+  if (span->kind == SpanKind::Nursery) {
+    if (header->gen == 0U) { g_young_bytes -= size; }
+    if (--span->live == 0U && span->retired) {
+      nursery_chunk_reset(span);
+      g_nursery_free.push_back(span);
+    }
+    return;
   }
+  // Sweeper runs on background thread; keep pushing to global list. Mutators will steal into local caches.
+  g_free_lists[span->classIndex].push_back(header);
+  // The slot's page was touched since the scavenger last released it
+  span->releasedPages &= ~(1U << ((reinterpret_cast<unsigned char*>(header) - span->base) >> kPageShift)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+}
+
+// Scavenger: hand idle heap pages back to the OS with madvise(MADV_DONTNEED). The mapping
+// stays in place, so free slots remain on their lists and fault back in (zeroed: tag 0,
+// still free) when reused. Small-span pages qualify once their start bits are all clear,
+// which is checked without touching the page; recycled nursery chunks are idle as a whole.
+// Returns the bytes released (g_mu held).
+static std::size_t scavenge_locked() {
+  std::size_t released = 0;
+  const auto release = [&released](HeapSpan* span, std::size_t page) {
+    const uint32_t bit = 1U << page;
+    if ((span->releasedPages & bit) != 0U) { return; }
+    ::madvise(span->base + (page << kPageShift), kPageBytes, MADV_DONTNEED); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    span->releasedPages |= bit;
+    released += kPageBytes;
+  };
+  constexpr std::size_t kWordsPerPage = kPageBytes / kGranule / 64U;
+  for (HeapSpan* span : g_spans) {
+    for (std::size_t page = 0; page < (span->bytes >> kPageShift); ++page) {
+      const auto first = span->starts.begin() + static_cast<std::ptrdiff_t>(page * kWordsPerPage);
+      if (std::all_of(first, first + kWordsPerPage, [](uint64_t word) { return word == 0U; })) { release(span, page); }
+    }
+  }
+  for (HeapSpan* chunk : g_nursery_free) {
+    for (std::size_t page = 0; page < (chunk->bytes >> kPageShift); ++page) { release(chunk, page); }
+  }
+  g_stats.bytesReleased += released;
+  return released;
 }
 
-// Forward declaration for interior marking
+// Forward declarations for interior marking
+static ObjectHeader* find_object_for_pointer(const void* ptr, HeapSpan*& span);
 static ObjectHeader* find_object_for_pointer(const void* ptr);
 
 // Convenience wrapper returning stack bounds as an optional pair
 // (removed obsolete wrapper)
 
-// NOLINTNEXTLINE(readability-function-size,readability-function-cognitive-complexity)
-// Forward declare mark for helper calls
-static void mark(ObjectHeader* header);
+// Marking: shade() sets an object's mark bit and pushes it gray onto an explicit mark
+// stack; drain_mark_stack() pops gray objects and shades their children. Nothing
+// recurses on the native stack, so deeply linked structures cannot overflow it.
+// With gc_set_mark_threads(n > 1) a large enough backlog is drained by n workers,
+// each owning a deque; a worker that runs dry steals half of another's.
+static constexpr std::size_t kParallelMarkMinWork = 256; // gray objects before helpers are worth starting
+static constexpr unsigned kMaxMarkThreads = 256;
+
+struct MarkDeque {
+  std::mutex mu;
+  std::deque<ObjectHeader*> items; // owner pushes/pops at the back, thieves take from the front
+};
+
+static std::vector<ObjectHeader*> g_mark_stack; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables) serial gray stack
+static std::atomic<unsigned> g_mark_threads{1}; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+static std::vector<std::unique_ptr<MarkDeque>> g_mark_deques; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+static std::atomic<unsigned> g_mark_active{0}; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables) workers not idle
+static thread_local MarkDeque* t_mark_deque = nullptr; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables) set while in a parallel drain
+
+static void shade(HeapSpan* span, ObjectHeader* header) {
+  if (LocalHeap* heap = span->owner) {
+    if (is_marked(span, header)) { return; }
+    set_mark(span, header);
+    heap->markStack.push_back(header);
+    return;
+  }
+  if (g_minor_marking && header->gen != 0U) { return; } // old objects are not traced by a minor GC
+  if (MarkDeque* deque = t_mark_deque) {
+    if (!claim_mark_atomic(span, header)) { return; }
+    const std::lock_guard<std::mutex> lock(deque->mu);
+    deque->items.push_back(header);
+    return;
+  }
+  if (is_marked(span, header)) { return; }
+  set_mark(span, header);
+  g_mark_stack.push_back(header);
+}
+
+static inline void shade_pointer(const void* valuePtr) {
+  if (valuePtr == nullptr) { return; }
+  HeapSpan* span = nullptr;
+  if (ObjectHeader* header = find_object_for_pointer(valuePtr, span)) { shade(span, header); }
+}
+
+// Precise slots hold values, whose immediates refer to nothing; a conservatively scanned
+// stack word goes through shade_pointer, as it may be an unaligned interior pointer.
+static inline void shade_value(const void* value) {
+  if (!is_immediate(value)) { shade_pointer(value); }
+}
 
-// Per-tag mark helpers to keep switch shallow
+// Per-tag child scans to keep switch shallow
 static inline void mark_list_body(ObjectHeader* header) {
   auto* base = reinterpret_cast<unsigned char*>(header);
   auto const* payload = reinterpret_cast<std::size_t*>(base + sizeof(ObjectHeader));
   const std::size_t len = payload[0];
   auto* const* items = reinterpret_cast<void* const*>(payload + 2);
-  for (std::size_t i = 0; i < len; ++i) {
-    const void* valuePtr = items[i];
-    if (!valuePtr) continue;
-    if (ObjectHeader* headerPtr = find_object_for_pointer(valuePtr)) { mark(headerPtr); }
-  }
+  for (std::size_t i = 0; i < len; ++i) { shade_value(items[i]); }
 }
 
 static inline void mark_object_body(ObjectHeader* header) {
@@ -227,38 +1315,49 @@ static inline void mark_object_body(ObjectHeader* header) {
   auto const* payload = reinterpret_cast<std::size_t*>(base + sizeof(ObjectHeader));
   const std::size_t fields = payload[0];
   auto* const* values = reinterpret_cast<void* const*>(payload + 1);
-  for (std::size_t i = 0; i < fields; ++i) {
-    const void* valuePtr = values[i];
-    if (!valuePtr) continue;
-    if (ObjectHeader* headerPtr = find_object_for_pointer(valuePtr)) { mark(headerPtr); }
-  }
-  const void* attrDictPtr = values[fields];
-  if (attrDictPtr != nullptr) {
-    if (ObjectHeader* ad = find_object_for_pointer(attrDictPtr)) { mark(ad); }
-  }
+  for (std::size_t i = 0; i < fields; ++i) { shade_value(values[i]); }
+  shade_value(values[fields]); // attribute dict
+}
+
+// Dict payload: len, cap (index slots, a power of two), ver, used (entries filled), then the
+// dense entries keys[usable] and vals[usable] in insertion order, then the int32 index table
+// mapping hash slots to entry positions.
+static constexpr std::size_t kDictMetaWords = 4;
+static constexpr int32_t kDictEmpty = -1;
+static constexpr std::size_t dict_usable(std::size_t cap) { return (cap * 2U) / 3U; }
+static constexpr std::size_t dict_payload_size(std::size_t cap) {
+  return (kDictMetaWords * sizeof(std::size_t)) + (2U * dict_usable(cap) * sizeof(void*)) + (cap * sizeof(int32_t));
+}
+static inline void** dict_keys(std::size_t* meta) { return reinterpret_cast<void**>(meta + kDictMetaWords); } // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+static inline void** dict_vals(std::size_t* meta) { return dict_keys(meta) + dict_usable(meta[1]); } // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+static inline int32_t* dict_index(std::size_t* meta) { return reinterpret_cast<int32_t*>(dict_vals(meta) + dict_usable(meta[1])); } // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+// Set payload: the dict layout without values. Discarded elements leave a null entry and a
+// dummy index slot until the next resize.
+static constexpr int32_t kSetDummy = -2;
+static constexpr std::size_t set_payload_size(std::size_t cap) {
+  return (kDictMetaWords * sizeof(std::size_t)) + (dict_usable(cap) * sizeof(void*)) + (cap * sizeof(int32_t));
+}
+static inline int32_t* set_index(std::size_t* meta) { return reinterpret_cast<int32_t*>(dict_keys(meta) + dict_usable(meta[1])); } // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+static inline void mark_set_body(ObjectHeader* header) {
+  auto* base = reinterpret_cast<unsigned char*>(header);
+  auto* payload = reinterpret_cast<std::size_t*>(base + sizeof(ObjectHeader));
+  auto** entries = dict_keys(payload);
+  const std::size_t count = dict_usable(payload[1]);
+  for (std::size_t i = 0; i < count; ++i) { shade_value(entries[i]); }
 }
 
 static inline void mark_dict_body(ObjectHeader* header) {
   auto* base = reinterpret_cast<unsigned char*>(header);
   auto* payload = reinterpret_cast<std::size_t*>(base + sizeof(ObjectHeader));
-  const std::size_t cap = payload[1];
-  auto** keys = reinterpret_cast<void**>(payload + 2);
-  auto** vals = keys + cap;
-  for (std::size_t i = 0; i < cap; ++i) {
-    if (keys[i] != nullptr) {
-      if (ObjectHeader* k = find_object_for_pointer(keys[i])) { mark(k); }
-    }
-    if (vals[i] != nullptr) {
-      if (ObjectHeader* v = find_object_for_pointer(vals[i])) { mark(v); }
-    }
-  }
+  auto** entries = dict_keys(payload); // keys[], then vals[]
+  const std::size_t count = 2U * dict_usable(payload[1]);
+  for (std::size_t i = 0; i < count; ++i) { shade_value(entries[i]); }
 }
 
-// NOLINTNEXTLINE(readability-function-size,readability-function-cognitive-complexity)
-static void mark(ObjectHeader* header) {
-  if (header == nullptr || header->mark != 0U) { return; }
-  header->mark = 1;
-  // Recurse into interior pointers for aggregate types
+// Shade the interior pointers of aggregate types
+static void mark_children(ObjectHeader* header) {
   switch (static_cast<TypeTag>(header->tag)) {
     case TypeTag::String:
     case TypeTag::Bytes:
@@ -270,180 +1369,1082 @@ static void mark(ObjectHeader* header) {
     case TypeTag::List: mark_list_body(header); break;
     case TypeTag::Object: mark_object_body(header); break;
     case TypeTag::Dict: mark_dict_body(header); break;
+    case TypeTag::Set: mark_set_body(header); break;
+  }
+}
+
+static bool mark_deque_pop(MarkDeque& deque, ObjectHeader*& out) {
+  const std::lock_guard<std::mutex> lock(deque.mu);
+  if (deque.items.empty()) { return false; }
+  out = deque.items.back();
+  deque.items.pop_back();
+  return true;
+}
+
+// Move half of some other worker's deque into self; false when every victim is empty.
+static bool mark_deque_steal(std::size_t self, std::size_t workers) {
+  for (std::size_t k = 1; k < workers; ++k) {
+    MarkDeque& victim = *g_mark_deques[(self + k) % workers];
+    std::vector<ObjectHeader*> loot;
+    {
+      const std::lock_guard<std::mutex> lock(victim.mu);
+      const std::size_t take = (victim.items.size() + 1U) / 2U;
+      loot.assign(victim.items.begin(), victim.items.begin() + static_cast<std::ptrdiff_t>(take));
+      victim.items.erase(victim.items.begin(), victim.items.begin() + static_cast<std::ptrdiff_t>(take));
+    }
+    if (loot.empty()) { continue; }
+    MarkDeque& mine = *g_mark_deques[self];
+    const std::lock_guard<std::mutex> lock(mine.mu);
+    mine.items.insert(mine.items.end(), loot.begin(), loot.end());
+    return true;
+  }
+  return false;
+}
+
+static bool mark_deques_have_work(std::size_t workers) {
+  for (std::size_t i = 0; i < workers; ++i) {
+    const std::lock_guard<std::mutex> lock(g_mark_deques[i]->mu);
+    if (!g_mark_deques[i]->items.empty()) { return true; }
+  }
+  return false;
+}
+
+// Worker loop: drain own deque, then steal; finishes once every worker is idle with no work left.
+static void mark_worker(std::size_t self, std::size_t workers) {
+  t_mark_deque = g_mark_deques[self].get();
+  for (;;) {
+    ObjectHeader* header = nullptr;
+    while (mark_deque_pop(*t_mark_deque, header)) { mark_children(header); }
+    if (mark_deque_steal(self, workers)) { continue; }
+    g_mark_active.fetch_sub(1U, std::memory_order_acq_rel);
+    bool done = false;
+    while (!done) {
+      if (g_mark_active.load(std::memory_order_acquire) == 0U) { done = true; break; }
+      if (mark_deques_have_work(workers)) { g_mark_active.fetch_add(1U, std::memory_order_acq_rel); break; }
+      std::this_thread::yield();
+    }
+    if (done) { break; }
+  }
+  t_mark_deque = nullptr;
+}
+
+// Hand the serial gray stack to gc_set_mark_threads() workers and wait until all are idle.
+static void parallel_drain_mark_stack(std::size_t workers) {
+  while (g_mark_deques.size() < workers) { g_mark_deques.push_back(std::make_unique<MarkDeque>()); }
+  for (std::size_t i = 0; i < g_mark_stack.size(); ++i) { g_mark_deques[i % workers]->items.push_back(g_mark_stack[i]); }
+  g_mark_stack.clear();
+  g_mark_active.store(static_cast<unsigned>(workers), std::memory_order_release);
+  std::vector<std::thread> helpers;
+  helpers.reserve(workers - 1U);
+  for (std::size_t i = 1; i < workers; ++i) { helpers.emplace_back(mark_worker, i, workers); }
+  mark_worker(0, workers);
+  for (std::thread& helper : helpers) { helper.join(); }
+}
+
+static void drain_mark_stack() {
+  const std::size_t workers = g_mark_threads.load(std::memory_order_relaxed);
+  while (!g_mark_stack.empty()) {
+    if (workers > 1U && g_mark_stack.size() >= kParallelMarkMinWork) { parallel_drain_mark_stack(workers); return; }
+    ObjectHeader* header = g_mark_stack.back();
+    g_mark_stack.pop_back();
+    mark_children(header);
+  }
+}
+
+// Precise stack roots of compiled code: the gcroot slots of every frame on the shadow stacks
+// of the collecting thread and of the mutators parked by stop_mutators_locked. Each thread
+// links its frames into its own llvm_gc_root_chain and pushes and pops them without telling
+// the runtime, so a chain is only walked while its thread is parked. A mutator the stop did
+// not wait for had no frames; what it stores into new ones comes from the runtime, which the
+// collector holds, or from the registered roots.
+template <typename Fn>
+static void for_each_shadow_root(Fn&& visit) {
+  const std::lock_guard<std::mutex> mlock(g_mutators_mu);
+  for (const MutatorState* mutator : g_mutators) {
+    if (mutator != t_self_state && mutator->stackLow.load(std::memory_order_seq_cst) == nullptr) { continue; }
+    for (pycc_gc_stack_entry* entry = *mutator->rootChain; entry != nullptr; entry = entry->next) {
+      auto* roots = reinterpret_cast<void**>(entry + 1); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+      const auto numRoots = static_cast<std::size_t>(std::max(entry->map->num_roots, 0));
+      for (std::size_t i = 0; i < numRoots; ++i) { visit(roots[i]); } // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    }
+  }
+}
+
+// Incremental marking: drain gray objects until the slice deadline; true once none are left.
+static bool drain_mark_stack_until(std::chrono::steady_clock::time_point deadline) {
+  constexpr std::size_t kClockCheckInterval = 64;
+  std::size_t scanned = 0;
+  while (!g_mark_stack.empty()) {
+    if (++scanned % kClockCheckInterval == 0U && std::chrono::steady_clock::now() >= deadline) { return false; }
+    ObjectHeader* header = g_mark_stack.back();
+    g_mark_stack.pop_back();
+    mark_children(header);
+  }
+  return true;
+}
+
+void gc_set_mark_threads(unsigned threads) {
+  if (threads == 0U) { threads = std::max(1U, std::thread::hardware_concurrency()); }
+  g_mark_threads.store(std::min(threads, kMaxMarkThreads), std::memory_order_relaxed);
+}
+
+static bool in_object_payload(const HeapSpan* span, ObjectHeader* header, const void* ptr) {
+  const auto* begin = reinterpret_cast<const unsigned char*>(header) + sizeof(ObjectHeader); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  const auto* end = reinterpret_cast<const unsigned char*>(header) + object_size(span, header); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  const auto* ptrBytes = reinterpret_cast<const unsigned char*>(ptr); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+  return ptrBytes >= begin && ptrBytes < end;
+}
+
+static ObjectHeader* find_object_for_pointer(const void* ptr, HeapSpan*& span) {
+  span = span_for_address(ptr);
+  if (span == nullptr || span->owner != t_local_heap) { return nullptr; } // another thread's heap
+  std::size_t start = 0;
+  const auto offset = static_cast<std::size_t>(static_cast<const unsigned char*>(ptr) - span->base);
+  if (span->kind == SpanKind::Small) {
+    start = offset & ~(span->slotSize - 1U); // slot sizes are powers of two
+  } else if (span->kind == SpanKind::Nursery) {
+    start = nursery_object_start(span, offset);
+    if (start >= kSpanBytes) { return nullptr; }
+  }
+  auto* header = reinterpret_cast<ObjectHeader*>(span->base + start); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  if (header->tag == 0U) { return nullptr; } // free slot
+  return in_object_payload(span, header, ptr) ? header : nullptr;
+}
+
+static ObjectHeader* find_object_for_pointer(const void* ptr) {
+  HeapSpan* span = nullptr;
+  return find_object_for_pointer(ptr, span);
+}
+
+static void shade_remembered_locked() {
+  // The caller holds a CollectorLock, which has already collected the store buffers
+  std::vector<std::pair<HeapSpan*, ObjectHeader*>> tmp;
+  tmp.reserve(g_remembered.size());
+  for (const void* valuePtr : g_remembered) {
+    if (valuePtr == nullptr) { continue; }
+    HeapSpan* span = nullptr;
+    if (ObjectHeader* header = find_object_for_pointer(valuePtr, span)) {
+      header->flags = static_cast<uint8_t>(header->flags & ~kFlagRemembered);
+      tmp.emplace_back(span, header);
+    }
+  }
+  g_remembered.clear();
+  for (auto [span, header] : tmp) {
+    // A minor GC scans remembered old objects for young referents instead of marking them
+    if (g_minor_marking && header->gen != 0U) { mark_children(header); } else { shade(span, header); }
+  }
+}
+
+static void mark_from_remembered_locked() {
+  shade_remembered_locked();
+  drain_mark_stack();
+}
+
+// A stop-the-world major traces everything from the roots; remembered entries would only retain garbage.
+static void drop_remembered_locked() {
+  for (const void* valuePtr : g_remembered) {
+    if (ObjectHeader* header = (valuePtr != nullptr) ? find_object_for_pointer(valuePtr) : nullptr) {
+      header->flags = static_cast<uint8_t>(header->flags & ~kFlagRemembered);
+    }
+  }
+  g_remembered.clear();
+}
+
+static std::optional<std::pair<void*, void*>> get_stack_bounds_pair() {
+  // Current thread only
+#ifdef __APPLE__
+  const pthread_t self = pthread_self();
+  void* stackaddr = pthread_get_stackaddr_np(self);
+  if (const size_t stacksize = pthread_get_stacksize_np(self); stackaddr != nullptr && stacksize > 0U) {
+    // On macOS, stackaddr is the HIGH address, stack grows down
+    const auto highAddr = reinterpret_cast<std::uintptr_t>(stackaddr);
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    const auto lowAddr = reinterpret_cast<std::uintptr_t>(static_cast<unsigned char*>(stackaddr) - stacksize);
+    return std::make_pair(reinterpret_cast<void*>(lowAddr), reinterpret_cast<void*>(highAddr));
+  }
+  return std::nullopt;
+#elifdef __linux__
+  pthread_attr_t attr;
+  if (pthread_getattr_np(pthread_self(), &attr) != 0) { return std::nullopt; }
+  void* stackaddr = nullptr; size_t stacksize = 0;
+  if (pthread_attr_getstack(&attr, &stackaddr, &stacksize) != 0) { pthread_attr_destroy(&attr); return std::nullopt; }
+  pthread_attr_destroy(&attr);
+  const std::uintptr_t lowAddr = reinterpret_cast<std::uintptr_t>(stackaddr);
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  const std::uintptr_t highAddr = reinterpret_cast<std::uintptr_t>(static_cast<unsigned char*>(stackaddr) + stacksize);
+  return std::make_pair(reinterpret_cast<void*>(lowAddr), reinterpret_cast<void*>(highAddr));
+#else
+  // Fallback: approximate using address of local variable as low bound and assume 8MB stack
+  unsigned char local{};
+  const std::uintptr_t lowAddr = reinterpret_cast<std::uintptr_t>(&local);
+  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  const std::uintptr_t highAddr = lowAddr + (8U << 20U);
+  return std::make_pair(reinterpret_cast<void*>(lowAddr), reinterpret_cast<void*>(highAddr));
+#endif
+}
+
+// Stop every other registered mutator at a safepoint and return the stack ranges to scan.
+// The caller holds a CollectorLock, so no thread is inside a fast MutatorScope. g_mutators_mu
+// is not held while waiting: a thread on its way to park may need it (CollectorLock does).
+// Threads that register meanwhile are picked up by the next pass, and every stopped thread
+// stays parked until the CollectorLock is released. Without conservative
+// scanning a thread with an empty shadow stack owns no roots and is not waited for; it may be
+// blocked outside the runtime (a join in C++ code) and never reach a safepoint.
+static StackRanges stop_mutators_locked() {
+  const TraceScope trace(TraceKind::GcStop);
+  std::atomic_ref<uint8_t>(pycc_gc_safepoint_requested).store(1U, std::memory_order_seq_cst);
+  StackRanges ranges;
+  std::vector<MutatorState*> stopped;
+  for (;;) {
+    std::vector<MutatorState*> pending;
+    {
+      const std::lock_guard<std::mutex> mlock(g_mutators_mu);
+      for (MutatorState* mutator : g_mutators) {
+        if (mutator == t_self_state || std::find(stopped.begin(), stopped.end(), mutator) != stopped.end()) { continue; }
+        if (!g_conservative && std::atomic_ref<pycc_gc_stack_entry*>(*mutator->rootChain).load(std::memory_order_seq_cst) == nullptr) { continue; }
+        pending.push_back(mutator);
+      }
+    }
+    if (pending.empty()) { return ranges; }
+    // Deregistering needs g_mu, so none of these goes away before the stop ends
+    for (MutatorState* mutator : pending) {
+      const std::uintptr_t* low = nullptr;
+      while ((low = mutator->stackLow.load(std::memory_order_seq_cst)) == nullptr) { std::this_thread::yield(); }
+      ranges.emplace_back(low, mutator->stackHigh);
+      stopped.push_back(mutator);
+    }
+  }
+}
+
+static void resume_mutators() {
+  {
+    const std::lock_guard<std::mutex> lock(g_safepoint_mu);
+    std::atomic_ref<uint8_t>(pycc_gc_safepoint_requested).store(0U, std::memory_order_seq_cst);
+  }
+  g_safepoint_cv.notify_all();
+}
+
+// Conservative roots: the stacks of the stopped mutators (ranges) and the collecting thread's
+// own when it is a mutator. With gc_set_mark_threads(n > 1) the ranges are resolved to objects
+// in parallel (page-map lookups only) and shaded afterwards. Before a compaction every span a
+// stack word hits is pinned.
+// NOLINTNEXTLINE(readability-function-size,readability-function-cognitive-complexity)
+[[gnu::noinline]] static void mark_from_stacks(StackRanges ranges, bool forCompaction) {
+#if defined(__GNUC__) || defined(__clang__)
+  __builtin_unwind_init(); // our own callee-saved registers land in this frame
+#endif
+  std::uintptr_t marker = 0;
+  if (t_self_state != nullptr) { ranges.emplace_back(&marker, t_self_state->stackHigh); }
+  const std::size_t workers = std::min<std::size_t>(g_mark_threads.load(std::memory_order_relaxed), ranges.size());
+  if (workers <= 1U) {
+    for (const auto& [low, high] : ranges) {
+      for (const std::uintptr_t* word = low; word < high; ++word) { // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        HeapSpan* span = nullptr;
+        if (ObjectHeader* header = find_object_for_pointer(reinterpret_cast<void*>(*word), span)) { // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast,performance-no-int-to-ptr)
+          span->pinned = span->pinned || forCompaction;
+          shade(span, header);
+        }
+      }
+    }
+  } else {
+    std::vector<std::vector<std::pair<HeapSpan*, ObjectHeader*>>> found(ranges.size());
+    std::atomic<std::size_t> next{0};
+    const auto scan = [&ranges, &found, &next] {
+      for (std::size_t i = next.fetch_add(1U); i < ranges.size(); i = next.fetch_add(1U)) {
+        for (const std::uintptr_t* word = ranges[i].first; word < ranges[i].second; ++word) { // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+          HeapSpan* span = nullptr;
+          if (ObjectHeader* header = find_object_for_pointer(reinterpret_cast<void*>(*word), span)) { found[i].emplace_back(span, header); } // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast,performance-no-int-to-ptr)
+        }
+      }
+    };
+    std::vector<std::thread> helpers;
+    helpers.reserve(workers - 1U);
+    for (std::size_t i = 1; i < workers; ++i) { helpers.emplace_back(scan); }
+    scan();
+    for (std::thread& helper : helpers) { helper.join(); }
+    for (const auto& hits : found) {
+      for (auto [span, header] : hits) {
+        span->pinned = span->pinned || forCompaction;
+        shade(span, header);
+      }
+    }
+  }
+}
+
+// Every root: registered roots, the compiled frames of every mutator and, with conservative
+// scanning, whole thread stacks. The other mutators are stopped at safepoints first and stay
+// parked for the rest of the collection's pause, so nothing they do races with the scan or
+// with what the collection does next (sweeping the nursery, moving objects).
+static void shade_roots(bool forCompaction = false) {
+  StackRanges ranges = stop_mutators_locked();
+  for (void* const* slot : g_roots) { shade_value(*slot); }
+  for_each_shadow_root([](void* slot) { shade_value(slot); });
+  if (g_conservative) { mark_from_stacks(std::move(ranges), forCompaction); }
+}
+
+static void mark_from_roots(bool forCompaction = false) {
+  shade_roots(forCompaction);
+  drain_mark_stack();
+}
+
+// Visit the objects of span whose start bits are set in bits, the given word of its bitmaps.
+template <typename Fn>
+static inline void for_each_object_in_word(HeapSpan* span, std::size_t word, uint64_t bits, Fn&& visit) {
+  while (bits != 0U) {
+    const auto bit = static_cast<std::size_t>(std::countr_zero(bits));
+    bits &= bits - 1U;
+    visit(reinterpret_cast<ObjectHeader*>(span->base + (((word * 64U) + bit) * kGranule))); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  }
+}
+
+// Mark bits only mean something within a cycle: every major mark starts from clear bitmaps,
+// and sweeping leaves survivors' bits set rather than clearing them object by object.
+static void clear_marks_locked() {
+  const auto clear = [](HeapSpan* span) { std::fill(span->marks.begin(), span->marks.end(), 0U); };
+  std::for_each(g_spans.begin(), g_spans.end(), clear);
+  std::for_each(g_nursery_all.begin(), g_nursery_all.end(), clear);
+  std::for_each(g_large_spans.begin(), g_large_spans.end(), clear);
+}
+
+// Free the allocated-but-unmarked objects of one bitmap word of an old-space span.
+static std::size_t sweep_word_locked(HeapSpan* span, std::size_t word) {
+  std::size_t reclaimed = 0;
+  for_each_object_in_word(span, word, span->starts[word] & ~span->marks[word], [&reclaimed, span](ObjectHeader* dead) {
+    reclaimed += dead->size;
+    free_obj(span, dead);
+  });
+  return reclaimed;
+}
+
+// Old-space spans are small-class spans and nursery chunks retired with promoted survivors.
+static std::size_t sweep_span_locked(HeapSpan* span) {
+  std::size_t reclaimed = 0;
+  span->sweepPending = false;
+  for (std::size_t word = 0; word < kBitmapWords; ++word) { reclaimed += sweep_word_locked(span, word); }
+  return reclaimed;
+}
+
+static std::size_t sweep_large_locked() {
+  std::size_t reclaimed = 0;
+  std::erase_if(g_large_spans, [&reclaimed](HeapSpan* span) {
+    if (span->marks[0] != 0U) { return false; }
+    reclaimed += span->objectBytes;
+    free_obj(span, reinterpret_cast<ObjectHeader*>(span->base)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+    return true;
+  });
+  return reclaimed;
+}
+
+static std::size_t sweep() {
+  std::size_t reclaimed = sweep_large_locked();
+  for (HeapSpan* span : g_spans) { reclaimed += sweep_span_locked(span); }
+  for (HeapSpan* chunk : g_nursery_all) {
+    if (chunk->retired) { reclaimed += sweep_span_locked(chunk); }
+  }
+  return reclaimed;
+}
+
+// Queue the old-space spans for the background sweep. Spans carved or retired later hold
+// only objects allocated black or promoted unmarked after the trace, so they stay out.
+static void queue_background_sweep_locked() {
+  g_sweep_spans.assign(g_spans.begin(), g_spans.end());
+  for (HeapSpan* chunk : g_nursery_all) {
+    if (chunk->retired) { g_sweep_spans.push_back(chunk); }
+  }
+  for (HeapSpan* span : g_sweep_spans) { span->sweepPending = true; }
+  g_sweep_next = 0; g_sweep_word = 0;
+}
+
+// Background sweep: free about `steps` objects from the cursor (g_mu held); true when done.
+// Live objects cost nothing to pass over, so each span is charged one step plus its frees.
+// Objects allocated meanwhile are born marked, so the sweep never takes them for dead; a
+// queued nursery chunk recycled in the meantime is skipped.
+static bool sweep_slice_locked(std::size_t steps, std::size_t& reclaimed) {
+  const std::size_t budget = steps;
+  while (g_sweep_next < g_sweep_spans.size()) {
+    if (steps == 0U) { return false; }
+    HeapSpan* span = g_sweep_spans[g_sweep_next];
+    while (span->sweepPending && g_sweep_word < kBitmapWords) {
+      const auto dead = static_cast<std::size_t>(std::popcount(span->starts[g_sweep_word] & ~span->marks[g_sweep_word]));
+      if (dead > steps && steps != budget) { return false; } // a slice always makes progress
+      reclaimed += sweep_word_locked(span, g_sweep_word++);
+      steps -= std::min(steps, dead);
+    }
+    span->sweepPending = false;
+    ++g_sweep_next; g_sweep_word = 0;
+    steps -= std::min<std::size_t>(steps, 1U);
+  }
+  g_sweep_spans.clear();
+  g_sweep_next = 0;
+  return true;
+}
+
+// Sweep the young objects of the given nursery chunks: marked ones are promoted in
+// place, the rest freed. Chunks left without survivors are recycled, the others retired
+// into the old space. Promoted objects keep their mark bit, so a background major that
+// queues the old space for sweeping right after this does not free them.
+static std::size_t sweep_nursery_locked(std::vector<HeapSpan*>& chunks) {
+  std::size_t reclaimed = 0;
+  for (HeapSpan* chunk : chunks) {
+    for (std::size_t word = 0; word < kBitmapWords; ++word) {
+      const uint64_t live = chunk->starts[word];
+      for_each_object_in_word(chunk, word, live & chunk->marks[word], [](ObjectHeader* header) {
+        header->gen = 1;
+        header->age = static_cast<uint8_t>(std::min<unsigned>(header->age + 1U, 255U));
+        g_young_bytes -= header->size;
+      });
+      for_each_object_in_word(chunk, word, live & ~chunk->marks[word], [&reclaimed, chunk](ObjectHeader* dead) {
+        reclaimed += dead->size;
+        free_obj(chunk, dead);
+      });
+    }
+    if (chunk->live == 0U) {
+      nursery_chunk_reset(chunk);
+      g_nursery_free.push_back(chunk);
+    } else {
+      chunk->retired = true;
+    }
+  }
+  chunks.clear();
+  return reclaimed;
+}
+
+// Move every thread's TLAB into the filled list so a collection covers it (CollectorLock held).
+static void nursery_seal_locked() {
+  const std::lock_guard<std::mutex> mlock(g_mutators_mu);
+  for (MutatorState* mutator : g_mutators) { retire_tlab_locked(*mutator); }
+}
+
+// Mostly-copying compaction of the old small-object space (Bartlett). Long-running programs
+// leave live objects scattered over many sparsely used spans; after a sweep finds more than
+// g_compact_percent of the bytes in partly used spans free, the next major collection
+// evacuates every span less than half full into the free slots of denser ones (or fresh
+// spans) and unmaps it. Only precise references move: registered roots, shadow-stack slots,
+// heap fields and the remembered set are rewritten through forwarding words left in the old
+// copies, and dicts whose keys moved are rehashed, as keys other than strings and numbers
+// hash by address. A span any
+// scanned stack word points into is pinned and stays where it is, which is why compaction
+// only runs with conservative stack scanning: the mutators stay stopped at their
+// safepoints from the scan until the references are fixed.
+static constexpr std::size_t kEvacuateOccupancyPercent = 50; // spans below this are emptied
+static int g_compact_percent = -1; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables) fragmentation that triggers compaction; < 0: off
+static bool g_compact_due = false; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables) set by the sweep, taken by the next major mark
+
+static std::size_t dict_key_hash(void* key);
+
+// Objects allocated in a small span, or only its marked ones.
+static std::size_t span_object_count(const HeapSpan* span, bool markedOnly) {
+  std::size_t count = 0;
+  for (std::size_t word = 0; word < kBitmapWords; ++word) {
+    count += static_cast<std::size_t>(std::popcount(markedOnly ? (span->starts[word] & span->marks[word]) : span->starts[word]));
+  }
+  return count;
+}
+
+// After a completed sweep: free bytes stranded in partly used small spans, and whether they
+// justify compacting at the next major collection.
+static void note_fragmentation_locked() {
+  uint64_t used = 0;
+  uint64_t stranded = 0;
+  for (const HeapSpan* span : g_spans) {
+    const std::size_t live = span_object_count(span, false);
+    if (live == 0U) { continue; }
+    used += kSpanBytes;
+    stranded += static_cast<uint64_t>((kSpanBytes / span->slotSize) - live) * span->slotSize;
+  }
+  g_stats.fragmentedBytes = stranded;
+  g_compact_due = g_compact_percent >= 0 && g_conservative && stranded >= kSpanBytes &&
+                  stranded * 100U > used * static_cast<uint64_t>(g_compact_percent); // NOLINT(readability-magic-numbers)
+}
+
+// New address of an evacuated object, or value itself.
+static inline void* forwarded(void* value) {
+  if (value == nullptr || is_immediate(value)) { return value; }
+  const HeapSpan* span = span_for_address(value);
+  if (span == nullptr || !span->evacuating) { return value; }
+  const auto* header = reinterpret_cast<const ObjectHeader*>(static_cast<unsigned char*>(value) - sizeof(ObjectHeader)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  return (header->flags & kFlagForwarded) != 0U ? *static_cast<void**>(value) : value;
+}
+
+// Rebuild a dict's index from its entries, e.g. after their (new) key addresses changed the
+// hashes. Entries keep their positions, so iteration order and running iterators are unaffected.
+static void dict_rehash_in_place(std::size_t* meta) {
+  const std::size_t mask = meta[1] - 1U;
+  auto* const* keys = dict_keys(meta);
+  int32_t* index = dict_index(meta);
+  std::fill_n(index, meta[1], kDictEmpty);
+  for (std::size_t i = 0; i < meta[3]; ++i) {
+    std::size_t slot = dict_key_hash(keys[i]) & mask; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    while (index[slot] != kDictEmpty) { slot = (slot + 1U) & mask; } // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    index[slot] = static_cast<int32_t>(i); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  }
+}
+
+// Rebuild a set's index from its live entries; as for dicts, entry positions stay put.
+static void set_rehash_in_place(std::size_t* meta) {
+  const std::size_t mask = meta[1] - 1U;
+  auto* const* entries = dict_keys(meta);
+  int32_t* index = set_index(meta);
+  std::fill_n(index, meta[1], kDictEmpty);
+  for (std::size_t i = 0; i < meta[3]; ++i) {
+    if (entries[i] == nullptr) { continue; } // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    std::size_t slot = dict_key_hash(entries[i]) & mask; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    while (index[slot] != kDictEmpty) { slot = (slot + 1U) & mask; } // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    index[slot] = static_cast<int32_t>(i); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  }
+}
+
+// Point the fields of a live object at the new copies of evacuated children.
+static void forward_children(ObjectHeader* header) {
+  auto* payload = reinterpret_cast<std::size_t*>(reinterpret_cast<unsigned char*>(header) + sizeof(ObjectHeader)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  const auto forward_all = [](void** values, std::size_t count) {
+    bool moved = false;
+    for (std::size_t i = 0; i < count; ++i) {
+      void* value = forwarded(values[i]); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+      moved = moved || value != values[i]; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+      values[i] = value; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    }
+    return moved;
+  };
+  switch (static_cast<TypeTag>(header->tag)) {
+    case TypeTag::List: (void)forward_all(reinterpret_cast<void**>(payload + 2), payload[0]); break; // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    case TypeTag::Object: (void)forward_all(reinterpret_cast<void**>(payload + 1), payload[0] + 1U); break; // fields, then the attribute dict // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    case TypeTag::Dict: {
+      (void)forward_all(dict_vals(payload), payload[3]);
+      if (forward_all(dict_keys(payload), payload[3])) { dict_rehash_in_place(payload); }
+      break;
+    }
+    case TypeTag::Set:
+      if (forward_all(dict_keys(payload), payload[3])) { set_rehash_in_place(payload); }
+      break;
+    default: break; // no interior pointers
+  }
+}
+
+// Move one marked object out of an evacuating span into a free slot of its class.
+static void evacuate_object(HeapSpan* from, ObjectHeader* header) {
+  const int ci = from->classIndex;
+  while (g_free_lists[ci].empty()) { carve_span_locked(ci); }
+  ObjectHeader* copy = g_free_lists[ci].back();
+  g_free_lists[ci].pop_back();
+  std::memcpy(copy, header, header->size);
+  HeapSpan* to = span_for_address(copy);
+  const std::size_t granule = granule_of(to, copy);
+  to->starts[granule / 64U] |= granule_bit(granule);
+  to->marks[granule / 64U] |= granule_bit(granule);
+  to->releasedPages &= ~(1U << ((reinterpret_cast<unsigned char*>(copy) - to->base) >> kPageShift)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+  if ((header->flags & kFlagSampled) != 0U) { profile_move(header, copy); }
+  header->flags = static_cast<uint8_t>(header->flags | kFlagForwarded);
+  *reinterpret_cast<void**>(header + 1) = copy + 1; // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  g_stats.bytesEvacuated += header->size;
+}
+
+// Runs after a complete major mark, with the mutators still stopped by the root scan.
+// Unmarked objects in evacuated spans are freed here, not by the sweep.
+// NOLINTNEXTLINE(readability-function-cognitive-complexity,readability-function-size)
+static void compact_locked() {
+  const TraceScope trace(TraceKind::GcCompact);
+  g_compact_due = false;
+  std::vector<HeapSpan*> victims;
+  for (HeapSpan* span : g_spans) {
+    if (span->pinned) { g_stats.numPinnedSpans++; continue; }
+    const std::size_t slots = kSpanBytes / span->slotSize;
+    if (span_object_count(span, true) * 100U < slots * kEvacuateOccupancyPercent) { // NOLINT(readability-magic-numbers)
+      span->evacuating = true;
+      victims.push_back(span);
+    }
+  }
+  if (!victims.empty()) {
+    g_stats.numCompactions++;
+    // No free slot of an evacuated span may be handed out again, cached by a thread or not;
+    // barrier records still in store buffers get forwarded with the rest
+    take_full_store_buffers_locked();
+    {
+      const std::lock_guard<std::mutex> mlock(g_mutators_mu);
+      for (MutatorState* mutator : g_mutators) {
+        return_free_cache_locked(*mutator);
+        flush_store_buffer_locked(*mutator);
+      }
+    }
+    for (auto& list : g_free_lists) {
+      std::erase_if(list, [](const ObjectHeader* slot) { return span_for_address(slot)->evacuating; });
+    }
+    for (HeapSpan* span : victims) {
+      for (std::size_t word = 0; word < kBitmapWords; ++word) {
+        for_each_object_in_word(span, word, span->starts[word] & span->marks[word], [span](ObjectHeader* header) { evacuate_object(span, header); });
+        for_each_object_in_word(span, word, span->starts[word] & ~span->marks[word], [span](ObjectHeader* dead) {
+          if ((dead->flags & kFlagSampled) != 0U) { profile_forget(dead); }
+          g_stats.numFreed++;
+          g_stats.bytesLive -= object_size(span, dead);
+        });
+      }
+    }
+    // Precise references: roots, compiled frames, barrier records and every live object
+    for (void** slot : g_roots) { *slot = forwarded(*slot); }
+    for_each_shadow_root([](void*& slot) { slot = forwarded(slot); });
+    for (void*& value : g_remembered) { value = forwarded(value); }
+    const auto forward_span = [](HeapSpan* span) {
+      if (span->evacuating) { return; }
+      if (span->kind == SpanKind::Large) {
+        if (span->marks[0] != 0U) { forward_children(reinterpret_cast<ObjectHeader*>(span->base)); } // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+        return;
+      }
+      for (std::size_t word = 0; word < kBitmapWords; ++word) {
+        for_each_object_in_word(span, word, span->starts[word] & span->marks[word], forward_children);
+      }
+    };
+    std::for_each(g_spans.begin(), g_spans.end(), forward_span);
+    std::for_each(g_nursery_all.begin(), g_nursery_all.end(), forward_span);
+    std::for_each(g_large_spans.begin(), g_large_spans.end(), forward_span);
+    std::erase_if(g_spans, [](HeapSpan* span) {
+      if (!span->evacuating) { return false; }
+      span_delete_locked(span);
+      return true;
+    });
+  }
+  for (HeapSpan* span : g_spans) { span->pinned = false; }
+}
+
+static void collect_major_locked();
+
+// Byte count with an optional k/m/g suffix (binary units); 0 when malformed.
+static std::size_t parse_byte_size(const char* text) {
+  char* end = nullptr;
+  const unsigned long long value = std::strtoull(text, &end, 10); // NOLINT(readability-magic-numbers)
+  if (end == text) { return 0; }
+  unsigned shift = 0;
+  switch (*end) {
+    case 'k': case 'K': shift = 10; break; // NOLINT(readability-magic-numbers)
+    case 'm': case 'M': shift = 20; break; // NOLINT(readability-magic-numbers)
+    case 'g': case 'G': shift = 30; break; // NOLINT(readability-magic-numbers)
+    case '\0': break;
+    default: return 0;
   }
-}
-
-static void mark_from_roots() {
-  for (void* const* slot : g_roots) {
-    void* const ptr = *slot;
-    if (ptr == nullptr) { continue; }
-    auto* hdr = reinterpret_cast<ObjectHeader*>(static_cast<unsigned char*>(ptr) - sizeof(ObjectHeader)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast,cppcoreguidelines-pro-bounds-pointer-arithmetic)
-    mark(hdr);
+  return static_cast<std::size_t>(value) << shift;
+}
+
+// Pacer settings from the environment: PYCC_GC_PERCENT (heap growth over the live bytes before
+// the next major cycle, "off" to disable) and PYCC_GC_HEAP_TARGET (absolute goal in bytes,
+// k/m/g suffixes allowed; takes precedence). PYCC_GC_COMPACT sets the compaction trigger and
+// PYCC_GC_HUGE_PAGES=0 opts heap arenas out of transparent huge pages.
+static void load_pacer_settings_locked() {
+  const char* huge = std::getenv("PYCC_GC_HUGE_PAGES");
+  g_huge_pages.store(huge == nullptr || std::strcmp(huge, "0") != 0, std::memory_order_relaxed);
+  g_compact_due = false;
+  g_compact_percent = -1;
+  if (const char* compact = std::getenv("PYCC_GC_COMPACT"); compact != nullptr && *compact != '\0') {
+    g_compact_percent = static_cast<int>(std::strtol(compact, nullptr, 10)); // NOLINT(readability-magic-numbers)
+  }
+  g_gc_percent = kDefaultGcPercent;
+  g_heap_target = 0;
+  if (const char* pct = std::getenv("PYCC_GC_PERCENT"); pct != nullptr && *pct != '\0') {
+    if (std::strcmp(pct, "off") == 0) { g_gc_percent = -1; }
+    else { g_gc_percent = static_cast<int>(std::strtol(pct, nullptr, 10)); } // NOLINT(readability-magic-numbers)
+  }
+  if (const char* target = std::getenv("PYCC_GC_HEAP_TARGET"); target != nullptr) { g_heap_target = parse_byte_size(target); }
+}
+
+// Next major trigger. The goal is the live bytes grown by g_gc_percent (or g_heap_target, with
+// at least a minimum trigger's worth of headroom over what is live); the trigger sits below it
+// by the bytes mutators are expected to allocate during a background cycle, so marking ends
+// near the goal, but no lower than halfway between live bytes and the goal.
+static void pace_next_trigger_locked() {
+  if (g_threshold_pinned) { return; }
+  const uint64_t live = g_live_after_major;
+  uint64_t goal = 0;
+  if (g_heap_target != 0U) {
+    goal = std::max<uint64_t>(g_heap_target, live + kDefaultThresholdBytes);
+  } else if (g_gc_percent < 0) {
+    goal = SIZE_MAX;
+  } else {
+    goal = live + ((live / 100U) * static_cast<uint64_t>(g_gc_percent)); // NOLINT(readability-magic-numbers)
   }
+  goal = std::max<uint64_t>(goal, kDefaultThresholdBytes);
+  g_heap_goal = static_cast<std::size_t>(std::min<uint64_t>(goal, SIZE_MAX));
+  if (goal == SIZE_MAX) { g_threshold = SIZE_MAX; return; }
+  const uint64_t headroom = goal - std::min(goal, live);
+  const auto runway = static_cast<uint64_t>(std::max(0.0, g_ewma_alloc_rate * g_ewma_cycle_ms));
+  const uint64_t trigger = goal - std::min(runway, headroom / 2U);
+  g_threshold = static_cast<std::size_t>(std::max<uint64_t>(trigger, kDefaultThresholdBytes));
 }
 
-static bool in_object_payload(ObjectHeader* header, const void* ptr) {
-  const auto* begin = reinterpret_cast<const unsigned char*>(header) + sizeof(ObjectHeader); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast,cppcoreguidelines-pro-bounds-pointer-arithmetic)
-  const auto* end = reinterpret_cast<const unsigned char*>(header) + header->size; // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast,cppcoreguidelines-pro-bounds-pointer-arithmetic)
-  const auto* ptrBytes = reinterpret_cast<const unsigned char*>(ptr); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
-  return ptrBytes >= begin && ptrBytes < end;
+// After a major collection: only old objects remain counted outside g_young_bytes.
+static void record_major_done_locked() {
+  note_fragmentation_locked();
+  g_live_after_major = g_stats.bytesLive - g_young_bytes;
+  pace_next_trigger_locked();
 }
 
-static ObjectHeader* find_object_for_pointer(const void* ptr) {
-  for (ObjectHeader* header = g_head; header != nullptr; header = header->next) {
-    if (in_object_payload(header, ptr)) { return header; }
+// Environment settings apply from startup; gc_reset_for_tests reloads them.
+[[maybe_unused]] static const bool g_pacer_from_env = [] { // NOLINT(cert-err58-cpp)
+  load_pacer_settings_locked();
+  pace_next_trigger_locked();
+  return true;
+}();
+
+// PYCC_HEAP_PROFILE=<path> samples allocations from startup and writes the heap profile
+// there at exit; PYCC_HEAP_PROFILE_RATE sets the mean bytes between samples (k/m/g suffixes).
+static constexpr std::size_t kDefaultSamplePeriod = std::size_t{512} << 10U;
+static std::string g_heap_profile_path; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables,cert-err58-cpp)
+static std::size_t g_env_sample_period = 0; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables) restored by gc_reset_for_tests
+[[maybe_unused]] static const bool g_heap_profile_from_env = [] { // NOLINT(cert-err58-cpp)
+  const char* path = std::getenv("PYCC_HEAP_PROFILE");
+  if (path == nullptr || *path == '\0') { return false; }
+  g_heap_profile_path = path;
+  const char* rate = std::getenv("PYCC_HEAP_PROFILE_RATE");
+  const std::size_t period = rate != nullptr ? parse_byte_size(rate) : 0U;
+  g_env_sample_period = period != 0U ? period : kDefaultSamplePeriod;
+  g_sample_period.store(g_env_sample_period, std::memory_order_relaxed);
+  std::atexit([] { (void)write_heap_profile(g_heap_profile_path.c_str()); });
+  return true;
+}();
+
+// A synchronous collection supersedes an in-flight background cycle, which then abandons it.
+// A pending sweep is finished first: marks left on unswept objects would hide their children
+// from the new trace. A partial mark is kept instead; its gray objects are still on the
+// mark stack. Returns true when the cycle was still marking.
+static bool take_over_bg_cycle_locked() {
+  const GCPhase phase = set_gc_phase(GCPhase::Idle);
+  if (phase == GCPhase::Sweep) {
+    std::size_t reclaimed = 0;
+    (void)sweep_slice_locked(SIZE_MAX, reclaimed);
+  }
+  return phase == GCPhase::Mark;
+}
+
+static void collect_minor_locked() {
+  // Young objects marked by an unfinished incremental mark may point at unmarked old ones
+  if (g_gc_phase.load(std::memory_order_relaxed) == GCPhase::Mark) { collect_major_locked(); return; }
+  (void)take_over_bg_cycle_locked();
+  const TraceScope trace(TraceKind::GcMinor);
+  g_stats.numCollections++;
+  g_stats.numMinorCollections++;
+  nursery_seal_locked();
+  const auto markStart = std::chrono::steady_clock::now();
+  {
+    const TraceScope marking(TraceKind::GcMark);
+    g_minor_marking = true;
+    mark_from_roots();
+    mark_from_remembered_locked();
+    g_minor_marking = false;
+  }
+  g_minor_pending = false;
+  const auto sweepStart = std::chrono::steady_clock::now();
+  {
+    const TraceScope sweeping(TraceKind::GcSweep);
+    g_stats.lastReclaimedBytes = static_cast<uint64_t>(sweep_nursery_locked(g_nursery_full));
   }
-  return nullptr;
+  g_mark_hist.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(sweepStart - markStart).count()));
+  g_sweep_hist.record(elapsed_ns(sweepStart));
 }
 
-static void mark_from_remembered_locked() {
-  // g_mu must be held by the caller when calling this
-  std::vector<void*> tmp;
+static void collect_major_locked() {
+  const TraceScope trace(TraceKind::GcMajor);
+  g_stats.numCollections++;
+  g_stats.numMajorCollections++;
+  const bool wasMarking = take_over_bg_cycle_locked();
+  nursery_seal_locked();
+  // Objects blackened by the superseded mark only see later stores through the barrier log
+  const auto markStart = std::chrono::steady_clock::now();
+  const bool compact = g_compact_due && g_conservative;
   {
-    const std::lock_guard<std::mutex> lockGuard(g_rem_mu);
-    tmp.swap(g_remembered);
+    const TraceScope marking(TraceKind::GcMark);
+    if (wasMarking) {
+      shade_remembered_locked();
+    } else {
+      drop_remembered_locked();
+      clear_marks_locked();
+    }
+    mark_from_roots(compact);
   }
-  for (const void* valuePtr : tmp) {
-    if (valuePtr == nullptr) { continue; }
-    if (ObjectHeader* header = find_object_for_pointer(valuePtr)) { mark(header); }
+  if (compact) { compact_locked(); }
+  const auto sweepStart = std::chrono::steady_clock::now();
+  std::size_t reclaimed = 0;
+  {
+    const TraceScope sweeping(TraceKind::GcSweep);
+    reclaimed = sweep();
+    reclaimed += sweep_nursery_locked(g_nursery_full);
   }
+  g_mark_hist.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(sweepStart - markStart).count()));
+  g_sweep_hist.record(elapsed_ns(sweepStart));
+  g_minor_pending = false;
+  g_stats.lastReclaimedBytes = static_cast<uint64_t>(reclaimed);
+  g_stats.peakBytesLive = std::max(g_stats.peakBytesLive, g_stats.bytesLive);
+  record_major_done_locked();
 }
 
-static std::optional<std::pair<void*, void*>> get_stack_bounds_pair() {
-  // Current thread only
-#ifdef __APPLE__
-  const pthread_t self = pthread_self();
-  void* stackaddr = pthread_get_stackaddr_np(self);
-  if (const size_t stacksize = pthread_get_stacksize_np(self); stackaddr != nullptr && stacksize > 0U) {
-    // On macOS, stackaddr is the HIGH address, stack grows down
-    const auto highAddr = reinterpret_cast<std::uintptr_t>(stackaddr);
-    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-    const auto lowAddr = reinterpret_cast<std::uintptr_t>(static_cast<unsigned char*>(stackaddr) - stacksize);
-    return std::make_pair(reinterpret_cast<void*>(lowAddr), reinterpret_cast<void*>(highAddr));
+// Wake the background collector and block until it finishes a cycle.
+static void request_bg_cycle_and_wait(bool major) {
+  if (!g_bg_started) { start_bg_thread_if_needed(); }
+  const uint64_t prev = g_gc_completed_count.load(std::memory_order_acquire);
+  {
+    const std::lock_guard<std::mutex> qlk(g_bg_mu);
+    if (major) { g_major_requested.store(true, std::memory_order_relaxed); }
+    g_bg_requested.store(true, std::memory_order_relaxed);
+    g_bg_cv.notify_one();
   }
-  return std::nullopt;
-#elifdef __linux__
-  pthread_attr_t attr;
-  if (pthread_getattr_np(pthread_self(), &attr) != 0) { return std::nullopt; }
-  void* stackaddr = nullptr; size_t stacksize = 0;
-  if (pthread_attr_getstack(&attr, &stackaddr, &stacksize) != 0) { pthread_attr_destroy(&attr); return std::nullopt; }
-  pthread_attr_destroy(&attr);
-  const std::uintptr_t lowAddr = reinterpret_cast<std::uintptr_t>(stackaddr);
-  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-  const std::uintptr_t highAddr = reinterpret_cast<std::uintptr_t>(static_cast<unsigned char*>(stackaddr) + stacksize);
-  return std::make_pair(reinterpret_cast<void*>(lowAddr), reinterpret_cast<void*>(highAddr));
-#else
-  // Fallback: approximate using address of local variable as low bound and assume 8MB stack
-  unsigned char local{};
-  const std::uintptr_t lowAddr = reinterpret_cast<std::uintptr_t>(&local);
-  // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers,readability-magic-numbers,cppcoreguidelines-pro-bounds-pointer-arithmetic)
-  const std::uintptr_t highAddr = lowAddr + (8U << 20U);
-  return std::make_pair(reinterpret_cast<void*>(lowAddr), reinterpret_cast<void*>(highAddr));
-#endif
+  blocking_region([prev] {
+    std::unique_lock<std::mutex> lk(g_gc_done_mu);
+    g_gc_done_cv.wait(lk, [prev]{ return g_gc_completed_count.load(std::memory_order_acquire) > prev; });
+  });
 }
 
-// NOLINTNEXTLINE(readability-function-size)
-static void mark_from_stack() {
-  const auto bounds = get_stack_bounds_pair();
-  if (!bounds) { return; }
-  // Align low up to word alignment
-  std::uintptr_t lowAddr = reinterpret_cast<std::uintptr_t>(bounds->first); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
-  const std::size_t align = alignof(std::uintptr_t);
-  lowAddr = (lowAddr + (align - 1U)) & ~(static_cast<std::uintptr_t>(align) - 1U);
-  auto* scanPtr = reinterpret_cast<std::uintptr_t*>(lowAddr); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
-  auto* end = reinterpret_cast<std::uintptr_t*>(bounds->second);        // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
-  // Iterate word-sized chunks across the stack region
-  while (scanPtr < end) {
-    const void* candidate = reinterpret_cast<void*>(*scanPtr); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
-    if (candidate != nullptr) {
-      if (ObjectHeader* header = find_object_for_pointer(candidate)) { mark(header); }
-    }
+// Kept out of line so the frame of local_collect, which holds the spilled registers, lies
+// within the scanned range.
+[[gnu::noinline]] static void local_mark_stack(LocalHeap& heap) {
+  std::uintptr_t marker = 0;
+  const auto* scanPtr = static_cast<const std::uintptr_t*>(&marker);
+  while (scanPtr < heap.stackTop) {
+    shade_pointer(reinterpret_cast<void*>(*scanPtr)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast,performance-no-int-to-ptr)
     ++scanPtr; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
   }
 }
 
-// NOLINTNEXTLINE(readability-function-size)
-static bool mark_from_stack_slice(std::size_t words_budget) {
-  if (g_stack_scan_cur == nullptr || g_stack_scan_end == nullptr) {
-    const auto bounds = get_stack_bounds_pair();
-    if (!bounds) { return true; }
-    std::uintptr_t lowAddr = reinterpret_cast<std::uintptr_t>(bounds->first); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
-    const std::size_t align = alignof(std::uintptr_t);
-    lowAddr = (lowAddr + (align - 1U)) & ~(static_cast<std::uintptr_t>(align) - 1U);
-    g_stack_scan_cur = reinterpret_cast<std::uintptr_t*>(lowAddr); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
-    g_stack_scan_end = reinterpret_cast<std::uintptr_t*>(bounds->second);    // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+// Stop-the-world mark-sweep of one thread-local heap, run by its owning thread.
+static void local_collect(LocalHeap& heap) {
+#if defined(__GNUC__) || defined(__clang__)
+  __builtin_unwind_init(); // spill callee-saved registers that may hold the only pointer to an object
+#endif
+  const auto clear = [](HeapSpan* span) { std::fill(span->marks.begin(), span->marks.end(), 0U); };
+  std::for_each(heap.spans.begin(), heap.spans.end(), clear);
+  std::for_each(heap.largeSpans.begin(), heap.largeSpans.end(), clear);
+  for (void* const* slot : heap.roots) { shade_value(*slot); }
+  local_mark_stack(heap);
+  while (!heap.markStack.empty()) {
+    ObjectHeader* header = heap.markStack.back();
+    heap.markStack.pop_back();
+    mark_children(header);
   }
-  std::size_t wordsScanned = 0;
-  while (g_stack_scan_cur < g_stack_scan_end && wordsScanned < words_budget) {
-    const void* candidate = reinterpret_cast<void*>(*g_stack_scan_cur); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
-    if (candidate != nullptr) {
-      if (ObjectHeader* header = find_object_for_pointer(candidate)) { mark(header); }
+  std::size_t reclaimed = 0;
+  for (HeapSpan* span : heap.spans) {
+    for (std::size_t word = 0; word < kBitmapWords; ++word) {
+      for_each_object_in_word(span, word, span->starts[word] & ~span->marks[word], [&](ObjectHeader* dead) {
+        reclaimed += dead->size;
+        if ((dead->flags & kFlagSampled) != 0U) { profile_forget(dead); }
+        span->starts[word] &= ~granule_bit(granule_of(span, dead));
+        dead->tag = 0;
+        heap.freeLists[span->classIndex].push_back(dead);
+      });
     }
-    ++g_stack_scan_cur; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-    ++wordsScanned;
   }
-  return g_stack_scan_cur >= g_stack_scan_end;
+  std::erase_if(heap.largeSpans, [&reclaimed](HeapSpan* span) {
+    if (span->marks[0] != 0U) { return false; }
+    reclaimed += span->objectBytes;
+    if (const auto* dead = reinterpret_cast<ObjectHeader*>(span->base); (dead->flags & kFlagSampled) != 0U) { profile_forget(dead); } // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+    span_delete_locked(span);
+    return true;
+  });
+  heap.bytesLive -= reclaimed;
+  heap.trigger = std::max<std::size_t>(kDefaultThresholdBytes, heap.bytesLive * 2U);
+  g_local_collections.fetch_add(1U, std::memory_order_relaxed);
 }
 
-// NOLINTNEXTLINE(readability-function-size)
-static void sweep() {
-  ObjectHeader* prev = nullptr; ObjectHeader* cur = g_head;
-  std::size_t reclaimed = 0;
-  while (cur != nullptr) {
-    if (cur->mark == 0U) {
-      ObjectHeader* dead = cur;
-      cur = cur->next;
-      if (prev != nullptr) { prev->next = cur; } else { g_head = cur; }
-      reclaimed += dead->size;
-      free_obj(dead);
-    } else {
-      // Survivor: clear mark and update generation/age
-      cur->mark = 0; // clear for next cycle
-      if (cur->gen == 0) {
-        if (cur->age < 2) cur->age += 1;
-        if (cur->age >= 1) { cur->gen = 1; }
-      }
-      prev = cur;
-      cur = cur->next;
+// Allocation in a thread-local heap; collects it first once live bytes pass its trigger.
+static void* local_alloc(LocalHeap& heap, std::size_t total, TypeTag tag) {
+  if (heap.bytesLive + total > heap.trigger) { local_collect(heap); }
+  const int ci = class_index_for(total);
+  HeapSpan* span = nullptr;
+  ObjectHeader* header = nullptr;
+  if (ci >= 0) {
+    std::vector<ObjectHeader*>& freeList = heap.freeLists[ci];
+    if (freeList.empty()) {
+      heap.spans.push_back(span_new_locked(kSpanBytes, SpanKind::Small, kClassSizes[ci], ci, &heap));
+      push_span_slots(heap.spans.back(), freeList);
+    }
+    header = freeList.back();
+    freeList.pop_back();
+    span = span_for_address(header);
+    const std::size_t granule = granule_of(span, header);
+    span->starts[granule / 64U] |= granule_bit(granule);
+  } else {
+    span = span_new_locked((total + kPageBytes - 1U) & ~(kPageBytes - 1U), SpanKind::Large, 0, -1, &heap);
+    span->objectBytes = total;
+    heap.largeSpans.push_back(span);
+    header = reinterpret_cast<ObjectHeader*>(span->base); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+  }
+  header->tag = static_cast<uint8_t>(tag);
+  header->size = static_cast<uint32_t>(std::min<std::size_t>(total, UINT32_MAX));
+  header->gen = 1; header->age = 0; header->flags = 0;
+  heap.bytesLive += total;
+  return reinterpret_cast<unsigned char*>(header) + sizeof(ObjectHeader); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+}
+
+void gc_collect_minor() {
+  if (LocalHeap* heap = t_local_heap) { local_collect(*heap); return; }
+  if (g_bg_enabled.load(std::memory_order_relaxed)) { request_bg_cycle_and_wait(false); return; }
+  const CollectionPause pause;
+  collect_minor_locked();
+}
+
+void gc_set_nursery_size(std::size_t bytes) {
+  const CollectorLock lock;
+  g_nursery_chunks = std::max<std::size_t>(bytes / kSpanBytes, 1U);
+  if (bytes != 0U) { g_nursery_enabled.store(true, std::memory_order_relaxed); return; }
+  // Disabling: promote current young objects in place so no minor GC is ever needed for them
+  g_nursery_enabled.store(false, std::memory_order_relaxed);
+  nursery_seal_locked();
+  for (HeapSpan* chunk : g_nursery_full) {
+    for (std::size_t word = 0; word < kBitmapWords; ++word) {
+      for_each_object_in_word(chunk, word, chunk->starts[word], [](ObjectHeader* header) { header->gen = 1; });
     }
+    chunk->retired = true;
   }
-  g_stats.lastReclaimedBytes = static_cast<uint64_t>(reclaimed);
-  g_stats.peakBytesLive = std::max(g_stats.peakBytesLive, g_stats.bytesLive);
+  g_nursery_full.clear();
+  g_young_bytes = 0;
 }
 
 void gc_collect() {
-  // If background GC is enabled, request a cycle and wait until one completes
-  if (g_bg_enabled.load(std::memory_order_relaxed)) {
-    if (!g_bg_started) { start_bg_thread_if_needed(); }
-    const uint64_t prev = g_gc_completed_count.load(std::memory_order_acquire);
-    {
-      const std::lock_guard<std::mutex> qlk(g_bg_mu);
-      g_bg_requested.store(true, std::memory_order_relaxed);
-      g_bg_cv.notify_one();
-    }
-    std::unique_lock<std::mutex> lk(g_gc_done_mu);
-    g_gc_done_cv.wait(lk, [&]{ return g_gc_completed_count.load(std::memory_order_acquire) > prev; });
-    return;
-  }
+  if (LocalHeap* heap = t_local_heap) { local_collect(*heap); return; }
+  // If background GC is enabled, request a full cycle and wait until one completes
+  if (g_bg_enabled.load(std::memory_order_relaxed)) { request_bg_cycle_and_wait(true); return; }
   // Synchronous collection path
-  const std::lock_guard<std::mutex> lock(g_mu);
-  g_stats.numCollections++;
-  mark_from_roots();
-  if (g_conservative) { mark_from_stack(); }
-  mark_from_remembered_locked();
-  sweep();
+  const CollectionPause pause;
+  collect_major_locked();
 }
 
 void gc_set_threshold(std::size_t bytes) {
-  const std::lock_guard<std::mutex> lock(g_mu);
+  lock_parked();
+  const std::lock_guard<std::mutex> lock(g_mu, std::adopt_lock);
   g_threshold = bytes;
+  g_threshold_pinned = true;
+}
+
+std::size_t gc_scavenge() {
+  lock_parked();
+  const std::lock_guard<std::mutex> lock(g_mu, std::adopt_lock);
+  return scavenge_locked();
 }
 
+void gc_set_heap_target(std::size_t bytes) {
+  lock_parked();
+  const std::lock_guard<std::mutex> lock(g_mu, std::adopt_lock);
+  g_heap_target = bytes;
+  g_threshold_pinned = false;
+  pace_next_trigger_locked();
+}
+
+void gc_set_heap_growth(int percent) {
+  lock_parked();
+  const std::lock_guard<std::mutex> lock(g_mu, std::adopt_lock);
+  g_gc_percent = percent;
+  g_threshold_pinned = false;
+  pace_next_trigger_locked();
+}
+
+void gc_set_compaction(int fragmentationPercent) {
+  lock_parked();
+  const std::lock_guard<std::mutex> lock(g_mu, std::adopt_lock);
+  g_compact_percent = fragmentationPercent;
+  if (fragmentationPercent < 0) { g_compact_due = false; }
+}
+
+void trace_set_enabled(bool enabled) { g_trace_enabled.store(enabled, std::memory_order_relaxed); }
+
+bool trace_flush(const char* path) {
+  if (path == nullptr) { path = g_trace_path.c_str(); }
+  return *path != '\0' && write_trace(path);
+}
+
+void gc_set_heap_profile_rate(std::size_t meanBytes) {
+  g_sample_period.store(meanBytes, std::memory_order_relaxed);
+  t_sample_countdown = 0; // other threads notice within kSampleRecheckBytes
+}
+
+bool gc_heap_profile_dump(const char* path) {
+  if (path == nullptr) { path = g_heap_profile_path.c_str(); }
+  return *path != '\0' && write_heap_profile(path);
+}
+
+void gc_set_huge_pages(bool enabled) { g_huge_pages.store(enabled, std::memory_order_relaxed); }
+
 void gc_set_conservative(bool enabled) {
-  const std::lock_guard<std::mutex> lock(g_mu);
+  lock_parked();
+  const std::lock_guard<std::mutex> lock(g_mu, std::adopt_lock);
   g_conservative = enabled;
 }
 
+// Background major cycle with incremental tri-color marking. The first slice seals the
+// nursery and shades the roots with the mutators stopped; each
+// later slice shades what the barriers logged since the previous one (stored values in
+// incremental-update mode, overwritten values under SATB) and drains the gray stack for at
+// most g_slice_us while mutators wait. The slice that runs out of gray objects stops them
+// again to re-scan the roots and stacks, finishes marking and sweeps the whole nursery, so
+// every reachable young object is promoted, and the large-object space, before releasing
+// them. Sweeping the rest of the old space follows in batches.
+// NOLINTNEXTLINE(readability-function-cognitive-complexity,readability-function-size)
+static void bg_major_cycle() {
+  const TraceScope trace(TraceKind::GcMajor);
+  const auto cycleStart = std::chrono::steady_clock::now();
+  uint64_t markNs = 0;
+  uint64_t sweepNs = 0;
+  {
+    const CollectionPause pause;
+    const TraceScope marking(TraceKind::GcMark);
+    const auto sliceStart = std::chrono::steady_clock::now();
+    g_stats.numCollections++;
+    g_stats.numMajorCollections++;
+    nursery_seal_locked();
+    clear_marks_locked();
+    (void)set_gc_phase(GCPhase::Mark);
+    shade_roots();
+    markNs += elapsed_ns(sliceStart);
+  }
+  std::size_t remarkReclaimed = 0;
+  for (;;) {
+    std::this_thread::yield(); // let mutators run between slices
+    const CollectionPause pause;
+    if (g_gc_phase.load(std::memory_order_relaxed) != GCPhase::Mark) { return; } // superseded
+    std::optional<TraceScope> marking(std::in_place, TraceKind::GcMark);
+    const auto sliceStart = std::chrono::steady_clock::now();
+    const auto deadline = sliceStart + std::chrono::microseconds(g_slice_us.load(std::memory_order_relaxed));
+    shade_remembered_locked();
+    if (!drain_mark_stack_until(deadline)) { markNs += elapsed_ns(sliceStart); continue; }
+    // Remark: roots, stacks and the last barrier records; then the nursery chunks filled so far
+    const bool compact = g_compact_due && g_conservative;
+    shade_roots(compact);
+    shade_remembered_locked();
+    drain_mark_stack();
+    marking.reset();
+    if (compact) { compact_locked(); }
+    const TraceScope sweeping(TraceKind::GcSweep);
+    const auto sweepStart = std::chrono::steady_clock::now();
+    markNs += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(sweepStart - sliceStart).count());
+    nursery_seal_locked();
+    remarkReclaimed = sweep_nursery_locked(g_nursery_full);
+    remarkReclaimed += sweep_large_locked(); // few objects, and their pages go straight back
+    g_minor_pending = false;
+    queue_background_sweep_locked();
+    (void)set_gc_phase(GCPhase::Sweep);
+    sweepNs += elapsed_ns(sweepStart);
+    break;
+  }
+  // Sweeping in batches while holding g_mu briefly; it touches nothing the TLAB fast path does
+  const std::chrono::nanoseconds min_hold(kMinLockHoldNs); // small lock hold
+  std::size_t reclaimed = remarkReclaimed;
+  for (;;) {
+    auto t_lock_start = std::chrono::steady_clock::now();
+    {
+      const std::lock_guard<std::mutex> lock(g_mu);
+      if (g_gc_phase.load(std::memory_order_relaxed) != GCPhase::Sweep) { return; } // finished by a synchronous collection
+      const TraceScope sweeping(TraceKind::GcSweep);
+      const auto batchStart = std::chrono::steady_clock::now();
+      const bool done = sweep_slice_locked(g_sweep_batch.load(std::memory_order_relaxed), reclaimed);
+      sweepNs += elapsed_ns(batchStart);
+      g_stats.peakBytesLive = std::max(g_stats.peakBytesLive, g_stats.bytesLive);
+      if (done) {
+        g_stats.lastReclaimedBytes = static_cast<uint64_t>(reclaimed);
+        (void)set_gc_phase(GCPhase::Idle);
+        g_mark_hist.record(markNs);
+        g_sweep_hist.record(sweepNs);
+        g_last_cycle_ns.store(elapsed_ns(cycleStart), std::memory_order_relaxed);
+        record_major_done_locked();
+        return;
+      }
+    }
+    if (std::chrono::steady_clock::now() - t_lock_start < min_hold) { std::this_thread::yield(); }
+  }
+}
+
 // NOLINTNEXTLINE(readability-function-cognitive-complexity,readability-function-size)
 static void start_bg_thread_if_needed() {
   if (g_bg_started) { return; }
@@ -453,61 +2454,25 @@ static void start_bg_thread_if_needed() {
       // Wait for request
       {
         std::unique_lock<std::mutex> lock(g_bg_mu);
-        g_bg_cv.wait(lock, [] { return g_bg_requested.load(std::memory_order_relaxed); });
+        g_bg_cv.wait(lock, [] { return g_bg_requested.load(std::memory_order_relaxed) || g_bg_stop.load(std::memory_order_relaxed); });
+        if (g_bg_stop.load(std::memory_order_relaxed)) { return; }
         g_bg_requested.store(false, std::memory_order_relaxed);
       }
-      // Phases: Mark, then Sweep in slices
-      auto slice_budget = std::chrono::microseconds(static_cast<long long>(g_slice_us.load(std::memory_order_relaxed)));
-      // Marking
-      {
-        const std::lock_guard<std::mutex> lock2(g_mu);
-        g_stats.numCollections++;
-        mark_from_roots();
-        mark_from_remembered_locked();
-      }
-      if (g_conservative) {
-        auto tStart = std::chrono::steady_clock::now();
-        while (true) {
-          const bool done = mark_from_stack_slice(kStackSliceWords);
-          if (done) { break; }
-          if (std::chrono::steady_clock::now() - tStart > slice_budget) { std::this_thread::yield(); tStart = std::chrono::steady_clock::now(); }
+      if (!g_major_requested.exchange(false, std::memory_order_relaxed)) {
+        // Young-only cycle: bounded by nursery size, done in one short critical section
+        {
+          const CollectionPause pause;
+          collect_minor_locked();
         }
-        // Reset scan pointers
-        g_stack_scan_cur = nullptr; g_stack_scan_end = nullptr;
-        // Finalize with any remembered writes while marking
-        const std::lock_guard<std::mutex> lock2(g_mu);
-        mark_from_remembered_locked();
-      }
-      // Sweeping in slices while holding g_mu briefly
-      const std::chrono::nanoseconds min_hold(kMinLockHoldNs); // small lock hold
-      for (;;) {
-        auto t_lock_start = std::chrono::steady_clock::now();
-        std::size_t reclaimed = 0;
+        adapt_controller();
         {
-          const std::lock_guard<std::mutex> lock3(g_mu);
-          if (g_sweep_cur == nullptr) { g_sweep_prev = nullptr; g_sweep_cur = g_head; }
-          std::size_t steps = 0;
-          const std::size_t batchSz = g_sweep_batch.load(std::memory_order_relaxed);
-          while (g_sweep_cur != nullptr && steps < batchSz) { // sweep batch
-            if (g_sweep_cur->mark == 0U) {
-              ObjectHeader* dead = g_sweep_cur;
-              g_sweep_cur = g_sweep_cur->next;
-              if (g_sweep_prev != nullptr) { g_sweep_prev->next = g_sweep_cur; } else { g_head = g_sweep_cur; }
-              reclaimed += dead->size;
-              free_obj(dead);
-            } else {
-              g_sweep_cur->mark = 0;
-              g_sweep_prev = g_sweep_cur;
-              g_sweep_cur = g_sweep_cur->next;
-            }
-            ++steps;
-          }
-          g_stats.lastReclaimedBytes = static_cast<uint64_t>(reclaimed);
-          g_stats.peakBytesLive = std::max(g_stats.peakBytesLive, g_stats.bytesLive);
+          std::lock_guard<std::mutex> lk(g_gc_done_mu);
+          g_gc_completed_count.fetch_add(1, std::memory_order_release);
         }
-        if (g_sweep_cur == nullptr) { break; }
-        if (std::chrono::steady_clock::now() - t_lock_start < min_hold) { std::this_thread::yield(); }
+        g_gc_done_cv.notify_all();
+        continue;
       }
+      bg_major_cycle();
       adapt_controller();
       // Done sweep
       // Notify any synchronous waiters that a GC completed
@@ -518,11 +2483,29 @@ static void start_bg_thread_if_needed() {
       g_gc_done_cv.notify_all();
     }
   });
-  g_bg_thread.detach();
 }
 
+// Joins the collector thread during static destruction, before the globals it uses go away.
+struct BgThreadStopper {
+  BgThreadStopper() = default;
+  ~BgThreadStopper() {
+    {
+      const std::lock_guard<std::mutex> lock(g_bg_mu);
+      g_bg_stop.store(true, std::memory_order_relaxed);
+      g_bg_cv.notify_one();
+    }
+    if (g_bg_thread.joinable()) { g_bg_thread.join(); }
+  }
+  BgThreadStopper(const BgThreadStopper&) = delete;
+  BgThreadStopper& operator=(const BgThreadStopper&) = delete;
+  BgThreadStopper(BgThreadStopper&&) = delete;
+  BgThreadStopper& operator=(BgThreadStopper&&) = delete;
+};
+static BgThreadStopper g_bg_stopper; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+
 void gc_set_background(bool enabled) {
-  const std::lock_guard<std::mutex> lock(g_mu);
+  lock_parked();
+  const std::lock_guard<std::mutex> lock(g_mu, std::adopt_lock);
   g_bg_enabled.store(enabled, std::memory_order_relaxed);
   if (enabled) { start_bg_thread_if_needed(); }
 }
@@ -531,16 +2514,48 @@ extern "C" void pycc_gc_write_barrier(void** slot, void* value) {
   gc_write_barrier(slot, value);
 }
 
+void gc_safepoint() {
+  if (!safepoint_requested()) { return; }
+  if (MutatorState* self = t_self_state) { run_parked(*self, [] {}); }
+}
+
+extern "C" void pycc_gc_safepoint(void) { gc_safepoint(); }
+
+// Sets kFlagRemembered; false when another store already logged the object this cycle.
+static bool claim_remembered(ObjectHeader* header) {
+  std::atomic_ref<uint8_t> flags(header->flags);
+  if ((flags.load(std::memory_order_relaxed) & kFlagRemembered) != 0U) { return false; }
+  return (flags.fetch_or(kFlagRemembered, std::memory_order_relaxed) & kFlagRemembered) == 0U;
+}
+
 void gc_write_barrier(void** /*slot*/, void* value) {
-  if (!g_bg_enabled.load(std::memory_order_relaxed)) { return; }
-  if (value == nullptr) { return; }
-  // Record the new value for later marking; avoid heavy locking
-  const std::lock_guard<std::mutex> lockGuard(g_rem_mu);
-  g_remembered.push_back(value);
+  if (value == nullptr || is_immediate(value) || t_local_heap != nullptr) { return; } // thread-local heaps stop the world alone
+  const bool concurrent = g_bg_enabled.load(std::memory_order_relaxed);
+  if (!concurrent && !g_nursery_enabled.load(std::memory_order_relaxed)) { return; }
+  const MutatorScope scope; // keeps collectors off the header and the store buffer
+  ObjectHeader* header = find_object_for_pointer(value);
+  if (header == nullptr) { return; }
+  // Old referents only matter to an incremental-update marker; without a background marker
+  // (or under SATB, where gc_pre_barrier logs the overwritten value) only young ones do
+  const bool satb = g_barrier_mode.load(std::memory_order_relaxed) == 1;
+  if ((!concurrent || satb) && header->gen != 0U) { return; }
+  // Record the new value for later marking, once per collection cycle
+  if (!claim_remembered(header)) { return; }
+  store_buffer_record(*t_mutator.state, value);
+}
+
+// Growing a list or dict copies its slots into a new buffer without per-slot barriers. A
+// buffer allocated black during incremental marking would hide them, so the old buffer is
+// kept gray until the cycle ends.
+static void copy_barrier(void* source) {
+  if (source == nullptr || t_local_heap != nullptr || g_gc_phase.load(std::memory_order_relaxed) != GCPhase::Mark) { return; }
+  ObjectHeader* header = find_object_for_pointer(source);
+  if (header == nullptr || !claim_remembered(header)) { return; }
+  store_buffer_record(*t_mutator.state, source);
 }
 
 void gc_pre_barrier(void** slot) {
-  if (!g_bg_enabled.load(std::memory_order_relaxed)) { return; }
+  if (!g_bg_enabled.load(std::memory_order_relaxed) || t_local_heap != nullptr) { return; }
   if (g_barrier_mode.load(std::memory_order_relaxed) != 1) { return; } // SATB only
   if (slot == nullptr) { return; }
   // The slot may contain an indeterminate value before first initialization
@@ -549,9 +2564,9 @@ void gc_pre_barrier(void** slot) {
   // analyzer's false positive on reading an indeterminate slot here.
   void* old = nullptr;
   std::memcpy(&old, slot, sizeof(void*)); // suppress analyzer false-positive for uninitialized read
-  if (old == nullptr) { return; }
-  const std::lock_guard<std::mutex> lockGuard(g_rem_mu);
-  g_remembered.push_back(old);
+  if (old == nullptr || is_immediate(old)) { return; }
+  const MutatorScope scope;
+  store_buffer_record(*t_mutator.state, old);
 }
 
 void gc_set_barrier_mode(int mode) {
@@ -587,6 +2602,18 @@ extern "C" void pycc_dict_set(void** dict_slot, void* key, void* value) { dict_s
 extern "C" void* pycc_dict_get(void* dict, void* key) { return dict_get(dict, key); }
 extern "C" uint64_t pycc_dict_len(void* dict) { return static_cast<uint64_t>(dict_len(dict)); }
 
+// Set interop
+extern "C" void* pycc_set_new(uint64_t cap) { return set_new(static_cast<std::size_t>(cap)); }
+extern "C" void pycc_set_add(void** set_slot, void* elem) { set_add(set_slot, elem); }
+extern "C" bool pycc_set_discard(void* set, void* elem) { return set_discard(set, elem); }
+extern "C" bool pycc_set_contains(void* set, void* elem) { return set_contains(set, elem); }
+extern "C" uint64_t pycc_set_len(void* set) { return static_cast<uint64_t>(set_len(set)); }
+extern "C" void* pycc_set_union(void* a, void* b) { return set_union(a, b); }
+extern "C" void* pycc_set_intersection(void* a, void* b) { return set_intersection(a, b); }
+extern "C" void* pycc_set_difference(void* a, void* b) { return set_difference(a, b); }
+extern "C" void* pycc_set_iter_new(void* set) { return set_iter_new(set); }
+extern "C" void* pycc_set_iter_next(void* it) { return set_iter_next(it); }
+
 extern "C" void* pycc_object_new(uint64_t fields) { return object_new(static_cast<std::size_t>(fields)); }
 extern "C" void pycc_object_set(void* obj, uint64_t idx, void* val) { object_set(obj, static_cast<std::size_t>(idx), val); }
 extern "C" void* pycc_object_get(void* obj, uint64_t idx) { return object_get(obj, static_cast<std::size_t>(idx)); }
@@ -597,6 +2624,7 @@ extern "C" void* pycc_box_int(int64_t value) { return box_int(value); }
 extern "C" void* pycc_box_float(double value) { return box_float(value); }
 extern "C" void* pycc_box_bool(bool value) { return box_bool(value); }
 extern "C" void* pycc_string_new(const char* data, size_t length) { return string_new(data, length); }
+extern "C" void* pycc_string_intern(const char* data, size_t length) { return string_intern(data, length); }
 extern "C" uint64_t pycc_string_len(void* str) { return static_cast<uint64_t>(string_len(str)); }
 extern "C" uint64_t pycc_string_charlen(void* str);
 extern "C" uint64_t pycc_string_charlen(void* str) { return static_cast<uint64_t>(string_charlen(str)); }
@@ -660,58 +2688,86 @@ static bool string_eq(void* a, void* b) {
 extern "C" int pycc_string_eq(void* a, void* b) { return string_eq(a, b) ? 1 : 0; }
 
 void gc_register_root(void** addr) {
-  const std::lock_guard<std::mutex> lock(g_mu);
+  if (LocalHeap* heap = t_local_heap) { heap->roots.push_back(addr); return; }
+  lock_parked();
+  const std::lock_guard<std::mutex> lock(g_mu, std::adopt_lock);
   g_roots.push_back(addr);
 }
 
 void gc_unregister_root(void** addr) {
-  const std::lock_guard<std::mutex> lock(g_mu);
-  auto iter = std::find(g_roots.begin(), g_roots.end(), addr);
-  if (iter != g_roots.end()) { g_roots.erase(iter); }
+  std::vector<void**>& roots = (t_local_heap != nullptr) ? t_local_heap->roots : g_roots;
+  std::unique_lock<std::mutex> lock;
+  if (t_local_heap == nullptr) { lock_parked(); lock = std::unique_lock<std::mutex>(g_mu, std::adopt_lock); }
+  auto iter = std::find(roots.begin(), roots.end(), addr);
+  if (iter != roots.end()) { roots.erase(iter); }
 }
 
 RuntimeStats gc_stats() {
-  const std::lock_guard<std::mutex> lock(g_mu);
-  return g_stats;
+  const CollectorLock lock;
+  RuntimeStats out = g_stats;
+  out.numLocalCollections = g_local_collections.load(std::memory_order_relaxed);
+  out.numPublished = g_published.load(std::memory_order_relaxed);
+  out.arenaBytes = g_arena_bytes.load(std::memory_order_relaxed);
+  out.hugePageBytes = g_huge_page_bytes.load(std::memory_order_relaxed);
+  return out;
 }
 
 void gc_reset_for_tests() {
   // Quiesce background GC and reset internal state for deterministic tests
   g_bg_enabled.store(false, std::memory_order_relaxed);
   g_barrier_mode.store(0, std::memory_order_relaxed);
+  g_major_requested.store(false, std::memory_order_relaxed);
+  const CollectorLock lock;
+  g_remembered.clear();
+  (void)set_gc_phase(GCPhase::Idle); // a running background cycle abandons
+  // free all: with every mark bit clear, sweeping the young and old spaces frees everything;
+  // large blocks go back to the OS and small slots to their class lists
+  g_sweep_spans.clear();
+  g_sweep_next = 0; g_sweep_word = 0;
+  nursery_seal_locked();
+  clear_marks_locked();
+  (void)sweep_nursery_locked(g_nursery_full);
+  (void)sweep();
+  g_roots.clear();
   {
-    const std::lock_guard<std::mutex> remLock(g_rem_mu);
-    g_remembered.clear();
+    const std::lock_guard<std::mutex> plock(g_profile_mu);
+    g_sampled.clear();
+    g_alloc_sites.clear();
   }
-  const std::lock_guard<std::mutex> lock(g_mu);
-  // free all
-  ObjectHeader* cur = g_head; g_head = nullptr;
-  while (cur != nullptr) { ObjectHeader* nextHeader = cur->next; ::operator delete(cur); cur = nextHeader; }
-  g_roots.clear();
+  g_sample_period.store(g_env_sample_period, std::memory_order_relaxed);
   g_stats = {};
+  g_local_collections.store(0U, std::memory_order_relaxed);
+  g_published.store(0U, std::memory_order_relaxed);
+  g_young_bytes = 0;
+  g_minor_pending = false;
+  g_nursery_chunks = kDefaultNurseryBytes / kSpanBytes;
+  g_nursery_enabled.store(true, std::memory_order_relaxed);
   g_conservative = false;
+  g_mark_stack.clear();
+  g_mark_threads.store(1U, std::memory_order_relaxed);
   g_threshold = kDefaultThresholdBytes;
-  g_sweep_cur = nullptr;
-  g_sweep_prev = nullptr;
-  g_stack_scan_cur = nullptr;
-  g_stack_scan_end = nullptr;
+  g_threshold_pinned = false;
+  g_live_after_major = 0;
+  g_ewma_alloc_rate = 0.0;
+  g_ewma_cycle_ms = 0.0;
+  load_pacer_settings_locked();
+  pace_next_trigger_locked();
+  g_pause_hist.reset();
+  g_mark_hist.reset();
+  g_sweep_hist.reset();
 }
 
 void* string_new(const char* data, std::size_t len) {
-  const std::lock_guard<std::mutex> lock(g_mu);
+  const MutatorScope scope;
   const std::size_t payloadSize = sizeof(StringPayload) + len + 1; // include NUL
   auto* payloadBytes = static_cast<unsigned char*>(alloc_raw(payloadSize, TypeTag::String));
-  if (g_debug) { std::fprintf(stderr, "[runtime] string_new(len=%zu) g_head=%p\n", len, static_cast<void*>(g_head)); }
+  if (g_debug) { std::fprintf(stderr, "[runtime] string_new(len=%zu)\n", len); }
   void* payloadVoid = static_cast<void*>(payloadBytes);
-  auto* plen = static_cast<std::size_t*>(payloadVoid);
-  *plen = len;
-  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-  char* buf = reinterpret_cast<char*>(plen + 1); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  new (payloadVoid) StringPayload{len, 0};
+  char* buf = reinterpret_cast<char*>(payloadBytes + sizeof(StringPayload)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast,cppcoreguidelines-pro-bounds-pointer-arithmetic)
   if (len != 0U && data != nullptr) { std::memcpy(buf, data, len); }
   // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
   buf[len] = '\0';
-  // Do not synchronously collect here; request background GC instead.
-  maybe_request_bg_gc_unlocked();
   return payloadVoid; // return pointer to payload start as the object handle
 }
 
@@ -736,16 +2792,47 @@ static std::size_t utf8_codepoint_count(const char* data, std::size_t n) {
 
 std::size_t string_charlen(void* str) {
   if (str == nullptr) { return 0; }
-  auto* plen = static_cast<std::size_t*>(str);
-  const char* data = reinterpret_cast<const char*>(plen + 1);
-  return utf8_codepoint_count(data, *plen);
+  return utf8_codepoint_count(string_data(str), string_len(str));
 }
 
 const char* string_data(void* str) {
   if (str == nullptr) { return nullptr; }
-  auto* plen = static_cast<std::size_t*>(str);
   // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-  return reinterpret_cast<const char*>(plen + 1);
+  return static_cast<const char*>(str) + sizeof(StringPayload);
+}
+
+// Content hash, computed on first use and cached in the string. Racing threads store the same value.
+static std::size_t string_hash(void* str) {
+  std::atomic_ref<std::size_t> cached(static_cast<StringPayload*>(str)->hash);
+  std::size_t hash = cached.load(std::memory_order_relaxed);
+  if (hash != 0U) { return hash; }
+  hash = string_content_hash(std::string_view(string_data(str), string_len(str)));
+  cached.store(hash, std::memory_order_relaxed);
+  return hash;
+}
+
+// Interned strings: one copy per content, allocated outside the collected heap. No collector
+// frees, scans or moves them, so they need no roots and threads with private heaps can share
+// them; they live until exit.
+static std::mutex g_intern_mu; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+static std::unordered_map<std::string_view, void*> g_interned; // NOLINT(cppcoreguidelines-avoid-non-const-global-variables,cert-err58-cpp) keys view the strings' own bytes
+
+void* string_intern(const char* data, std::size_t len) {
+  const std::string_view text = (data != nullptr) ? std::string_view(data, len) : std::string_view();
+  const std::lock_guard<std::mutex> lock(g_intern_mu);
+  if (const auto it = g_interned.find(text); it != g_interned.end()) { return it->second; }
+  const std::size_t total = sizeof(ObjectHeader) + sizeof(StringPayload) + text.size() + 1U;
+  auto* bytes = static_cast<unsigned char*>(std::malloc(total)); // NOLINT(cppcoreguidelines-no-malloc)
+  if (bytes == nullptr) { throw std::bad_alloc(); }
+  new (bytes) ObjectHeader{static_cast<uint8_t>(TypeTag::String), 1U, 0U, kFlagImmortal, static_cast<uint32_t>(total)};
+  void* str = bytes + sizeof(ObjectHeader); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  new (str) StringPayload{text.size(), 0};
+  char* buf = static_cast<char*>(str) + sizeof(StringPayload); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  if (!text.empty()) { std::memcpy(buf, text.data(), text.size()); }
+  buf[text.size()] = '\0'; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  (void)string_hash(str);
+  g_interned.emplace(std::string_view(buf, text.size()), str);
+  return str;
 }
 
 void* string_from_cstr(const char* cstr) {
@@ -823,27 +2910,32 @@ bool utf8_is_valid(const char* data, std::size_t len) {
   return true;
 }
 
-// Boxed primitives
+// Boxed primitives: ints within 63 bits and bools are immediates; only the rest allocate
 void* box_int(int64_t value) {
-  const std::lock_guard<std::mutex> lock(g_mu);
+  const auto shifted = static_cast<uint64_t>(value) << 1U;
+  if ((static_cast<int64_t>(shifted) >> 1) == value) { return reinterpret_cast<void*>(static_cast<uintptr_t>(shifted | kImmediateInt)); } // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast,performance-no-int-to-ptr)
+  const MutatorScope scope;
   const std::size_t payloadSize = sizeof(int64_t);
   auto* bytes = static_cast<unsigned char*>(alloc_raw(payloadSize, TypeTag::Int));
   std::memcpy(bytes, &value, sizeof(value));
-  maybe_request_bg_gc_unlocked();
   return bytes;
 }
 
 int64_t box_int_value(void* obj) {
   if (obj == nullptr) { return 0; }
+  if (is_immediate(obj)) {
+    const auto bits = reinterpret_cast<uintptr_t>(obj); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+    if (is_immediate_int(obj)) { return static_cast<int64_t>(bits) >> 1; }
+    return ((bits & kImmediateBoolValue) != 0U) ? 1 : 0;
+  }
   int64_t out{}; std::memcpy(&out, obj, sizeof(out)); return out;
 }
 
 void* box_float(double value) {
-  const std::lock_guard<std::mutex> lock(g_mu);
+  const MutatorScope scope;
   const std::size_t payloadSize = sizeof(double);
   auto* bytes = static_cast<unsigned char*>(alloc_raw(payloadSize, TypeTag::Float));
   std::memcpy(bytes, &value, sizeof(value));
-  maybe_request_bg_gc_unlocked();
   return bytes;
 }
 
@@ -853,19 +2945,10 @@ double box_float_value(void* obj) {
 }
 
 void* box_bool(bool value) {
-  const std::lock_guard<std::mutex> lock(g_mu);
-  const std::size_t payloadSize = sizeof(uint8_t);
-  auto* bytes = static_cast<unsigned char*>(alloc_raw(payloadSize, TypeTag::Bool));
-  uint8_t byteVal = value ? 1U : 0U;
-  std::memcpy(bytes, &byteVal, sizeof(byteVal));
-  maybe_request_bg_gc_unlocked();
-  return bytes;
+  return reinterpret_cast<void*>(kImmediateBool | (value ? kImmediateBoolValue : 0U)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast,performance-no-int-to-ptr)
 }
 
-bool box_bool_value(void* obj) {
-  if (obj == nullptr) { return false; }
-  uint8_t byteVal{}; std::memcpy(&byteVal, obj, sizeof(byteVal)); return byteVal != 0U;
-}
+bool box_bool_value(void* obj) { return box_int_value(obj) != 0; }
 
 // Lists
 static void* list_new_locked(std::size_t capacity) {
@@ -875,18 +2958,17 @@ static void* list_new_locked(std::size_t capacity) {
   meta[0] = 0; meta[1] = capacity; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
   auto** items = reinterpret_cast<void**>(meta + 2); // NOLINT
   for (std::size_t i = 0; i < capacity; ++i) { items[i] = nullptr; } // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-  maybe_request_bg_gc_unlocked();
   return bytes;
 }
 
 void* list_new(std::size_t capacity) {
-  const std::lock_guard<std::mutex> lock(g_mu);
+  const MutatorScope scope;
   return list_new_locked(capacity);
 }
 
 void list_push_slot(void** list_slot, void* elem) {
   if (list_slot == nullptr) { return; }
-  const std::lock_guard<std::mutex> lock(g_mu);
+  const MutatorScope scope;
   auto* list = *list_slot;
   if (list == nullptr) {
     list = list_new_locked(kDefaultListCapacity);
@@ -909,6 +2991,7 @@ void list_push_slot(void** list_slot, void* elem) {
     for (std::size_t i = 0; i < len; ++i) { newItems[i] = items[i]; }     // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
     for (std::size_t i = len; i < newCap; ++i) { newItems[i] = nullptr; } // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
     // Update external slot; barrier records reference
+    copy_barrier(*list_slot);
     gc_pre_barrier(list_slot);
     gc_write_barrier(list_slot, bytes);
     *list_slot = bytes;
@@ -919,7 +3002,6 @@ void list_push_slot(void** list_slot, void* elem) {
   items[len] = elem;           // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
   gc_write_barrier(&items[len], elem); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
   meta[0] = len + 1; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-  maybe_request_bg_gc_unlocked();
 }
 
 std::size_t list_len(void* list) {
@@ -939,7 +3021,7 @@ void* list_get(void* list, std::size_t index) {
 
 void list_set(void* list, std::size_t index, void* value) {
   if (list == nullptr) { return; }
-  const std::lock_guard<std::mutex> lock(g_mu);
+  const MutatorScope scope;
   auto* meta = reinterpret_cast<std::size_t*>(list); // NOLINT
   const std::size_t len = meta[0];
   if (index >= len) { return; }
@@ -949,112 +3031,140 @@ void list_set(void* list, std::size_t index, void* value) {
   gc_write_barrier(&items[index], value);
 }
 
-// Dicts: open-addressed hash table (linear probe, pointer-identity keys)
-static std::size_t ptr_hash(void* p) {
-  auto v = reinterpret_cast<std::uintptr_t>(p);
+// Dicts: dense insertion-ordered entries behind an open-addressed index (linear probe), as in
+// CPython. Strings and numbers are keys by value, as in Python (1, 1.0 and True are one key);
+// every other object by identity.
+static std::size_t mix_hash(uint64_t v) {
   // 64-bit mix
   v ^= v >> 33; v *= 0xff51afd7ed558ccdULL; v ^= v >> 33; v *= 0xc4ceb9fe1a85ec53ULL; v ^= v >> 33;
   return static_cast<std::size_t>(v);
 }
 
+static std::size_t ptr_hash(void* p) { return mix_hash(reinterpret_cast<std::uintptr_t>(p)); }
+
+// A float equal to an int64 is the same key as that int
+static bool float_as_int(double d, int64_t& out) {
+  constexpr double kTwo63 = 9223372036854775808.0;
+  if (!(d >= -kTwo63 && d < kTwo63) || d != std::trunc(d)) { return false; }
+  out = static_cast<int64_t>(d);
+  return true;
+}
+
+static std::size_t dict_key_hash(void* key) {
+  switch (value_tag(key)) {
+    case TypeTag::String: return string_hash(key);
+    case TypeTag::Int:
+    case TypeTag::Bool: return mix_hash(static_cast<uint64_t>(box_int_value(key)));
+    case TypeTag::Float: {
+      const double d = box_float_value(key);
+      int64_t asInt = 0;
+      if (float_as_int(d, asInt)) { return mix_hash(static_cast<uint64_t>(asInt)); }
+      uint64_t bits = 0; std::memcpy(&bits, &d, sizeof(bits));
+      return mix_hash(bits);
+    }
+    default: return ptr_hash(key);
+  }
+}
+
+static bool dict_keys_equal(void* a, void* b) {
+  if (a == b) { return true; }
+  const TypeTag ta = value_tag(a);
+  const TypeTag tb = value_tag(b);
+  if (ta == TypeTag::String || tb == TypeTag::String) { return ta == tb && string_hash(a) == string_hash(b) && string_eq(a, b); }
+  const auto numeric = [](TypeTag t) { return t == TypeTag::Int || t == TypeTag::Float || t == TypeTag::Bool; };
+  if (!numeric(ta) || !numeric(tb)) { return false; }
+  if (ta != TypeTag::Float && tb != TypeTag::Float) { return box_int_value(a) == box_int_value(b); }
+  if (ta == TypeTag::Float && tb == TypeTag::Float) { return box_float_value(a) == box_float_value(b); }
+  int64_t asInt = 0;
+  return float_as_int(box_float_value(ta == TypeTag::Float ? a : b), asInt) && asInt == box_int_value(ta == TypeTag::Float ? b : a);
+}
+
 static void* dict_new_locked(std::size_t capacity) {
-  if (capacity < 8) { capacity = 8; }
-  const std::size_t payloadSize = (sizeof(std::size_t) * 3) + (capacity * sizeof(void*)) + (capacity * sizeof(void*));
-  auto* bytes = static_cast<unsigned char*>(alloc_raw(payloadSize, TypeTag::Dict));
+  const std::size_t cap = std::bit_ceil(std::max<std::size_t>(capacity, 8));
+  auto* bytes = static_cast<unsigned char*>(alloc_raw(dict_payload_size(cap), TypeTag::Dict));
   auto* meta = reinterpret_cast<std::size_t*>(bytes);
-  meta[0] = 0; meta[1] = capacity; meta[2] = 0; // len, cap, ver
-  auto** keys = reinterpret_cast<void**>(meta + 3);
-  auto** vals = keys + capacity;
-  for (std::size_t i = 0; i < capacity; ++i) { keys[i] = nullptr; vals[i] = nullptr; }
-  maybe_request_bg_gc_unlocked();
+  meta[0] = 0; meta[1] = cap; meta[2] = 0; meta[3] = 0; // len, cap, ver, used
+  std::fill_n(dict_keys(meta), 2U * dict_usable(cap), nullptr);
+  std::fill_n(dict_index(meta), cap, kDictEmpty);
   return bytes;
 }
 
 void* dict_new(std::size_t capacity) {
-  const std::lock_guard<std::mutex> lock(g_mu);
+  const MutatorScope scope;
   return dict_new_locked(capacity);
 }
 
 static void dict_rehash(void** dict_slot, std::size_t newCap) {
   auto* old = *dict_slot;
   auto* meta = reinterpret_cast<std::size_t*>(old);
-  const std::size_t cap = meta[1];
-  auto** keys = reinterpret_cast<void**>(meta + 3);
-  auto** vals = keys + cap;
-  auto* bytes = static_cast<unsigned char*>(alloc_raw((sizeof(std::size_t) * 3) + (newCap * sizeof(void*)) + (newCap * sizeof(void*)), TypeTag::Dict));
+  auto* bytes = static_cast<unsigned char*>(alloc_raw(dict_payload_size(newCap), TypeTag::Dict));
   auto* nmeta = reinterpret_cast<std::size_t*>(bytes);
-  nmeta[0] = 0; nmeta[1] = newCap; nmeta[2] = meta[2] + 1; // bump version on rehash
-  auto** nkeys = reinterpret_cast<void**>(nmeta + 3);
-  auto** nvals = nkeys + newCap;
-  for (std::size_t i = 0; i < newCap; ++i) { nkeys[i] = nullptr; nvals[i] = nullptr; }
-  // reinsertion
-  for (std::size_t i = 0; i < cap; ++i) {
-    if (keys[i] == nullptr) continue;
-    std::size_t idx = ptr_hash(keys[i]) & (newCap - 1);
-    while (nkeys[idx] != nullptr) { idx = (idx + 1) & (newCap - 1); }
-    nkeys[idx] = keys[i]; nvals[idx] = vals[i]; nmeta[0]++;
-  }
+  nmeta[0] = meta[0]; nmeta[1] = newCap; nmeta[2] = meta[2] + 1; nmeta[3] = meta[3];
+  // The dense entries move over as they are, in order; only the index is rebuilt
+  const std::size_t used = meta[3];
+  const std::size_t usable = dict_usable(newCap);
+  std::copy_n(dict_keys(meta), used, dict_keys(nmeta));
+  std::fill_n(dict_keys(nmeta) + used, usable - used, nullptr);
+  std::copy_n(dict_vals(meta), used, dict_vals(nmeta));
+  std::fill_n(dict_vals(nmeta) + used, usable - used, nullptr);
+  dict_rehash_in_place(nmeta);
+  meta[2] = meta[2] + 1; // iterators still walking the old table see the change
+  copy_barrier(old);
   gc_pre_barrier(dict_slot);
   gc_write_barrier(dict_slot, bytes);
   *dict_slot = bytes;
 }
 
+// Index slot holding the entry of key, or the empty slot that ends its probe. The probe ends
+// there because equal keys hash alike wherever they were built.
+static std::size_t dict_find_slot(std::size_t* meta, void* key, std::size_t hash) {
+  const std::size_t mask = meta[1] - 1;
+  auto* const* keys = dict_keys(meta);
+  const int32_t* index = dict_index(meta);
+  std::size_t slot = hash & mask;
+  for (;;) {
+    const int32_t ix = index[slot];
+    if (ix == kDictEmpty || dict_keys_equal(keys[ix], key)) { return slot; }
+    slot = (slot + 1) & mask;
+  }
+}
+
 void dict_set(void** dict_slot, void* key, void* value) {
   if (dict_slot == nullptr) { return; }
-  const std::lock_guard<std::mutex> lock(g_mu);
+  const MutatorScope scope;
   if (*dict_slot == nullptr) { *dict_slot = dict_new_locked(8); }
   auto* meta = reinterpret_cast<std::size_t*>(*dict_slot);
-  std::size_t len = meta[0]; const std::size_t cap = meta[1];
-  auto** keys = reinterpret_cast<void**>(meta + 3);
-  auto** vals = keys + cap;
-  // grow if load factor > 0.7 (cap should be power of two for masking)
-  if ((len + 1) * 10 > cap * 7) { dict_rehash(dict_slot, cap * 2); meta = reinterpret_cast<std::size_t*>(*dict_slot); len = meta[0]; }
-  const std::size_t ncap = meta[1]; keys = reinterpret_cast<void**>(meta + 3); vals = keys + ncap;
-  std::size_t idx = ptr_hash(key) & (ncap - 1);
-  while (true) {
-    if (keys[idx] == nullptr || keys[idx] == key) {
-      if (keys[idx] == nullptr) { meta[0] = len + 1; }
-      gc_pre_barrier(&keys[idx]); keys[idx] = key; gc_write_barrier(&keys[idx], key);
-      gc_pre_barrier(&vals[idx]); vals[idx] = value; gc_write_barrier(&vals[idx], value);
-      // bump version on any set (insert or update)
-      meta[2] = meta[2] + 1;
-      break;
-    }
-    idx = (idx + 1) & (ncap - 1);
+  const std::size_t hash = dict_key_hash(key);
+  std::size_t slot = dict_find_slot(meta, key, hash);
+  const int32_t ix = dict_index(meta)[slot];
+  if (ix != kDictEmpty) {
+    // An equal key already present stays, as in Python; only its value changes
+    void** v = &dict_vals(meta)[ix];
+    gc_pre_barrier(v); *v = value; gc_write_barrier(v, value);
+    return;
   }
-  maybe_request_bg_gc_unlocked();
+  // Grow once the dense entries are full (2/3 of the index slots)
+  if (meta[3] == dict_usable(meta[1])) {
+    dict_rehash(dict_slot, meta[1] * 2);
+    meta = reinterpret_cast<std::size_t*>(*dict_slot);
+    slot = dict_find_slot(meta, key, hash);
+  }
+  const std::size_t pos = meta[3];
+  void** k = &dict_keys(meta)[pos];
+  void** v = &dict_vals(meta)[pos];
+  gc_pre_barrier(k); *k = key; gc_write_barrier(k, key);
+  gc_pre_barrier(v); *v = value; gc_write_barrier(v, value);
+  dict_index(meta)[slot] = static_cast<int32_t>(pos);
+  meta[3] = pos + 1;
+  meta[0] = meta[0] + 1;
+  meta[2] = meta[2] + 1; // version: a new key changes the size
 }
 
 void* dict_get(void* dict, void* key) {
   if (dict == nullptr) { return nullptr; }
   auto* meta = reinterpret_cast<std::size_t*>(dict);
-  const std::size_t cap = meta[1];
-  auto** keys = reinterpret_cast<void**>(meta + 3);
-  auto** vals = keys + cap;
-  // Fast path: pointer-identity lookup via open addressing
-  std::size_t idx = ptr_hash(key) & (cap - 1);
-  for (;;) {
-    void* k = keys[idx];
-    if (k == nullptr) { break; }
-    if (k == key) { return vals[idx]; }
-    idx = (idx + 1) & (cap - 1);
-  }
-  // Fallback for string keys: allow lookup by string contents to interoperate with fresh string objects
-  // Inspect header tag to detect string keys without relying on later helper
-  bool key_is_string = false;
-  if (key != nullptr) {
-    auto* hk = reinterpret_cast<ObjectHeader*>(reinterpret_cast<unsigned char*>(key) - sizeof(ObjectHeader));
-    key_is_string = (static_cast<TypeTag>(hk->tag) == TypeTag::String);
-  }
-  if (key_is_string) {
-    for (std::size_t i = 0; i < cap; ++i) {
-      void* kk = keys[i];
-      if (kk == nullptr) { continue; }
-      auto* hk2 = reinterpret_cast<ObjectHeader*>(reinterpret_cast<unsigned char*>(kk) - sizeof(ObjectHeader));
-      if (static_cast<TypeTag>(hk2->tag) == TypeTag::String && string_eq(kk, key)) { return vals[i]; }
-    }
-  }
-  return nullptr;
+  const int32_t ix = dict_index(meta)[dict_find_slot(meta, key, dict_key_hash(key))];
+  return (ix == kDictEmpty) ? nullptr : dict_vals(meta)[ix];
 }
 
 std::size_t dict_len(void* dict) {
@@ -1063,68 +3173,211 @@ std::size_t dict_len(void* dict) {
   return meta[0];
 }
 
+DictEntries dict_entries_public(void* dict) {
+  if (dict == nullptr) { return {}; }
+  auto* meta = reinterpret_cast<std::size_t*>(dict);
+  return {dict_keys(meta), dict_vals(meta), meta[3]};
+}
+
 extern "C" void* pycc_dict_iter_new(void* dict) {
-  // Build a stable snapshot list of keys. We avoid holding runtime-global locks while allocating.
-  // If the dict mutates during snapshot, retry a few times to capture a consistent view.
-  void* snap = list_new(8);
-  if (dict != nullptr) {
-    for (int attempt = 0; attempt < 3; ++attempt) {
-      // Create a fresh list for this attempt
-      snap = list_new(8);
-      auto* meta = reinterpret_cast<std::size_t*>(dict);
-      const std::size_t cap = meta[1];
-      const std::size_t ver = meta[2];
-      auto** keys = reinterpret_cast<void**>(meta + 3);
-      for (std::size_t i = 0; i < cap; ++i) {
-        void* k = keys[i];
-        if (k != nullptr) { list_push_slot(&snap, k); }
-      }
-      // Verify no mutation occurred during snapshot
-      auto* meta2 = reinterpret_cast<std::size_t*>(dict);
-      if (meta2[2] == ver) { break; }
-      // else retry
-    }
-  }
-  // Iterator layout: values[0] = snapshot list ptr, values[1] = next index (boxed int)
-  void* it = object_new(2);
+  // Iterator fields: the dict, the next entry position, and the dict's version when iteration
+  // began. Positions and versions are immediate ints, so stepping allocates nothing.
+  void* it = object_new(3);
   auto* meta_it = reinterpret_cast<std::size_t*>(it);
   auto** vals_it = reinterpret_cast<void**>(meta_it + 1);
-  gc_pre_barrier(&vals_it[0]); vals_it[0] = snap; gc_write_barrier(&vals_it[0], snap);
-  void* zero = box_int(0);
-  gc_pre_barrier(&vals_it[1]); vals_it[1] = zero; gc_write_barrier(&vals_it[1], zero);
+  gc_pre_barrier(&vals_it[0]); vals_it[0] = dict; gc_write_barrier(&vals_it[0], dict);
+  vals_it[1] = box_int(0);
+  vals_it[2] = box_int(dict == nullptr ? 0 : static_cast<int64_t>(reinterpret_cast<std::size_t*>(dict)[2]));
   return it;
 }
 
 extern "C" void* pycc_dict_iter_next(void* it) {
   if (it == nullptr) { return nullptr; }
-  // Do not hold g_mu while allocating box_int; iterate over a stable snapshot list.
   auto* meta_it = reinterpret_cast<std::size_t*>(it);
   auto** vals_it = reinterpret_cast<void**>(meta_it + 1);
-  void* snap = vals_it[0]; if (snap == nullptr) return nullptr;
-  const std::size_t n = list_len(snap);
-  std::size_t idx = static_cast<std::size_t>(box_int_value(vals_it[1]));
-  if (idx >= n) {
-    void* endIdx = box_int(static_cast<int64_t>(n));
-    gc_pre_barrier(&vals_it[1]);
-    vals_it[1] = endIdx;
-    gc_write_barrier(&vals_it[1], endIdx);
+  void* dict = vals_it[0];
+  if (dict == nullptr) { return nullptr; }
+  auto* meta = reinterpret_cast<std::size_t*>(dict);
+  if (static_cast<std::size_t>(box_int_value(vals_it[2])) != meta[2]) {
+    rt_raise("RuntimeError", "dictionary changed size during iteration");
     return nullptr;
   }
-  void* k = list_get(snap, static_cast<int64_t>(idx));
-  void* nextIdx = box_int(static_cast<int64_t>(idx + 1));
-  gc_pre_barrier(&vals_it[1]);
-  vals_it[1] = nextIdx;
-  gc_write_barrier(&vals_it[1], nextIdx);
-  return k;
+  // Walk the dense entries in insertion order
+  const auto pos = static_cast<std::size_t>(box_int_value(vals_it[1]));
+  if (pos >= meta[3]) { return nullptr; }
+  vals_it[1] = box_int(static_cast<int64_t>(pos + 1)); // immediate: no barrier
+  return dict_keys(meta)[pos];
 }
 
 // C++ API wrappers to match header declarations
 void* dict_iter_new(void* dict) { return pycc_dict_iter_new(dict); }
 void* dict_iter_next(void* it) { return pycc_dict_iter_next(it); }
 
+// Sets: dense insertion-ordered elements behind an open-addressed index, hashed and compared
+// like dict keys, so membership is one probe sequence rather than a scan.
+static void* set_new_locked(std::size_t capacity) {
+  const std::size_t cap = std::bit_ceil(std::max<std::size_t>(capacity, 8));
+  auto* bytes = static_cast<unsigned char*>(alloc_raw(set_payload_size(cap), TypeTag::Set));
+  auto* meta = reinterpret_cast<std::size_t*>(bytes);
+  meta[0] = 0; meta[1] = cap; meta[2] = 0; meta[3] = 0; // len, cap, ver, used
+  std::fill_n(dict_keys(meta), dict_usable(cap), nullptr);
+  std::fill_n(set_index(meta), cap, kDictEmpty);
+  return bytes;
+}
+
+void* set_new(std::size_t capacity) {
+  const MutatorScope scope;
+  return set_new_locked(capacity);
+}
+
+// Index slot holding elem's entry, or the empty slot that ends its probe (dummies are skipped).
+static std::size_t set_find_slot(std::size_t* meta, void* elem, std::size_t hash) {
+  const std::size_t mask = meta[1] - 1;
+  auto* const* entries = dict_keys(meta);
+  const int32_t* index = set_index(meta);
+  std::size_t slot = hash & mask;
+  for (;;) {
+    const int32_t ix = index[slot];
+    if (ix == kDictEmpty || (ix >= 0 && dict_keys_equal(entries[ix], elem))) { return slot; }
+    slot = (slot + 1) & mask;
+  }
+}
+
+// Copy the live elements, in order, into a table sized for twice as many; drops the holes
+// discarded elements left behind.
+static void set_resize(void** set_slot) {
+  auto* old = *set_slot;
+  auto* meta = reinterpret_cast<std::size_t*>(old);
+  auto* bytes = static_cast<unsigned char*>(set_new_locked((meta[0] + 1) * 3));
+  auto* nmeta = reinterpret_cast<std::size_t*>(bytes);
+  auto* const* entries = dict_keys(meta);
+  auto** nentries = dict_keys(nmeta);
+  std::size_t used = 0;
+  for (std::size_t i = 0; i < meta[3]; ++i) {
+    if (entries[i] != nullptr) { nentries[used++] = entries[i]; }
+  }
+  nmeta[0] = meta[0]; nmeta[2] = meta[2] + 1; nmeta[3] = used;
+  set_rehash_in_place(nmeta);
+  meta[2] = meta[2] + 1; // iterators still walking the old table see the change
+  copy_barrier(old);
+  gc_pre_barrier(set_slot);
+  gc_write_barrier(set_slot, bytes);
+  *set_slot = bytes;
+}
+
+void set_add(void** set_slot, void* elem) {
+  if (set_slot == nullptr) { return; }
+  const MutatorScope scope;
+  if (*set_slot == nullptr) { *set_slot = set_new_locked(8); }
+  auto* meta = reinterpret_cast<std::size_t*>(*set_slot);
+  const std::size_t hash = dict_key_hash(elem);
+  std::size_t slot = set_find_slot(meta, elem, hash);
+  if (set_index(meta)[slot] != kDictEmpty) { return; } // an equal element stays
+  if (meta[3] == dict_usable(meta[1])) {
+    set_resize(set_slot);
+    meta = reinterpret_cast<std::size_t*>(*set_slot);
+    slot = set_find_slot(meta, elem, hash);
+  }
+  const std::size_t pos = meta[3];
+  void** entry = &dict_keys(meta)[pos];
+  gc_pre_barrier(entry); *entry = elem; gc_write_barrier(entry, elem);
+  set_index(meta)[slot] = static_cast<int32_t>(pos);
+  meta[3] = pos + 1;
+  meta[0] = meta[0] + 1;
+  meta[2] = meta[2] + 1;
+}
+
+bool set_discard(void* set, void* elem) {
+  if (set == nullptr) { return false; }
+  const MutatorScope scope;
+  auto* meta = reinterpret_cast<std::size_t*>(set);
+  const std::size_t slot = set_find_slot(meta, elem, dict_key_hash(elem));
+  int32_t* index = set_index(meta);
+  if (index[slot] == kDictEmpty) { return false; }
+  void** entry = &dict_keys(meta)[index[slot]];
+  gc_pre_barrier(entry); *entry = nullptr;
+  index[slot] = kSetDummy; // keeps the probe runs through this slot intact
+  meta[0] = meta[0] - 1;
+  meta[2] = meta[2] + 1;
+  return true;
+}
+
+bool set_contains(void* set, void* elem) {
+  if (set == nullptr) { return false; }
+  auto* meta = reinterpret_cast<std::size_t*>(set);
+  return set_index(meta)[set_find_slot(meta, elem, dict_key_hash(elem))] != kDictEmpty;
+}
+
+std::size_t set_len(void* set) {
+  if (set == nullptr) { return 0; }
+  return reinterpret_cast<std::size_t*>(set)[0];
+}
+
+// Add the elements of src that pass keep to *out, in src's order.
+template <typename Keep>
+static void set_add_filtered(void** out, void* src, Keep keep) {
+  if (src == nullptr) { return; }
+  auto* meta = reinterpret_cast<std::size_t*>(src);
+  for (std::size_t i = 0; i < meta[3]; ++i) {
+    void* elem = dict_keys(meta)[i];
+    if (elem != nullptr && keep(elem)) { set_add(out, elem); }
+  }
+}
+
+void* set_union(void* a, void* b) {
+  void* out = set_new((set_len(a) + set_len(b)) * 3 / 2);
+  set_add_filtered(&out, a, [](void*) { return true; });
+  set_add_filtered(&out, b, [](void*) { return true; });
+  return out;
+}
+
+void* set_intersection(void* a, void* b) {
+  // Walk the smaller set, probe the larger
+  void* small = set_len(b) < set_len(a) ? b : a;
+  void* large = small == a ? b : a;
+  void* out = set_new(set_len(small) * 3 / 2);
+  set_add_filtered(&out, small, [large](void* elem) { return set_contains(large, elem); });
+  return out;
+}
+
+void* set_difference(void* a, void* b) {
+  void* out = set_new(set_len(a) * 3 / 2);
+  set_add_filtered(&out, a, [b](void* elem) { return !set_contains(b, elem); });
+  return out;
+}
+
+void* set_iter_new(void* set) {
+  // Iterator fields: the set, the next entry position and the set's version when iteration began
+  void* it = object_new(3);
+  auto* meta_it = reinterpret_cast<std::size_t*>(it);
+  auto** vals_it = reinterpret_cast<void**>(meta_it + 1);
+  gc_pre_barrier(&vals_it[0]); vals_it[0] = set; gc_write_barrier(&vals_it[0], set);
+  vals_it[1] = box_int(0);
+  vals_it[2] = box_int(set == nullptr ? 0 : static_cast<int64_t>(reinterpret_cast<std::size_t*>(set)[2]));
+  return it;
+}
+
+void* set_iter_next(void* it) {
+  if (it == nullptr) { return nullptr; }
+  auto* meta_it = reinterpret_cast<std::size_t*>(it);
+  auto** vals_it = reinterpret_cast<void**>(meta_it + 1);
+  void* set = vals_it[0];
+  if (set == nullptr) { return nullptr; }
+  auto* meta = reinterpret_cast<std::size_t*>(set);
+  if (static_cast<std::size_t>(box_int_value(vals_it[2])) != meta[2]) {
+    rt_raise("RuntimeError", "Set changed size during iteration");
+    return nullptr;
+  }
+  auto pos = static_cast<std::size_t>(box_int_value(vals_it[1]));
+  while (pos < meta[3] && dict_keys(meta)[pos] == nullptr) { ++pos; } // discarded
+  if (pos >= meta[3]) { return nullptr; }
+  vals_it[1] = box_int(static_cast<int64_t>(pos + 1)); // immediate: no barrier
+  return dict_keys(meta)[pos];
+}
+
 // Objects (fixed-size field table)
 void* object_new(std::size_t field_count) {
-  const std::lock_guard<std::mutex> lock(g_mu);
+  const MutatorScope scope;
   // Allocate extra slot for per-instance attribute dict pointer at values[fields]
   const std::size_t payloadSize = sizeof(std::size_t) + ((field_count + 1) * sizeof(void*)); // fields, values[] (+attrs)
   auto* bytes = static_cast<unsigned char*>(alloc_raw(payloadSize, TypeTag::Object));
@@ -1132,13 +3385,12 @@ void* object_new(std::size_t field_count) {
   meta[0] = field_count; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
   auto** vals = reinterpret_cast<void**>(meta + 1); // NOLINT
   for (std::size_t i = 0; i < field_count + 1; ++i) { vals[i] = nullptr; } // values + attrs slot
-  maybe_request_bg_gc_unlocked();
   return bytes;
 }
 
 void object_set(void* obj, std::size_t index, void* value) {
   if (obj == nullptr) { return; }
-  const std::lock_guard<std::mutex> lock(g_mu);
+  const MutatorScope scope;
   auto* meta = reinterpret_cast<std::size_t*>(obj); // NOLINT
   const std::size_t fields = meta[0]; // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
   if (index >= fields) { return; }
@@ -1179,9 +3431,9 @@ void* object_get_attr_dict(void* obj) {
 void object_set_attr(void* obj, void* key_string, void* value) {
   if (obj == nullptr || key_string == nullptr) { return; }
   auto** slot = object_attrs_slot(obj);
-  // Ensure attribute dict exists under g_mu, but perform dict_set without holding it to avoid re-entrant deadlock
+  // Ensure attribute dict exists, then let dict_set open its own allocation scope
   {
-    const std::lock_guard<std::mutex> lock(g_mu);
+    const MutatorScope scope;
     if (*slot == nullptr) {
       // lazily create dict
       void* d = dict_new_locked(8);
@@ -1190,28 +3442,46 @@ void object_set_attr(void* obj, void* key_string, void* value) {
       *slot = d;
     }
   }
-  // set into dict (dict_set acquires g_mu internally)
   dict_set(slot, key_string, value);
 }
 
 void* object_get_attr(void* obj, void* key_string) {
   if (obj == nullptr || key_string == nullptr) { return nullptr; }
-  const std::lock_guard<std::mutex> lock(g_mu);
+  const MutatorScope scope;
   auto** slot = object_attrs_slot(obj);
   if (*slot == nullptr) { return nullptr; }
   return dict_get(*slot, key_string);
 }
 GcTelemetry gc_telemetry() {
-  uint64_t live_now = 0; std::size_t thr = 0;
+  uint64_t live_now = 0; std::size_t thr = 0; std::size_t goal = 0; double rate = 0.0;
   {
-    const std::lock_guard<std::mutex> lock(g_mu);
+    lock_parked();
+    const std::lock_guard<std::mutex> lock(g_mu, std::adopt_lock);
     live_now = g_stats.bytesLive;
     thr = g_threshold;
+    goal = g_threshold_pinned ? g_threshold : g_heap_goal;
+    rate = g_ewma_alloc_rate;
   }
   const double pressure = (thr != 0U) ? (static_cast<double>(live_now) / static_cast<double>(thr)) : 0.0;
-  const double bps = g_ewma_alloc_rate * 1000.0; // bytes/ms -> bytes/s
-  return GcTelemetry{bps, pressure};
+  const double bps = rate * 1000.0; // bytes/ms -> bytes/s
+  return GcTelemetry{bps, pressure, g_pause_hist.summary(), g_mark_hist.summary(), g_sweep_hist.summary(),
+                     static_cast<uint64_t>(thr), static_cast<uint64_t>(goal)};
+}
+
+extern "C" void pycc_gc_get_timings(pycc_gc_timings* out) {
+  if (out == nullptr) { return; }
+  const auto fill = [](pycc_gc_pause_summary& dst, const GcPauseSummary& src) {
+    dst = pycc_gc_pause_summary{src.count, src.p50Ns, src.p90Ns, src.p99Ns, src.maxNs};
+  };
+  fill(out->pause, g_pause_hist.summary());
+  fill(out->mark, g_mark_hist.summary());
+  fill(out->sweep, g_sweep_hist.summary());
 }
+
+extern "C" void pycc_gc_set_heap_target(size_t bytes) { gc_set_heap_target(bytes); }
+extern "C" void pycc_gc_set_heap_growth(int percent) { gc_set_heap_growth(percent); }
+extern "C" size_t pycc_gc_scavenge(void) { return gc_scavenge(); }
+extern "C" int pycc_gc_heap_profile_dump(const char* path) { return gc_heap_profile_dump(path) ? 1 : 0; }
 static void adapt_controller() {
   // Heuristics with EWMA smoothing
   const uint64_t now_ms = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -1230,15 +3500,20 @@ static void adapt_controller() {
   g_last_bytes_alloc.store(alloc_now, std::memory_order_relaxed);
 
   const double alloc_rate = static_cast<double>(delta_alloc) / static_cast<double>(delta_ms + 1U); // bytes/ms
-  double pressure = 0.0;
+  const uint64_t cycle_ns = g_last_cycle_ns.exchange(0, std::memory_order_relaxed);
+  // EWMA smoothing to avoid oscillations
+  constexpr double alpha = 0.2;
   {
     const std::lock_guard<std::mutex> lock(g_mu);
-    pressure = (g_threshold != 0U) ? (static_cast<double>(g_stats.bytesLive) / static_cast<double>(g_threshold)) : 0.0;
+    const double pressure = (g_threshold != 0U) ? (static_cast<double>(g_stats.bytesLive) / static_cast<double>(g_threshold)) : 0.0;
+    g_ewma_alloc_rate = (alpha * alloc_rate) + ((1.0 - alpha) * g_ewma_alloc_rate);
+    g_ewma_pressure = (alpha * pressure) + ((1.0 - alpha) * g_ewma_pressure);
+    if (cycle_ns != 0U) {
+      const double cycle_ms = static_cast<double>(cycle_ns) / 1e6;
+      g_ewma_cycle_ms = (g_ewma_cycle_ms == 0.0) ? cycle_ms : (alpha * cycle_ms) + ((1.0 - alpha) * g_ewma_cycle_ms);
+    }
+    pace_next_trigger_locked(); // the runway below the goal follows the allocation rate
   }
-  // EWMA smoothing to avoid oscillations
-  constexpr double alpha = 0.2;
-  g_ewma_alloc_rate = (alpha * alloc_rate) + ((1.0 - alpha) * g_ewma_alloc_rate);
-  g_ewma_pressure = (alpha * pressure) + ((1.0 - alpha) * g_ewma_pressure);
 
   // Adjust slice and sweep batch
   uint64_t slice = g_slice_us.load(std::memory_order_relaxed);
@@ -1249,6 +3524,9 @@ static void adapt_controller() {
   } else if (g_ewma_pressure < kLowPressure && g_ewma_alloc_rate < kLowAllocRateBytesPerMs) { // < 0.5KB/ms
     slice = (slice > kSliceLowerTriggerUs) ? (slice - kSliceDecrementUs) : kSliceDefaultUs;
     batch = (batch > kBatchLowerTrigger) ? (batch - kBatchDecrement) : kBatchDefault;
+    // Quiet heap: let RSS follow the live set down after a spike
+    const std::lock_guard<std::mutex> lock(g_mu);
+    (void)scavenge_locked();
   }
   g_slice_us.store(slice, std::memory_order_relaxed);
   g_sweep_batch.store(batch, std::memory_order_relaxed);
@@ -1429,7 +3707,7 @@ void time_sleep(double seconds) {
   using namespace std::chrono;
   auto dur = duration<double>(seconds);
   auto ms = duration_cast<milliseconds>(dur);
-  std::this_thread::sleep_for(ms);
+  blocking_region([ms] { std::this_thread::sleep_for(ms); });
 }
 
 static void* make_iso8601_from_tm(const std::tm& tm, int sec) {
@@ -1520,14 +3798,13 @@ extern "C" void pycc_sys_exit(int code) { ::pycc::rt::sys_exit(code); }
 
 // Bytes (immutable)
 void* bytes_new(const void* data, std::size_t len) {
-  const std::lock_guard<std::mutex> lock(g_mu);
+  const MutatorScope scope;
   const std::size_t payloadSize = sizeof(BytesPayload) + len;
   auto* bytes = static_cast<unsigned char*>(alloc_raw(payloadSize, TypeTag::Bytes));
   auto* plen = reinterpret_cast<std::size_t*>(bytes);
   *plen = len;
   auto* buf = reinterpret_cast<unsigned char*>(plen + 1);
   if (len != 0U && data != nullptr) { std::memcpy(buf, data, len); }
-  maybe_request_bg_gc_unlocked();
   return bytes;
 }
 std::size_t bytes_len(void* obj) {
@@ -1696,7 +3973,7 @@ extern "C" void* pycc_bytes_decode(void* b, const char* enc, const char* err) {
 
 // ByteArray (mutable)
 void* bytearray_new(std::size_t len) {
-  const std::lock_guard<std::mutex> lock(g_mu);
+  const MutatorScope scope;
   std::size_t cap = std::max<std::size_t>(len, 8);
   const std::size_t payloadSize = sizeof(ByteArrayPayload) + cap;
   auto* bytes = static_cast<unsigned char*>(alloc_raw(payloadSize, TypeTag::ByteArray));
@@ -1704,7 +3981,6 @@ void* bytearray_new(std::size_t len) {
   hdr[0] = len; hdr[1] = cap;
   auto* buf = reinterpret_cast<unsigned char*>(hdr + 2);
   std::memset(buf, 0, cap);
-  maybe_request_bg_gc_unlocked();
   return bytes;
 }
 void* bytearray_from_bytes(void* b) {
@@ -1724,17 +4000,7 @@ void bytearray_set(void* obj, std::size_t index, int value) {
 void bytearray_append(void* obj, int value) {
   if (!obj) return; auto* hdr = reinterpret_cast<std::size_t*>(obj); auto* buf = bytearray_buf(obj); std::size_t len = hdr[0], cap = hdr[1];
   if (len + 1 > cap) {
-    // grow: allocate new payload, copy, free old, re-link header
-    std::size_t ncap = cap * 2;
-    const std::size_t payloadSize = sizeof(ByteArrayPayload) + ncap;
-    auto* bytes = static_cast<unsigned char*>(alloc_raw(payloadSize, TypeTag::ByteArray));
-    auto* nhdr = reinterpret_cast<std::size_t*>(bytes);
-    nhdr[0] = len; nhdr[1] = ncap;
-    auto* nbuf = reinterpret_cast<unsigned char*>(nhdr + 2);
-    std::memcpy(nbuf, buf, len);
-    // replace header in-place: this object identity changes; for simplicity, we just mutate hdr fields and keep existing buffer if space permits
-    // In this minimal runtime, do not grow beyond capacity; ignore append when full.
-    free_obj(reinterpret_cast<ObjectHeader*>(bytes));
+    // In this minimal runtime, do not grow beyond capacity (object identity would change); ignore append when full.
     return;
   }
   buf[len] = static_cast<unsigned char>(value & 0xFF); hdr[0] = len + 1;
@@ -2237,15 +4503,25 @@ RtThreadHandle* rt_spawn(RtStart fn, const void* payload, std::size_t len) {
   // Copy payload bytes
   std::vector<unsigned char> pay;
   if (payload && len > 0) { pay.assign(static_cast<const unsigned char*>(payload), static_cast<const unsigned char*>(payload) + len); }
+  trace_event(TraceKind::ThreadSpawn, TracePhase::Instant);
   h->t = std::thread([h, fn, pay = std::move(pay)]() mutable {
     void* retPtr = nullptr;
     std::size_t retLen = 0;
-    // Run entry
-    fn(pay.empty() ? nullptr : pay.data(), pay.size(), &retPtr, &retLen);
-    // Marshal return as bytes if provided
-    if (retPtr != nullptr && retLen > 0) {
-      h->retBuf.resize(retLen);
-      std::memcpy(h->retBuf.data(), retPtr, retLen);
+    {
+      const TraceScope trace(TraceKind::ThreadRun);
+      // The worker allocates from its own heap, which is collected on this thread and
+      // unmapped when the entry returns
+      LocalHeap heap;
+      heap.stackTop = reinterpret_cast<const std::uintptr_t*>(&heap); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+      t_local_heap = &heap;
+      // Run entry
+      fn(pay.empty() ? nullptr : pay.data(), pay.size(), &retPtr, &retLen);
+      // Marshal return as bytes if provided
+      if (retPtr != nullptr && retLen > 0) {
+        h->retBuf.resize(retLen);
+        std::memcpy(h->retBuf.data(), retPtr, retLen);
+      }
+      t_local_heap = nullptr;
     }
     {
       std::lock_guard<std::mutex> lk(h->mu);
@@ -2259,11 +4535,13 @@ RtThreadHandle* rt_spawn(RtStart fn, const void* payload, std::size_t len) {
 bool rt_join(RtThreadHandle* handle, void** ret, std::size_t* ret_len) {
   if (!handle) return false;
   auto* h = reinterpret_cast<ThreadHandle*>(handle);
-  {
+  const TraceScope trace(TraceKind::ThreadJoin);
+  blocking_region([h] {
     std::unique_lock<std::mutex> lk(h->mu);
     h->cv.wait(lk, [&]{ return h->done; });
-  }
-  if (h->t.joinable()) h->t.join();
+    lk.unlock();
+    if (h->t.joinable()) h->t.join();
+  });
   if (ret && ret_len) {
     if (!h->retBuf.empty()) {
       *ret_len = h->retBuf.size();
@@ -2283,37 +4561,88 @@ RtChannelHandle* chan_new(std::size_t capacity) { auto* ch = new Chan(); ch->cap
 void chan_close(RtChannelHandle* handle) {
   if (!handle) return; auto* ch = reinterpret_cast<Chan*>(handle); std::lock_guard<std::mutex> lk(ch->mu); ch->closed = true; ch->cv_not_empty.notify_all(); ch->cv_not_full.notify_all();
 }
+// Immortal objects belong to no heap and are shared between threads as they are.
+static bool is_immortal(const void* value) {
+  const auto* header = reinterpret_cast<const ObjectHeader*>(static_cast<const unsigned char*>(value) - sizeof(ObjectHeader)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  return (header->flags & kFlagImmortal) != 0U;
+}
+
+// Channel payloads travel through the shared message heap: a malloc'd copy with its own
+// header, which no collector can see and which the receiving side frees once adopted.
+static void* publish_message(void* value) {
+  if (value == nullptr || is_immediate(value) || is_immortal(value)) { return value; }
+  const auto* header = reinterpret_cast<const ObjectHeader*>(static_cast<unsigned char*>(value) - sizeof(ObjectHeader)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  HeapSpan* span = nullptr;
+  const std::size_t total = (find_object_for_pointer(value, span) != nullptr) ? object_size(span, header) : header->size;
+  auto* copy = static_cast<unsigned char*>(std::malloc(total)); // NOLINT(cppcoreguidelines-no-malloc)
+  if (copy == nullptr) { throw std::bad_alloc(); }
+  std::memcpy(copy, header, total);
+  g_published.fetch_add(1U, std::memory_order_relaxed);
+  return copy + sizeof(ObjectHeader); // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+}
+
+static void drop_message(void* message) {
+  if (message == nullptr || is_immediate(message) || is_immortal(message)) { return; }
+  std::free(static_cast<unsigned char*>(message) - sizeof(ObjectHeader)); // NOLINT(cppcoreguidelines-no-malloc,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+}
+
+// Move a received message into the calling thread's heap.
+static void* adopt_message(void* message) {
+  if (message == nullptr || is_immediate(message) || is_immortal(message)) { return message; }
+  const auto* header = reinterpret_cast<const ObjectHeader*>(static_cast<unsigned char*>(message) - sizeof(ObjectHeader)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast,cppcoreguidelines-pro-bounds-pointer-arithmetic)
+  const std::size_t payloadSize = header->size - sizeof(ObjectHeader);
+  void* out = nullptr;
+  {
+    const MutatorScope scope;
+    out = alloc_raw(payloadSize, static_cast<TypeTag>(header->tag));
+    std::memcpy(out, message, payloadSize);
+  }
+  drop_message(message);
+  return out;
+}
+
 void chan_send(RtChannelHandle* handle, void* value) {
   auto* ch = reinterpret_cast<Chan*>(handle); if (!ch) return;
   // Enforce cross-thread immutability/message-passing discipline: only immutable payloads (or nullptr).
   if (value != nullptr) {
-    auto* header = reinterpret_cast<ObjectHeader*>(reinterpret_cast<unsigned char*>(value) - sizeof(ObjectHeader));
-    const auto tag = static_cast<TypeTag>(header->tag);
+    const TypeTag tag = value_tag(value);
     const bool immutable = (tag == TypeTag::String) || (tag == TypeTag::Int) || (tag == TypeTag::Float) || (tag == TypeTag::Bool) || (tag == TypeTag::Bytes);
     if (!immutable) {
       rt_raise("TypeError", "chan_send: only immutable payloads (int/float/bool/str/bytes) allowed across threads");
       return;
     }
   }
-  std::unique_lock<std::mutex> lk(ch->mu);
-  //
-  ch->cv_not_full.wait(lk, [&]{ return ch->closed || ch->q.size() < ch->cap; });
-  if (ch->closed) return;
-  ch->q.push_back(value);
+  void* message = publish_message(value);
+  std::unique_lock<std::mutex> lk(ch->mu, std::defer_lock);
+  // The published copy lives outside the heap, so the wait can park this thread
+  blocking_region([&] {
+    lk.lock();
+    const auto ready = [&]{ return ch->closed || ch->q.size() < ch->cap; };
+    if (ready()) { return; }
+    const TraceScope trace(TraceKind::ChanSendBlocked);
+    ch->cv_not_full.wait(lk, ready);
+  });
+  if (ch->closed) { drop_message(message); return; }
+  ch->q.push_back(message);
   lk.unlock();
   ch->cv_not_empty.notify_one();
   //
 }
 void* chan_recv(RtChannelHandle* handle) {
   auto* ch = reinterpret_cast<Chan*>(handle); if (!ch) return nullptr;
-  std::unique_lock<std::mutex> lk(ch->mu);
-  //
-  ch->cv_not_empty.wait(lk, [&]{ return ch->closed || !ch->q.empty(); });
+  std::unique_lock<std::mutex> lk(ch->mu, std::defer_lock);
+  blocking_region([&] {
+    lk.lock();
+    const auto ready = [&]{ return ch->closed || !ch->q.empty(); };
+    if (ready()) { return; }
+    const TraceScope trace(TraceKind::ChanRecvBlocked);
+    ch->cv_not_empty.wait(lk, ready);
+  });
   if (ch->q.empty()) return nullptr; // closed
   void* v = ch->q.front(); ch->q.pop_front();
   lk.unlock(); ch->cv_not_full.notify_one();
   //
-  return v;
+  return adopt_message(v);
 }
 
 RtAtomicIntHandle* atomic_int_new(long long initial) { auto* a = new AtomicInt(); a->v.store(initial, std::memory_order_relaxed); return reinterpret_cast<RtAtomicIntHandle*>(a); }
@@ -2326,11 +4655,7 @@ long long atomic_int_add_fetch(RtAtomicIntHandle* h, long long d) { if (!h) retu
 // ===== JSON shims =====
 namespace pycc::rt {
 
-static TypeTag type_of(void* obj) {
-  if (!obj) return TypeTag::Object;
-  auto* h = reinterpret_cast<ObjectHeader*>(reinterpret_cast<unsigned char*>(obj) - sizeof(ObjectHeader));
-  return static_cast<TypeTag>(h->tag);
-}
+static TypeTag type_of(void* obj) { return value_tag(obj); }
 
 TypeTag type_of_public(void* obj) { return type_of(obj); }
 
@@ -3328,8 +5653,7 @@ static std::vector<unsigned char> as_bytes(void* obj) {
   std::vector<unsigned char> out;
   if (!obj) return out;
   // Determine tag
-  auto* h = reinterpret_cast<ObjectHeader*>(reinterpret_cast<unsigned char*>(obj) - sizeof(ObjectHeader));
-  TypeTag t = static_cast<TypeTag>(h->tag);
+  const TypeTag t = value_tag(obj);
   if (t == TypeTag::Bytes) {
     const unsigned char* d = bytes_data(obj);
     out.assign(d, d + bytes_len(obj));
@@ -3605,8 +5929,7 @@ namespace pycc::rt {
 
 static inline double num_value_for_heap(void* v) {
   if (!v) return 0.0;
-  auto* h = reinterpret_cast<ObjectHeader*>(reinterpret_cast<unsigned char*>(v) - sizeof(ObjectHeader));
-  switch (static_cast<TypeTag>(h->tag)) {
+  switch (value_tag(v)) {
     case TypeTag::Int: return static_cast<double>(box_int_value(v));
     case TypeTag::Float: return box_float_value(v);
     case TypeTag::Bool: return box_bool_value(v) ? 1.0 : 0.0;
@@ -3676,8 +5999,7 @@ namespace pycc::rt {
 
 static inline double to_num_for_bisect(void* v) {
   if (!v) return 0.0;
-  auto* h = reinterpret_cast<ObjectHeader*>(reinterpret_cast<unsigned char*>(v) - sizeof(ObjectHeader));
-  switch (static_cast<TypeTag>(h->tag)) {
+  switch (value_tag(v)) {
     case TypeTag::Int: return static_cast<double>(box_int_value(v));
     case TypeTag::Float: return box_float_value(v);
     case TypeTag::Bool: return box_bool_value(v) ? 1.0 : 0.0;
@@ -3820,8 +6142,7 @@ namespace pycc::rt {
 
 static inline bool to_num_for_stats(void* v, double& out) {
   if (!v) { out = 0.0; return false; }
-  auto* h = reinterpret_cast<ObjectHeader*>(reinterpret_cast<unsigned char*>(v) - sizeof(ObjectHeader));
-  switch (static_cast<TypeTag>(h->tag)) {
+  switch (value_tag(v)) {
     case TypeTag::Int: out = static_cast<double>(box_int_value(v)); return true;
     case TypeTag::Float: out = box_float_value(v); return true;
     case TypeTag::Bool: out = box_bool_value(v) ? 1.0 : 0.0; return true;
@@ -4051,8 +6372,7 @@ namespace pycc::rt {
 static std::vector<unsigned char> to_bytes_any(void* obj) {
   std::vector<unsigned char> out;
   if (!obj) return out;
-  auto* h = reinterpret_cast<ObjectHeader*>(reinterpret_cast<unsigned char*>(obj) - sizeof(ObjectHeader));
-  TypeTag t = static_cast<TypeTag>(h->tag);
+  const TypeTag t = value_tag(obj);
   if (t == TypeTag::Bytes) { const unsigned char* d = bytes_data(obj); out.assign(d, d + bytes_len(obj)); }
   else if (t == TypeTag::String) { const char* d = string_data(obj); out.assign(reinterpret_cast<const unsigned char*>(d), reinterpret_cast<const unsigned char*>(d) + string_len(obj)); }
   else if (t == TypeTag::Int) { long long v = box_int_value(obj); for (int i=0;i<8;++i) out.push_back(static_cast<unsigned char>((v >> (i*8)) & 0xFF)); }
@@ -4122,8 +6442,7 @@ static void append_escaped(std::string& out, const char* data, std::size_t n) {
 
 static std::string pformat_impl(void* obj, int depth) {
   if (obj == nullptr) return std::string("None");
-  auto* h = reinterpret_cast<ObjectHeader*>(reinterpret_cast<unsigned char*>(obj) - sizeof(ObjectHeader));
-  switch (static_cast<TypeTag>(h->tag)) {
+  switch (value_tag(obj)) {
     case TypeTag::Int: return std::to_string(box_int_value(obj));
     case TypeTag::Float: {
       std::ostringstream ss; ss.setf(std::ios::fixed); ss.precision(12); ss<<box_float_value(obj); std::string s=ss.str();
@@ -4149,6 +6468,12 @@ static std::string pformat_impl(void* obj, int depth) {
       std::string out = "{"; bool first=true; for (;;) { void* k = pycc_dict_iter_next(it); if (!k) break; void* v = dict_get(obj, k); if (!first) out += ", "; first=false; out += pformat_impl(k, depth+1); out += ": "; out += pformat_impl(v, depth+1); }
       out.push_back('}'); return out;
     }
+    case TypeTag::Set: {
+      if (set_len(obj) == 0) { return std::string("set()"); }
+      void* it = set_iter_new(obj);
+      std::string out = "{"; bool first=true; for (;;) { void* e = set_iter_next(it); if (!e) break; if (!first) out += ", "; first=false; out += pformat_impl(e, depth+1); }
+      out.push_back('}'); return out;
+    }
     default: return std::string("<object>");
   }
 }
@@ -4198,11 +6523,11 @@ void* types_simple_namespace(void* list_of_pairs_opt) {
     if (!k) continue;
     // Ensure key is string
     void* keyStr = nullptr;
-    auto* h = reinterpret_cast<ObjectHeader*>(reinterpret_cast<unsigned char*>(k) - sizeof(ObjectHeader));
-    if (static_cast<TypeTag>(h->tag) == TypeTag::String) keyStr = k;
-    else if (static_cast<TypeTag>(h->tag) == TypeTag::Int) {
+    const TypeTag kTag = value_tag(k);
+    if (kTag == TypeTag::String) keyStr = k;
+    else if (kTag == TypeTag::Int) {
       long long iv = box_int_value(k); std::string s = std::to_string(iv); keyStr = string_new(s.data(), s.size());
-    } else if (static_cast<TypeTag>(h->tag) == TypeTag::Bool) {
+    } else if (kTag == TypeTag::Bool) {
       const char* s = box_bool_value(k) ? "True" : "False"; keyStr = string_from_cstr(s);
     } else { continue; }
     object_set_attr(obj, keyStr, v);
@@ -4364,8 +6689,7 @@ namespace pycc::rt {
 static std::vector<unsigned char> to_bytes_for_binascii(void* obj) {
   std::vector<unsigned char> out;
   if (!obj) return out;
-  auto* h = reinterpret_cast<ObjectHeader*>(reinterpret_cast<unsigned char*>(obj) - sizeof(ObjectHeader));
-  TypeTag t = static_cast<TypeTag>(h->tag);
+  const TypeTag t = value_tag(obj);
   if (t == TypeTag::Bytes) {
     const unsigned char* d = bytes_data(obj); out.assign(d, d + bytes_len(obj));
   } else if (t == TypeTag::String) {
@@ -4407,8 +6731,7 @@ namespace pycc::rt {
 static std::vector<unsigned char> to_bytes_any2(void* obj) {
   std::vector<unsigned char> out;
   if (!obj) return out;
-  auto* h = reinterpret_cast<ObjectHeader*>(reinterpret_cast<unsigned char*>(obj) - sizeof(ObjectHeader));
-  TypeTag t = static_cast<TypeTag>(h->tag);
+  const TypeTag t = value_tag(obj);
   if (t == TypeTag::Bytes) { const unsigned char* d = bytes_data(obj); out.assign(d, d + bytes_len(obj)); }
   else if (t == TypeTag::String) { const char* d = string_data(obj); out.assign(reinterpret_cast<const unsigned char*>(d), reinterpret_cast<const unsigned char*>(d) + string_len(obj)); }
   else if (t == TypeTag::Bool) { out.push_back(box_bool_value(obj) ? 1 : 0); }
@@ -4482,8 +6805,7 @@ static void* deep_copy_obj(void* obj);
 
 static void* shallow_copy_obj(void* obj) {
   if (!obj) return nullptr;
-  auto* h = reinterpret_cast<ObjectHeader*>(reinterpret_cast<unsigned char*>(obj) - sizeof(ObjectHeader));
-  switch (static_cast<TypeTag>(h->tag)) {
+  switch (value_tag(obj)) {
     case TypeTag::Int:
     case TypeTag::Float:
     case TypeTag::Bool:
@@ -4502,14 +6824,14 @@ static void* shallow_copy_obj(void* obj) {
       for (;;) { void* k = pycc_dict_iter_next(it); if (!k) break; void* v = dict_get(obj, k); dict_set(&out, k, v); }
       return out;
     }
+    case TypeTag::Set: return set_union(obj, nullptr);
     default: return obj;
   }
 }
 
 static void* deep_copy_obj(void* obj) {
   if (!obj) return nullptr;
-  auto* h = reinterpret_cast<ObjectHeader*>(reinterpret_cast<unsigned char*>(obj) - sizeof(ObjectHeader));
-  switch (static_cast<TypeTag>(h->tag)) {
+  switch (value_tag(obj)) {
     case TypeTag::Int:
     case TypeTag::Float:
     case TypeTag::Bool:
@@ -4528,6 +6850,12 @@ static void* deep_copy_obj(void* obj) {
       for (;;) { void* k = pycc_dict_iter_next(it); if (!k) break; void* v = dict_get(obj, k); dict_set(&out, deep_copy_obj(k), deep_copy_obj(v)); }
       return out;
     }
+    case TypeTag::Set: {
+      void* out = set_new(set_len(obj) * 3 / 2);
+      void* it = set_iter_new(obj);
+      for (;;) { void* e = set_iter_next(it); if (!e) break; set_add(&out, deep_copy_obj(e)); }
+      return out;
+    }
     default: return obj;
   }
 }
@@ -4644,11 +6972,7 @@ extern "C" void* pycc_itertools_compress(void* a, void* b) { return ::pycc::rt::
 
 // ===== operator module =====
 namespace pycc::rt {
-static TypeTag runtime_type_of(void* obj) {
-  if (!obj) return TypeTag::Object;
-  auto* h = reinterpret_cast<ObjectHeader*>(reinterpret_cast<unsigned char*>(obj) - sizeof(ObjectHeader));
-  return static_cast<TypeTag>(h->tag);
-}
+static TypeTag runtime_type_of(void* obj) { return value_tag(obj); }
 static bool is_num_tag(TypeTag t) { return t == TypeTag::Int || t == TypeTag::Float || t == TypeTag::Bool; }
 static inline double to_double_num(void* a) {
   switch (runtime_type_of(a)) {
@@ -4709,6 +7033,7 @@ bool operator_truth(void* a) {
     case TypeTag::String: return string_len(a) != 0;
     case TypeTag::List: return list_len(a) != 0;
     case TypeTag::Dict: return dict_len(a) != 0;
+    case TypeTag::Set: return set_len(a) != 0;
     default: return a != nullptr;
   }
 }
@@ -4737,8 +7062,7 @@ void* collections_counter(void* iterable_list) {
     // Canonicalize key: use string as-is; for ints use decimal string
     void* key = k;
     if (k != nullptr) {
-      auto* hdr = reinterpret_cast<ObjectHeader*>(reinterpret_cast<unsigned char*>(k) - sizeof(ObjectHeader));
-      if (static_cast<TypeTag>(hdr->tag) == TypeTag::Int) {
+      if (value_tag(k) == TypeTag::Int) {
         long long v = box_int_value(k);
         auto it = intCache.find(v);
         if (it != intCache.end()) { key = it->second; }
@@ -4855,8 +7179,7 @@ static inline void  array_set_storage(void* arr, void* lst) { object_set(arr, 1,
 
 static inline long long to_int_like_any(void* v) {
   if (!v) return 0;
-  auto* h = reinterpret_cast<ObjectHeader*>(reinterpret_cast<unsigned char*>(v) - sizeof(ObjectHeader));
-  switch (static_cast<TypeTag>(h->tag)) {
+  switch (value_tag(v)) {
     case TypeTag::Int: return box_int_value(v);
     case TypeTag::Float: return static_cast<long long>(box_float_value(v));
     case TypeTag::Bool: return box_bool_value(v) ? 1 : 0;
@@ -4865,8 +7188,7 @@ static inline long long to_int_like_any(void* v) {
 }
 static inline double to_float_like_any(void* v) {
   if (!v) return 0.0;
-  auto* h = reinterpret_cast<ObjectHeader*>(reinterpret_cast<unsigned char*>(v) - sizeof(ObjectHeader));
-  switch (static_cast<TypeTag>(h->tag)) {
+  switch (value_tag(v)) {
     case TypeTag::Int: return static_cast<double>(box_int_value(v));
     case TypeTag::Float: return box_float_value(v);
     case TypeTag::Bool: return box_bool_value(v) ? 1.0 : 0.0;
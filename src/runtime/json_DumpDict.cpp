@@ -14,24 +14,22 @@ static inline void indent_nl_local(std::string& out, int depth, int indent) {
 }
 
 void json_dump_dict(void* obj, std::string& out, const DumpOpts& opts, int depth, DumpRecFn rec) {
-  // Note: only string keys supported
-  auto* base = reinterpret_cast<unsigned char*>(obj);
-  auto* pm = reinterpret_cast<std::size_t*>(base);
-  const std::size_t cap = pm[1];
-  auto** keys = reinterpret_cast<void**>(pm + 3);
-  auto** vals = keys + cap;
+  // Note: only string keys supported; entries come in insertion order
+  const DictEntries entries = dict_entries_public(obj);
+  const std::size_t count = entries.count;
+  auto* const* keys = entries.keys;
+  auto* const* vals = entries.values;
   out.push_back('{');
   bool first = true;
   if (opts.sortKeys) {
-    std::vector<void*> klist; klist.reserve(cap);
-    for (std::size_t i = 0; i < cap; ++i) if (keys[i] != nullptr) klist.push_back(keys[i]);
+    std::vector<void*> klist(keys, keys + count);
     std::sort(klist.begin(), klist.end(), [](void* a, void* b){
       return std::strcmp(string_data(a), string_data(b)) < 0;
     });
     for (void* kk : klist) {
       // linear search for matching key index (avoids dependency on ptr_hash)
       void* vv = nullptr;
-      for (std::size_t i = 0; i < cap; ++i) { if (keys[i] == kk) { vv = vals[i]; break; } }
+      for (std::size_t i = 0; i < count; ++i) { if (keys[i] == kk) { vv = vals[i]; break; } }
       if (type_of_public(kk) != TypeTag::String) { rt_raise("TypeError", "json.dumps: dict keys must be str"); out.clear(); return; }
       if (!first) {
         if (opts.indent > 0) { out.push_back(','); indent_nl_local(out, depth + 1, opts.indent); }
@@ -47,21 +45,19 @@ void json_dump_dict(void* obj, std::string& out, const DumpOpts& opts, int depth
       rec(vv, out, opts, depth + 1);
     }
   } else {
-    for (std::size_t i = 0; i < cap; ++i) {
-      if (keys[i] != nullptr) {
-        if (type_of_public(keys[i]) != TypeTag::String) { rt_raise("TypeError", "json.dumps: dict keys must be str"); out.clear(); return; }
-        if (!first) {
-          if (opts.indent > 0) { out.push_back(','); indent_nl_local(out, depth + 1, opts.indent); }
-          else if (opts.sepItem) { out += opts.sepItem; }
-          else { out.push_back(','); }
-        }
-        first = false;
-        rec(keys[i], out, opts, depth + 1);
-        if (opts.indent > 0) { out.push_back(':'); out.push_back(' '); }
-        else if (opts.sepKv) { out += opts.sepKv; }
-        else { out.push_back(':'); }
-        rec(vals[i], out, opts, depth + 1);
+    for (std::size_t i = 0; i < count; ++i) {
+      if (type_of_public(keys[i]) != TypeTag::String) { rt_raise("TypeError", "json.dumps: dict keys must be str"); out.clear(); return; }
+      if (!first) {
+        if (opts.indent > 0) { out.push_back(','); indent_nl_local(out, depth + 1, opts.indent); }
+        else if (opts.sepItem) { out += opts.sepItem; }
+        else { out.push_back(','); }
       }
+      first = false;
+      rec(keys[i], out, opts, depth + 1);
+      if (opts.indent > 0) { out.push_back(':'); out.push_back(' '); }
+      else if (opts.sepKv) { out += opts.sepKv; }
+      else { out.push_back(':'); }
+      rec(vals[i], out, opts, depth + 1);
     }
   }
   if (!first && opts.indent > 0) indent_nl_local(out, depth, opts.indent);
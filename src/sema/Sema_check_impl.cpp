@@ -14,6 +14,7 @@
 #include "sema/detail/checks/BuildSigs.h"
 #include "sema/detail/checks/CollectClasses.h"
 #include "sema/detail/checks/MergeClassBases.h"
+#include "sema/detail/exptyper/CompHandlers.h"
 #include "ast/AssignStmt.h"
 #include "ast/ExprStmt.h"
 #include "ast/FunctionDef.h"
@@ -111,6 +112,9 @@ namespace pycc::sema {
                             if (as.targets.size() == 1 && as.targets[0] && as.targets[0]->kind == ast::NodeKind::Name) {
                                 const auto *nm = static_cast<const ast::Name *>(as.targets[0].get());
                                 env.unionSet(nm->id, TypeEnv::maskForKind(t), prov);
+                                // Keep set element kinds for membership tests (0 clears them when rebound to a non-set)
+                                env.defineSetElems(nm->id, detail::setElementMask(*as.value, env, sigs, retParamIdxs,
+                                                                                  diags, classes));
                             }
                         } else if (!as.target.empty()) {
                             env.unionSet(as.target, TypeEnv::maskForKind(t), prov);
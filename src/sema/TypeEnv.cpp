@@ -95,6 +95,15 @@ namespace pycc::sema {
         return (it == listElemSets_.end()) ? 0U : it->second;
     }
 
+    /*** Name: TypeEnv::defineSetElems */
+    void TypeEnv::defineSetElems(const std::string &name, const uint32_t elemMask) { setElemSets_[name] = elemMask; }
+
+    /*** Name: TypeEnv::getSetElems */
+    uint32_t TypeEnv::getSetElems(const std::string &name) const {
+        const auto it = setElemSets_.find(name);
+        return (it == setElemSets_.end()) ? 0U : it->second;
+    }
+
     /*** Name: TypeEnv::defineTupleElems */
     void TypeEnv::defineTupleElems(const std::string &name, std::vector<uint32_t> elemMasks) {
         tupleElemSets_[name] = std::move(elemMasks);
@@ -159,6 +168,7 @@ namespace pycc::sema {
     void TypeEnv::intersectFrom(const TypeEnv &a, const TypeEnv &b) {
         detail::IntersectOps::setsAndTypes(*this, a, b);
         detail::IntersectOps::listElems(*this, a, b);
+        detail::IntersectOps::setElems(*this, a, b);
         detail::IntersectOps::tupleElems(*this, a, b);
         detail::IntersectOps::dictKeyVals(*this, a, b);
     }
@@ -177,6 +187,7 @@ namespace pycc::sema {
         for (const auto &kv: src.types_) { types_[kv.first] = kv.second; }
         // Container shapes
         for (const auto &kv: src.listElemSets_) { listElemSets_[kv.first] = kv.second; }
+        for (const auto &kv: src.setElemSets_) { setElemSets_[kv.first] = kv.second; }
         for (const auto &kv: src.tupleElemSets_) { tupleElemSets_[kv.first] = kv.second; }
         for (const auto &kv: src.dictKeySets_) { dictKeySets_[kv.first] = kv.second; }
         for (const auto &kv: src.dictValSets_) { dictValSets_[kv.first] = kv.second; }
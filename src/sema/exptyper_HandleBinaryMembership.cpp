@@ -3,6 +3,7 @@
  * @brief handleBinaryMembership: Type checks membership binary operators.
  */
 #include "sema/detail/exptyper/BinaryHandlers.h"
+#include "sema/detail/exptyper/CompHandlers.h"
 #include "sema/detail/ExpressionTyper.h"
 #include "ast/ListLiteral.h"
 
@@ -41,11 +42,15 @@ namespace pycc::sema::detail {
             outSet = TypeEnv::maskForKind(Type::Bool);
             return true;
         }
-        if (rMask == listMask || node.rhs->kind == ast::NodeKind::ListLiteral) {
+        const bool rhsSet = node.rhs->kind == ast::NodeKind::SetLiteral || node.rhs->kind == ast::NodeKind::SetComp;
+        if (rMask == listMask || node.rhs->kind == ast::NodeKind::ListLiteral || rhsSet) {
             uint32_t elemMask = 0U;
-            if (node.rhs->kind == ast::NodeKind::Name) {
+            if (rhsSet) {
+                elemMask = setElementMask(*node.rhs, env, sigs, retParamIdxs, diags, nullptr);
+            } else if (node.rhs->kind == ast::NodeKind::Name) {
                 const auto *nm = static_cast<const ast::Name *>(node.rhs.get());
                 elemMask = env.getListElems(nm->id);
+                if (elemMask == 0U) { elemMask = env.getSetElems(nm->id); }
             } else if (node.rhs->kind == ast::NodeKind::ListLiteral) {
                 for (const auto *lst = static_cast<const ast::ListLiteral *>(node.rhs.get()); const auto &el: lst->
                      elements) {
@@ -18,7 +18,8 @@ bool handleSetComp(const ast::SetComp& sc,
                    const std::unordered_map<std::string, ClassInfo>* classes,
                    ast::TypeKind& out,
                    uint32_t& outSet,
-                   bool& ok) {
+                   bool& ok,
+                   uint32_t* eltMask) {
     TypeEnv local = env;
     auto inferElemMask = [&](const ast::Expr* it) -> uint32_t {
         if (!it) return 0U;
@@ -26,11 +27,14 @@ bool handleSetComp(const ast::SetComp& sc,
             const auto* nm = static_cast<const ast::Name*>(it);
             const uint32_t e = local.getListElems(nm->id);
             if (e != 0U) return e;
+            if (const uint32_t se = local.getSetElems(nm->id); se != 0U) return se;
         }
-        if (it->kind == ast::NodeKind::ListLiteral) {
+        if (it->kind == ast::NodeKind::ListLiteral || it->kind == ast::NodeKind::SetLiteral) {
             uint32_t em = 0U;
-            const auto* lst = static_cast<const ast::ListLiteral*>(it);
-            for (const auto& el : lst->elements) {
+            const auto& elements = it->kind == ast::NodeKind::ListLiteral
+                                       ? static_cast<const ast::ListLiteral*>(it)->elements
+                                       : static_cast<const ast::SetLiteral*>(it)->elements;
+            for (const auto& el : elements) {
                 if (!el) continue;
                 ExpressionTyper et{local, sigs, retParamIdxs, diags, polyTargets, outers, classes};
                 el->accept(et); if (!et.ok) return 0U;
@@ -61,9 +65,37 @@ bool handleSetComp(const ast::SetComp& sc,
             if (!typeIsBool(et.out)) { addDiag(diags, "set comprehension guard must be bool", g.get()); ok = false; return true; }
         }
     }
-    if (sc.elt) { ExpressionTyper et{local, sigs, retParamIdxs, diags, polyTargets, outers, classes}; sc.elt->accept(et); if (!et.ok) { ok = false; return true; } }
+    if (sc.elt) {
+        ExpressionTyper et{local, sigs, retParamIdxs, diags, polyTargets, outers, classes}; sc.elt->accept(et); if (!et.ok) { ok = false; return true; }
+        if (eltMask != nullptr) { *eltMask = (et.outSet != 0U) ? et.outSet : TypeEnv::maskForKind(et.out); }
+    }
     out = ast::TypeKind::List; outSet = TypeEnv::maskForKind(out);
     return true;
 }
 
+uint32_t setElementMask(const ast::Expr& set,
+                        const TypeEnv& env,
+                        const std::unordered_map<std::string, Sig>& sigs,
+                        const std::unordered_map<std::string, int>& retParamIdxs,
+                        std::vector<Diagnostic>& diags,
+                        const std::unordered_map<std::string, ClassInfo>* classes) {
+    uint32_t em = 0U;
+    if (set.kind == ast::NodeKind::SetLiteral) {
+        for (const auto& el : static_cast<const ast::SetLiteral&>(set).elements) {
+            if (!el) continue;
+            ExpressionTyper et{env, sigs, retParamIdxs, diags, {}, nullptr, classes};
+            el->accept(et); if (!et.ok) return 0U;
+            em |= (et.outSet != 0U) ? et.outSet : TypeEnv::maskForKind(et.out);
+        }
+    } else if (set.kind == ast::NodeKind::SetComp) {
+        ast::TypeKind out{};
+        uint32_t outSet = 0U;
+        bool ok = true;
+        handleSetComp(static_cast<const ast::SetComp&>(set), env, sigs, retParamIdxs, diags, {}, nullptr, classes,
+                      out, outSet, ok, &em);
+        if (!ok) return 0U;
+    }
+    return em;
+}
+
 } // namespace pycc::sema::detail
@@ -0,0 +1,17 @@
+/**
+ * @file
+ * @brief IntersectOps::setElems: Intersect per-name set element masks across envs.
+ */
+#include "sema/TypeEnv.h"
+#include "sema/detail/types/IntersectOps.h"
+
+namespace pycc::sema::detail {
+
+void IntersectOps::setElems(TypeEnv& dst, const TypeEnv& a, const TypeEnv& b) {
+    for (const auto& kv : a.setElemSets_) {
+        const std::string& name = kv.first; auto itb = b.setElemSets_.find(name);
+        if (itb == b.setElemSets_.end()) continue; dst.setElemSets_[name] = (kv.second & itb->second);
+    }
+}
+
+} // namespace pycc::sema::detail
@@ -19,6 +19,7 @@ TEST(CodegenIRSmoke, BoxingAndBarriersForListAndObject) {
   const char* src =
       "def main() -> int:\n"
       "  l = [1, 2]\n"
+      "  l.append(3)\n"
       "  o = object(True, 3.5)\n"
       "  return 0\n";
   auto mod = parseSrc(src);
@@ -42,3 +43,20 @@ TEST(CodegenIRSmoke, BoxingAndBarriersForListAndObject) {
   ASSERT_NE(ir.find("call void @pycc_gc_write_barrier(ptr"), std::string::npos);
 }
 
+TEST(CodegenIRSmoke, StoreBarrierFastPathIsInline) {
+  const char* src =
+      "def main() -> int:\n"
+      "  l = [1, 2]\n"
+      "  for x in l:\n"
+      "    y = x\n"
+      "  return 0\n";
+  auto mod = parseSrc(src);
+  auto ir = codegen::Codegen::generateIR(*mod);
+  // The helper polls the marking flag and reaches the runtime only on the slow path
+  ASSERT_NE(ir.find("@pycc_gc_marking = external global i8"), std::string::npos);
+  ASSERT_NE(ir.find("define internal void @pycc_gc_store_barrier(ptr %slot, ptr %value) alwaysinline"), std::string::npos);
+  ASSERT_NE(ir.find("load atomic i8, ptr @pycc_gc_marking monotonic"), std::string::npos);
+  // Stores go through the helper; the loop target is a shadow-stack root
+  ASSERT_NE(ir.find("call void @pycc_gc_store_barrier(ptr"), std::string::npos);
+  ASSERT_NE(ir.find("call void @llvm.gcroot(ptr %x.addr, ptr null)"), std::string::npos);
+}
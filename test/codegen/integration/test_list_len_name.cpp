@@ -19,10 +19,11 @@ TEST(CodegenIR, ListLenName) {
   const char* src =
       "def main() -> int:\n"
       "  a = [1,2,3]\n"
+      "  a.append(4)\n"
       "  return len(a)\n";
   auto mod = parseSrc(src);
   auto ir = codegen::Codegen::generateIR(*mod);
-  // Expect calls to list_new and list_push and list_len
+  // The list escapes through append, so it stays a heap list: list_new, list_push and list_len
   ASSERT_NE(ir.find("declare ptr @pycc_list_new(i64)"), std::string::npos);
   ASSERT_NE(ir.find("call ptr @pycc_list_new(i64 3)"), std::string::npos);
   ASSERT_NE(ir.find("call void @pycc_list_push(ptr"), std::string::npos);
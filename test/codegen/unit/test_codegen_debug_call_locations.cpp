@@ -0,0 +1,47 @@
+/***
+ * Name: test_codegen_debug_call_locations
+ * Purpose: Ensure debug info survives LLVM's verifier: module flags are present and every call
+ *          in a function with a DISubprogram carries a location.
+ */
+#include <gtest/gtest.h>
+#include "lexer/Lexer.h"
+#include "parser/Parser.h"
+#include "codegen/Codegen.h"
+#include <sstream>
+
+using namespace pycc;
+
+static std::string genIR(const char* src) {
+  lex::Lexer L; L.pushString(src, "call_locations.py");
+  parse::Parser P(L);
+  auto mod = P.parseModule();
+  return codegen::Codegen::generateIR(*mod);
+}
+
+TEST(CodegenDebug, CallsCarryLocations) {
+  const char* src = R"PY(
+def build(n: int) -> int:
+  xs = [1.5]
+  i = 0
+  while i < n:
+    xs.append(2.5)
+    i = i + 1
+  return len(xs)
+
+def main() -> int:
+  return build(10)
+)PY";
+  const auto ir = genIR(src);
+  EXPECT_NE(ir.find("!{i32 2, !\"Debug Info Version\", i32 3}"), std::string::npos);
+  EXPECT_NE(ir.find("!DISubroutineType("), std::string::npos);
+  EXPECT_NE(ir.find("call i32 @build(i32 10), !dbg !"), std::string::npos);
+  std::istringstream lines(ir);
+  bool inDebugFunction = false;
+  for (std::string line; std::getline(lines, line);) {
+    if (line.starts_with("define ")) { inDebugFunction = line.find("!dbg !") != std::string::npos; continue; }
+    if (line == "}") { inDebugFunction = false; continue; }
+    if (inDebugFunction && line.find(" call ") != std::string::npos) {
+      EXPECT_NE(line.find("!dbg !"), std::string::npos) << line;
+    }
+  }
+}
@@ -29,3 +29,20 @@ def main() -> int:
   ASSERT_NE(ir.find("@pycc_dict_iter_next"), std::string::npos);
 }
 
+
+TEST(CodegenDict, IterNewTakesTheDictNotItsSlot) {
+  const char* src = R"PY(
+def main() -> int:
+  d = {"a": 1}
+  for k in d:
+    pass
+  return 0
+)PY";
+  const auto ir = genIR(src);
+  EXPECT_EQ(ir.find("@pycc_dict_iter_new(ptr %d.addr)"), std::string::npos);
+  const auto call = ir.find("@pycc_dict_iter_new(ptr %t");
+  ASSERT_NE(call, std::string::npos);
+  const auto argStart = ir.find("%t", call);
+  const std::string arg = ir.substr(argStart, ir.find(')', argStart) - argStart);
+  EXPECT_NE(ir.find(arg + " = load ptr, ptr %d.addr"), std::string::npos);
+}
@@ -0,0 +1,125 @@
+/***
+ * Name: test_codegen_stack_lists
+ * Purpose: Ensure list literals that never escape their function live in stack slots, and escaping ones stay on the heap.
+ */
+#include <gtest/gtest.h>
+#include "lexer/Lexer.h"
+#include "parser/Parser.h"
+#include "codegen/Codegen.h"
+
+using namespace pycc;
+
+static std::string genIR(const char* src) {
+  lex::Lexer L; L.pushString(src, "stack_lists.py");
+  parse::Parser P(L);
+  auto mod = P.parseModule();
+  return codegen::Codegen::generateIR(*mod);
+}
+
+TEST(CodegenStackLists, LocalListReadsStayOnStack) {
+  const char* src = R"PY(
+def main() -> int:
+  i = 1
+  xs = [1, 2, 3]
+  a = xs[0]
+  b = xs[i]
+  return len(xs)
+)PY";
+  const auto ir = genIR(src);
+  EXPECT_EQ(ir.find("call ptr @pycc_list_new"), std::string::npos);
+  EXPECT_EQ(ir.find("call ptr @pycc_list_get"), std::string::npos);
+  EXPECT_EQ(ir.find("call i64 @pycc_list_len"), std::string::npos);
+  EXPECT_NE(ir.find("%xs.el2 = alloca ptr"), std::string::npos);
+  // Ints are stored as tagged immediates, so their slots are not GC roots
+  EXPECT_EQ(ir.find("@llvm.gcroot(ptr %xs.el0"), std::string::npos);
+  EXPECT_NE(ir.find("load ptr, ptr %xs.el0"), std::string::npos);
+  EXPECT_NE(ir.find("select i1"), std::string::npos);
+  EXPECT_NE(ir.find("ret i32 3"), std::string::npos);
+}
+
+TEST(CodegenStackLists, ScratchListInLoopAndIteration) {
+  const char* src = R"PY(
+def main() -> int:
+  n = 0
+  while n < 10:
+    pair = [n, 2.5]
+    for p in pair:
+      q = p
+    n = n + 1
+  return 0
+)PY";
+  const auto ir = genIR(src);
+  EXPECT_EQ(ir.find("call ptr @pycc_list_new"), std::string::npos);
+  // The boxed float is a heap object, so its slot is a root written through the barrier
+  EXPECT_NE(ir.find("call void @llvm.gcroot(ptr %pair.el1, ptr null)"), std::string::npos);
+  EXPECT_NE(ir.find("call void @pycc_gc_store_barrier(ptr %pair.el1"), std::string::npos);
+  EXPECT_NE(ir.find("load ptr, ptr %pair.el1"), std::string::npos);
+}
+
+TEST(CodegenStackLists, EscapingListsStayOnHeap) {
+  const char* src = R"PY(
+def main() -> int:
+  xs = [1, 2]
+  xs.append(3)
+  ys = [4]
+  zs = ys
+  ws = [5]
+  ws[0] = 6
+  return 0
+)PY";
+  const auto ir = genIR(src);
+  EXPECT_NE(ir.find("call ptr @pycc_list_new(i64 2)"), std::string::npos);
+  EXPECT_NE(ir.find("call void @pycc_list_set(ptr"), std::string::npos);
+  EXPECT_EQ(ir.find(".el0 = alloca ptr"), std::string::npos);
+}
+
+TEST(CodegenStackLists, NegativeIndicesCountFromTheEnd) {
+  const char* src = R"PY(
+def last() -> int:
+  xs = [1, 2, 3]
+  a = xs[-1]
+  return 0
+
+def main() -> int:
+  i = -2
+  ys = [4, 5, 6]
+  b = ys[i]
+  return 0
+)PY";
+  const auto ir = genIR(src);
+  EXPECT_EQ(ir.find("call ptr @pycc_list_get"), std::string::npos);
+  // xs[-1] loads the last slot directly instead of comparing -1 with 0..2
+  const auto lastStart = ir.find("define i32 @last(");
+  const auto mainStart = ir.find("define i32 @main(");
+  ASSERT_NE(lastStart, std::string::npos);
+  ASSERT_NE(mainStart, std::string::npos);
+  const auto last = ir.substr(lastStart, mainStart - lastStart);
+  EXPECT_NE(last.find("load ptr, ptr %xs.el2"), std::string::npos);
+  EXPECT_EQ(last.find("icmp eq i32"), std::string::npos);
+  // A dynamic index wraps around by the length before selecting a slot
+  const auto wrap = ir.find("icmp slt i32", mainStart);
+  ASSERT_NE(wrap, std::string::npos);
+  EXPECT_NE(ir.find(", 3\n", wrap), std::string::npos);
+  EXPECT_NE(ir.find("select i1", wrap), std::string::npos);
+}
+
+TEST(CodegenStackLists, ElementsKeepTheirKindOnReads) {
+  const char* src = R"PY(
+def main() -> int:
+  xs = [10, 20, 30]
+  t = 0
+  for v in xs:
+    t = t + v
+  f = [1.5, 2.5]
+  g = f[0] + 1.0
+  return t + xs[-1]
+)PY";
+  const auto ir = genIR(src);
+  EXPECT_EQ(ir.find("call ptr @pycc_list_"), std::string::npos);
+  // Int elements are untagged back to i32 for the loop variable and constant-index reads
+  EXPECT_NE(ir.find("ashr i64"), std::string::npos);
+  EXPECT_NE(ir.find("add i32"), std::string::npos);
+  // Float elements are read back out of their box
+  EXPECT_NE(ir.find("load double, ptr"), std::string::npos);
+  EXPECT_NE(ir.find("fadd double"), std::string::npos);
+}
@@ -0,0 +1,53 @@
+/***
+ * Name: test_codegen_static_strings
+ * Purpose: Ensure string literals and attribute names become immortal string objects emitted as
+ *          read-only constants, addressed directly instead of allocated or looked up at runtime.
+ */
+#include <gtest/gtest.h>
+#include "lexer/Lexer.h"
+#include "parser/Parser.h"
+#include "codegen/Codegen.h"
+#include "runtime/StaticString.h"
+#include <string>
+
+using namespace pycc;
+
+static std::string genIR(const char* src) {
+  lex::Lexer L; L.pushString(src, "static_strings.py");
+  parse::Parser P(L);
+  auto mod = P.parseModule();
+  return codegen::Codegen::generateIR(*mod);
+}
+
+TEST(CodegenStrings, LiteralsAndAttributeNamesAreStaticObjects) {
+  const char* src = R"PY(
+def main() -> int:
+  s = "hello"
+  t = "hello"
+  o = object(2)
+  x = o.foo
+  return 0
+)PY";
+  const auto ir = genIR(src);
+  EXPECT_EQ(ir.find("call ptr @pycc_string_new("), std::string::npos);
+  EXPECT_EQ(ir.find("@pycc_string_literal"), std::string::npos);
+  // Both "hello" literals address one object, one header word past its start
+  const std::string use = "= getelementptr inbounds i8, ptr @.sobj_";
+  const auto first = ir.find(use);
+  ASSERT_NE(first, std::string::npos);
+  const auto nameStart = ir.find('@', first);
+  const std::string obj = ir.substr(nameStart, ir.find(',', nameStart) - nameStart);
+  EXPECT_NE(ir.find(obj + ", i64 8", ir.find(use, first + 1)), std::string::npos);
+  // Laid out as header {String, gen 1, age 0, immortal}, size, len, precomputed hash, bytes
+  const std::string def = obj + " = private unnamed_addr constant { i8, i8, i8, i8, i32, i64, i64, [6 x i8] } { i8 " +
+      std::to_string(static_cast<int>(rt::TypeTag::String)) + ", i8 1, i8 0, i8 " + std::to_string(rt::kFlagImmortal) +
+      ", i32 30, i64 5, i64 " + std::to_string(static_cast<int64_t>(rt::string_content_hash("hello"))) +
+      ", [6 x i8] c\"hello\\00\" }, align 16";
+  EXPECT_NE(ir.find(def), std::string::npos);
+  // The plain C string aliases the object's bytes
+  EXPECT_NE(ir.find(" = private alias [6 x i8], getelementptr inbounds ({ i8, i8, i8, i8, i32, i64, i64, [6 x i8] }, ptr " + obj + ", i32 0, i32 7)"), std::string::npos);
+  // Attribute names are static objects too
+  const auto attr = ir.find("call ptr @pycc_object_get_attr(");
+  ASSERT_NE(attr, std::string::npos);
+  EXPECT_NE(ir.rfind(use, attr), std::string::npos);
+}
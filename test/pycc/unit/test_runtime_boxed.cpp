@@ -1,6 +1,7 @@
 /***
  * Name: test_runtime_boxed
- * Purpose: Validate boxed primitive allocations and accessors; exercise GC threshold.
+ * Purpose: Validate boxed primitives and accessors: immediate ints and bools, heap-boxed floats
+ *          and wide ints; exercise GC threshold.
  */
 #include <gtest/gtest.h>
 #include "runtime/All.h"
@@ -20,3 +21,64 @@ TEST(RuntimeBoxed, IntFloatBoolRoundTrip) {
   EXPECT_TRUE(box_bool_value(bb));
 }
 
+TEST(RuntimeBoxed, SmallIntsAndBoolsAreImmediates) {
+  gc_reset_for_tests();
+  const uint64_t before = gc_stats().numAllocated;
+  constexpr int64_t kMax = (int64_t{1} << 62) - 1;
+  for (const int64_t v : {int64_t{0}, int64_t{1}, int64_t{-1}, int64_t{42}, kMax, -kMax - 1}) {
+    void* b = box_int(v);
+    EXPECT_TRUE(is_immediate(b));
+    EXPECT_EQ(box_int_value(b), v);
+    EXPECT_EQ(b, box_int(v)); // equal ints are the same value
+  }
+  EXPECT_TRUE(is_immediate(box_bool(true)));
+  EXPECT_TRUE(box_bool_value(box_bool(true)));
+  EXPECT_FALSE(box_bool_value(box_bool(false)));
+  EXPECT_EQ(gc_stats().numAllocated, before);
+}
+
+TEST(RuntimeBoxed, WideIntsStillBox) {
+  gc_reset_for_tests();
+  for (const int64_t v : {int64_t{1} << 62, -(int64_t{1} << 62) - 1, INT64_MAX, INT64_MIN}) {
+    void* b = box_int(v);
+    EXPECT_FALSE(is_immediate(b));
+    EXPECT_EQ(box_int_value(b), v);
+  }
+  EXPECT_EQ(gc_stats().numAllocated, 4U);
+}
+
+TEST(RuntimeBoxed, ImmediatesSurviveCollectionInContainers) {
+  gc_reset_for_tests();
+  void* list = list_new(4);
+  gc_register_root(&list);
+  for (int64_t i = 0; i < 1000; ++i) { list_push_slot(&list, (i % 2 == 0) ? box_int(i) : box_bool(i % 4 == 1)); }
+  void* dict = dict_new(8);
+  gc_register_root(&dict);
+  dict_set(&dict, box_int(7), box_float(0.25));
+  gc_collect();
+  for (int64_t i = 0; i < 1000; i += 2) { EXPECT_EQ(box_int_value(list_get(list, static_cast<std::size_t>(i))), i); }
+  EXPECT_TRUE(box_bool_value(list_get(list, 1)));
+  EXPECT_FALSE(box_bool_value(list_get(list, 3)));
+  EXPECT_DOUBLE_EQ(box_float_value(dict_get(dict, box_int(7))), 0.25);
+  gc_unregister_root(&dict);
+  gc_unregister_root(&list);
+}
+
+TEST(RuntimeBoxed, IntArithmeticAndDictIterationDoNotAllocate) {
+  gc_reset_for_tests();
+  void* dict = dict_new(8);
+  gc_register_root(&dict);
+  for (int64_t i = 0; i < 4; ++i) { dict_set(&dict, box_int(i), box_int(i * i)); }
+  void* it = dict_iter_new(dict);
+  gc_register_root(&it);
+  const uint64_t before = gc_stats().numAllocated;
+  int64_t sum = 0;
+  for (void* k = dict_iter_next(it); k != nullptr; k = dict_iter_next(it)) {
+    sum = box_int_value(operator_add(box_int(sum), dict_get(dict, k)));
+  }
+  EXPECT_EQ(sum, 0 + 1 + 4 + 9);
+  EXPECT_TRUE(operator_eq(operator_mul(box_int(6), box_int(7)), box_int(42)));
+  EXPECT_EQ(gc_stats().numAllocated, before);
+  gc_unregister_root(&it);
+  gc_unregister_root(&dict);
+}
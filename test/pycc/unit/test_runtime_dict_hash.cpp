@@ -0,0 +1,65 @@
+/***
+ * Name: test_runtime_dict_hash
+ * Purpose: Verify dicts hash and compare string and number keys by value, so keys built at
+ *          runtime find entries stored under other objects with the same content.
+ */
+#include <gtest/gtest.h>
+#include "runtime/All.h"
+#include <string>
+
+using namespace pycc::rt;
+
+TEST(RuntimeDictHash, FreshStringKeysFindEntries) {
+  gc_reset_for_tests();
+  void* d = dict_new(8);
+  gc_register_root(&d);
+  constexpr int kKeys = 20000;
+  for (int i = 0; i < kKeys; ++i) {
+    const std::string key = "key" + std::to_string(i);
+    dict_set(&d, string_new(key.data(), key.size()), box_int(i));
+  }
+  EXPECT_EQ(dict_len(d), static_cast<std::size_t>(kKeys));
+  for (int i = 0; i < kKeys; ++i) {
+    void* key = string_concat(string_from_cstr("key"), string_from_cstr(std::to_string(i).c_str()));
+    void* v = dict_get(d, key);
+    ASSERT_NE(v, nullptr) << i;
+    EXPECT_EQ(box_int_value(v), i);
+  }
+  EXPECT_EQ(dict_get(d, string_from_cstr("key-1")), nullptr);
+  gc_unregister_root(&d);
+}
+
+TEST(RuntimeDictHash, EqualKeysShareOneEntry) {
+  gc_reset_for_tests();
+  void* d = nullptr;
+  gc_register_root(&d);
+  void* first = string_from_cstr("name");
+  dict_set(&d, first, box_int(1));
+  dict_set(&d, string_from_cstr("name"), box_int(2));
+  EXPECT_EQ(dict_len(d), 1U);
+  EXPECT_EQ(box_int_value(dict_get(d, first)), 2);
+  void* it = dict_iter_new(d);
+  EXPECT_EQ(dict_iter_next(it), first); // the key stored first stays
+  gc_unregister_root(&d);
+}
+
+TEST(RuntimeDictHash, NumbersAreKeysByValue) {
+  gc_reset_for_tests();
+  void* d = nullptr;
+  gc_register_root(&d);
+  dict_set(&d, box_int(1), string_from_cstr("one"));
+  dict_set(&d, box_float(2.5), string_from_cstr("two and a half"));
+  const int64_t big = int64_t{1} << 62; // boxed on the heap
+  dict_set(&d, box_int(big), string_from_cstr("big"));
+  EXPECT_EQ(std::string(string_data(dict_get(d, box_float(1.0)))), "one");
+  EXPECT_EQ(std::string(string_data(dict_get(d, box_bool(true)))), "one");
+  EXPECT_EQ(std::string(string_data(dict_get(d, box_float(2.5)))), "two and a half");
+  EXPECT_EQ(std::string(string_data(dict_get(d, box_int(big)))), "big");
+  EXPECT_EQ(std::string(string_data(dict_get(d, box_float(static_cast<double>(big))))), "big");
+  EXPECT_EQ(dict_get(d, box_float(1.5)), nullptr);
+  EXPECT_EQ(dict_get(d, string_from_cstr("1")), nullptr);
+  dict_set(&d, box_float(1.0), string_from_cstr("uno"));
+  EXPECT_EQ(dict_len(d), 3U);
+  EXPECT_EQ(std::string(string_data(dict_get(d, box_int(1)))), "uno");
+  gc_unregister_root(&d);
+}
@@ -0,0 +1,68 @@
+/***
+ * Name: test_runtime_dict_order
+ * Purpose: Verify dicts keep insertion order through growth and collections, iterate without
+ *          allocating, and reject iteration over a dict whose size changed.
+ */
+#include <gtest/gtest.h>
+#include "runtime/All.h"
+#include <string>
+
+using namespace pycc::rt;
+
+TEST(RuntimeDictOrder, IteratesInInsertionOrderAcrossGrowth) {
+  gc_reset_for_tests();
+  void* d = nullptr;
+  gc_register_root(&d);
+  constexpr int kKeys = 1000;
+  for (int i = 0; i < kKeys; ++i) {
+    const std::string key = "k" + std::to_string((i * 7919) % kKeys); // scrambled against hash order
+    dict_set(&d, string_new(key.data(), key.size()), box_int(i));
+  }
+  dict_set(&d, string_from_cstr("k0"), box_int(-1)); // updating keeps the first position
+  gc_collect();
+  void* it = dict_iter_new(d);
+  gc_register_root(&it);
+  int i = 0;
+  for (void* k = dict_iter_next(it); k != nullptr; k = dict_iter_next(it), ++i) {
+    EXPECT_EQ(std::string(string_data(k)), "k" + std::to_string((i * 7919) % kKeys)) << i;
+  }
+  EXPECT_EQ(i, kKeys);
+  EXPECT_EQ(box_int_value(dict_get(d, string_from_cstr("k0"))), -1);
+  gc_unregister_root(&it);
+  gc_unregister_root(&d);
+}
+
+TEST(RuntimeDictOrder, StepsAllocateNothing) {
+  gc_reset_for_tests();
+  void* d = dict_new(8);
+  gc_register_root(&d);
+  for (int64_t i = 0; i < 100; ++i) { dict_set(&d, box_int(i), box_int(i)); }
+  void* it = dict_iter_new(d);
+  gc_register_root(&it);
+  const uint64_t before = gc_stats().numAllocated;
+  int64_t expected = 0;
+  for (void* k = dict_iter_next(it); k != nullptr; k = dict_iter_next(it)) { EXPECT_EQ(box_int_value(k), expected++); }
+  EXPECT_EQ(expected, 100);
+  EXPECT_EQ(gc_stats().numAllocated, before);
+  gc_unregister_root(&it);
+  gc_unregister_root(&d);
+}
+
+TEST(RuntimeDictOrder, InsertDuringIterationRaises) {
+  gc_reset_for_tests();
+  void* d = nullptr;
+  gc_register_root(&d);
+  dict_set(&d, box_int(1), box_int(1));
+  dict_set(&d, box_int(2), box_int(2));
+  void* it = dict_iter_new(d);
+  gc_register_root(&it);
+  void* k = dict_iter_next(it);
+  dict_set(&d, k, box_int(10)); // updating a value is allowed
+  EXPECT_EQ(box_int_value(dict_iter_next(it)), 2);
+  dict_set(&d, box_int(3), box_int(3));
+  EXPECT_ANY_THROW((void)dict_iter_next(it));
+  EXPECT_TRUE(rt_has_exception());
+  rt_clear_exception();
+  gc_unregister_root(&it);
+  gc_unregister_root(&d);
+}
@@ -0,0 +1,62 @@
+/***
+ * Name: test_runtime_gc_arenas
+ * Purpose: Verify small-object spans come from 2 MiB-aligned heap arenas, which request
+ *          transparent huge pages unless that is turned off.
+ */
+#include <gtest/gtest.h>
+#include "runtime/All.h"
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+using namespace pycc::rt;
+
+namespace {
+constexpr uint64_t kArenaBytes = uint64_t{2} << 20U;
+
+// Keep allocating ~4 KiB strings into a rooted list until a new arena has been reserved
+void grow_by_one_arena(void** keep) {
+  const uint64_t before = gc_stats().arenaBytes;
+  const std::string text(4000, 'a');
+  for (int i = 0; i < 4096 && gc_stats().arenaBytes == before; ++i) {
+    list_push_slot(keep, string_new(text.data(), text.size()));
+  }
+}
+} // namespace
+
+TEST(RuntimeArena, ArenasAreWholeHugePages) {
+  gc_reset_for_tests();
+  gc_set_nursery_size(0);
+  void* keep = list_new(4);
+  gc_register_root(&keep);
+  grow_by_one_arena(&keep);
+  const RuntimeStats st = gc_stats();
+  EXPECT_GT(st.arenaBytes, 0U);
+  EXPECT_EQ(st.arenaBytes % kArenaBytes, 0U);
+  EXPECT_EQ(st.hugePageBytes % kArenaBytes, 0U);
+  EXPECT_LE(st.hugePageBytes, st.arenaBytes);
+  gc_unregister_root(&keep);
+}
+
+TEST(RuntimeArena, HugePagesCanBeTurnedOff) {
+  gc_reset_for_tests();
+  gc_set_nursery_size(0);
+  void* keep = list_new(4);
+  gc_register_root(&keep);
+
+  gc_set_huge_pages(false);
+  const RuntimeStats off0 = gc_stats();
+  grow_by_one_arena(&keep);
+  const RuntimeStats off1 = gc_stats();
+  EXPECT_EQ(off1.arenaBytes, off0.arenaBytes + kArenaBytes);
+  EXPECT_EQ(off1.hugePageBytes, off0.hugePageBytes);
+
+  gc_set_huge_pages(true);
+  grow_by_one_arena(&keep);
+  const RuntimeStats on = gc_stats();
+  EXPECT_EQ(on.arenaBytes, off1.arenaBytes + kArenaBytes);
+  if (std::filesystem::exists("/sys/kernel/mm/transparent_hugepage/enabled")) {
+    EXPECT_EQ(on.hugePageBytes, off1.hugePageBytes + kArenaBytes);
+  }
+  gc_unregister_root(&keep);
+}
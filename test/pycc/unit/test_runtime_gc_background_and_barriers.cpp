@@ -23,11 +23,11 @@ TEST(RuntimeGC, DISABLED_SatbPreBarrierBranchNoCrash) {
   gc_set_background(true);
   gc_set_barrier_mode(1); // enable SATB
   // Create an object and point a slot at it; exercise pre-barrier
-  void* obj = box_int(123);
+  void* obj = box_float(123);
   void* slot = obj;
   gc_pre_barrier(&slot);
   // Also exercise write barrier while here
-  void* obj2 = box_int(456);
+  void* obj2 = box_float(456);
   gc_write_barrier(&slot, obj2);
   EXPECT_TRUE(true);
 }
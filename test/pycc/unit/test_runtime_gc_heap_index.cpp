@@ -0,0 +1,79 @@
+/***
+ * Name: test_runtime_gc_heap_index
+ * Purpose: Verify address-indexed marking: reachable graphs (small, large, dict-held) survive; garbage is reclaimed.
+ */
+#include <gtest/gtest.h>
+#include "runtime/All.h"
+#include <string>
+
+using namespace pycc::rt;
+
+TEST(RuntimeHeapIndex, LargeRootedListOfBoxesSurvives) {
+  gc_reset_for_tests();
+  void* list = list_new(4);
+  gc_register_root(&list);
+  constexpr int kCount = 50000;
+  for (int i = 0; i < kCount; ++i) { list_push_slot(&list, box_float(i)); }
+  gc_collect();
+  ASSERT_EQ(list_len(list), static_cast<std::size_t>(kCount));
+  for (int i = 0; i < kCount; i += 997) { EXPECT_EQ(box_float_value(list_get(list, static_cast<std::size_t>(i))), i); }
+  // Every box is reachable; only the grown-out list buffers were garbage.
+  const RuntimeStats st = gc_stats();
+  EXPECT_EQ(st.numAllocated - st.numFreed, static_cast<uint64_t>(kCount) + 1U);
+  gc_unregister_root(&list);
+}
+
+TEST(RuntimeHeapIndex, LargeObjectsAreIndexedAndReclaimed) {
+  gc_reset_for_tests();
+  const std::string big(20000, 'z');
+  void* keep = string_new(big.data(), big.size());
+  gc_register_root(&keep);
+  void* holder = list_new(2);
+  gc_register_root(&holder);
+  list_push_slot(&holder, string_new(big.data(), big.size()));
+  (void)string_new(big.data(), big.size()); // unreachable
+  const RuntimeStats before = gc_stats();
+  gc_collect();
+  const RuntimeStats after = gc_stats();
+  EXPECT_EQ(after.numFreed, before.numFreed + 1U);
+  EXPECT_EQ(string_len(keep), big.size());
+  EXPECT_EQ(string_len(list_get(holder, 0)), big.size());
+  gc_unregister_root(&holder);
+  gc_unregister_root(&keep);
+  gc_collect();
+  EXPECT_EQ(gc_stats().bytesLive, 0U);
+}
+
+TEST(RuntimeHeapIndex, DictKeysAndValuesAreMarked) {
+  gc_reset_for_tests();
+  void* dict = dict_new(8);
+  gc_register_root(&dict);
+  constexpr int kCount = 64;
+  for (int i = 0; i < kCount; ++i) {
+    const std::string key = "k" + std::to_string(i);
+    dict_set(&dict, string_new(key.data(), key.size()), box_float(i));
+  }
+  gc_collect();
+  ASSERT_EQ(dict_len(dict), static_cast<std::size_t>(kCount));
+  for (int i = 0; i < kCount; ++i) {
+    const std::string key = "k" + std::to_string(i);
+    void* v = dict_get(dict, string_new(key.data(), key.size()));
+    ASSERT_NE(v, nullptr);
+    EXPECT_EQ(box_float_value(v), i);
+  }
+  gc_unregister_root(&dict);
+}
+
+TEST(RuntimeHeapIndex, FreedSlotsAreReused) {
+  gc_reset_for_tests();
+  for (int i = 0; i < 1000; ++i) { (void)box_float(i); }
+  gc_collect();
+  const RuntimeStats st = gc_stats();
+  EXPECT_EQ(st.numFreed, 1000U);
+  EXPECT_EQ(st.bytesLive, 0U);
+  void* again = box_float(7);
+  gc_register_root(&again);
+  gc_collect();
+  EXPECT_EQ(box_float_value(again), 7);
+  gc_unregister_root(&again);
+}
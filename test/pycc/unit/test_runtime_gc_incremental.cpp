@@ -0,0 +1,99 @@
+/***
+ * Name: test_runtime_gc_incremental
+ * Purpose: Verify incremental background marking under both barrier modes: a mutator that
+ *          keeps rewiring and reboxing a rooted graph between mark slices loses nothing.
+ */
+#include <gtest/gtest.h>
+#include "runtime/All.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace pycc::rt;
+
+namespace {
+constexpr int kLists = 16;
+constexpr int kPerList = 256;
+
+int64_t graph_sum(void* outer) {
+  int64_t sum = 0;
+  for (int l = 0; l < kLists; ++l) {
+    void* inner = list_get(outer, static_cast<std::size_t>(l));
+    for (int i = 0; i < kPerList; ++i) { sum += static_cast<int64_t>(box_float_value(list_get(inner, static_cast<std::size_t>(i)))); }
+  }
+  return sum;
+}
+
+// Swap and rebox elements while another thread runs background majors back to back
+void mutate_during_collections(int barrierMode) {
+  gc_reset_for_tests();
+  gc_set_background(true);
+  gc_set_barrier_mode(barrierMode);
+  void* outer = list_new(kLists);
+  void* tmpA = nullptr;
+  void* tmpB = nullptr;
+  gc_register_root(&outer);
+  gc_register_root(&tmpA);
+  gc_register_root(&tmpB);
+  int64_t expected = 0;
+  for (int l = 0; l < kLists; ++l) {
+    tmpA = list_new(kPerList);
+    for (int i = 0; i < kPerList; ++i) {
+      list_push_slot(&tmpA, box_float((l * kPerList) + i));
+      expected += (l * kPerList) + i;
+    }
+    list_push_slot(&outer, tmpA);
+  }
+  std::atomic<bool> done{false};
+  std::thread collector([&done] {
+    for (int c = 0; c < 20; ++c) { gc_collect(); }
+    done.store(true);
+  });
+  uint32_t seed = 12345U;
+  auto next = [&seed](int bound) { seed = (seed * 1103515245U) + 12345U; return static_cast<std::size_t>((seed >> 8U) % static_cast<uint32_t>(bound)); };
+  while (!done.load()) {
+    void* listA = list_get(outer, next(kLists));
+    void* listB = list_get(outer, next(kLists));
+    const std::size_t i = next(kPerList);
+    const std::size_t j = next(kPerList);
+    tmpA = list_get(listA, i);
+    tmpB = list_get(listB, j);
+    list_set(listA, i, tmpB);
+    list_set(listB, j, tmpA);
+    tmpA = box_float(box_float_value(list_get(listA, i))); // fresh young copy replaces the original
+    list_set(listA, i, tmpA);
+    (void)list_new(8); // garbage
+  }
+  collector.join();
+  gc_set_background(false);
+  gc_collect();
+  EXPECT_EQ(graph_sum(outer), expected);
+  gc_unregister_root(&tmpB);
+  gc_unregister_root(&tmpA);
+  gc_unregister_root(&outer);
+}
+} // namespace
+
+TEST(RuntimeIncrementalMark, IncrementalUpdateBarrierKeepsGraph) { mutate_during_collections(0); }
+
+TEST(RuntimeIncrementalMark, SatbBarrierKeepsGraph) { mutate_during_collections(1); }
+
+TEST(RuntimeIncrementalMark, SynchronousCollectSupersedesBackgroundCycle) {
+  gc_reset_for_tests();
+  void* keep = list_new(4);
+  gc_register_root(&keep);
+  for (int i = 0; i < 4; ++i) { list_push_slot(&keep, box_float(i)); }
+  for (int round = 0; round < 10; ++round) {
+    gc_set_background(true);
+    std::thread bg([] { gc_collect(); });
+    for (int i = 0; i < 1000; ++i) { (void)box_float(i); }
+    gc_set_background(false);
+    gc_collect(); // may run while the background cycle is marking or sweeping
+    bg.join();
+    ASSERT_EQ(list_len(keep), 4U);
+    for (int i = 0; i < 4; ++i) { EXPECT_EQ(box_float_value(list_get(keep, static_cast<std::size_t>(i))), i); }
+  }
+  gc_unregister_root(&keep);
+  gc_collect();
+  EXPECT_EQ(gc_stats().bytesLive, 0U);
+}
@@ -17,7 +17,7 @@ TEST(RuntimeGC, DISABLED_NurserySurvivalAndPromotionCoverage) {
   list = list_new(4);
   // Push a number of elements, collecting mid-way to cause some survivors
   for (int i = 0; i < 100; ++i) {
-    void* val = box_int(i);
+    void* val = box_float(i);
     list_push_slot(&list, val);
     if (i % 10 == 0) { gc_collect(); }
   }
@@ -26,7 +26,7 @@ TEST(RuntimeGC, DISABLED_NurserySurvivalAndPromotionCoverage) {
 
   // Mutate interior pointers and collect again to exercise pre-barrier/remembered set
   for (int i = 0; i < 50; ++i) {
-    list_set(list, static_cast<std::size_t>(i), box_int(1000 + i));
+    list_set(list, static_cast<std::size_t>(i), box_float(1000 + i));
   }
   gc_collect();
 
@@ -34,7 +34,7 @@ TEST(RuntimeGC, DISABLED_NurserySurvivalAndPromotionCoverage) {
   for (int i = 0; i < 5; ++i) {
     void* got = list_get(list, static_cast<std::size_t>(i));
     ASSERT_NE(got, nullptr);
-    EXPECT_EQ(box_int_value(got), 1000 + i);
+    EXPECT_EQ(box_float_value(got), 1000 + i);
   }
 
   // Cleanup
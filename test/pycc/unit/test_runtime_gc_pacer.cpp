@@ -0,0 +1,85 @@
+/***
+ * Name: test_runtime_gc_pacer
+ * Purpose: Verify heap pacing: the major trigger follows live bytes by the growth percentage,
+ *          an absolute heap target or the environment, and gc_set_threshold pins it.
+ */
+#include <gtest/gtest.h>
+#include "runtime/All.h"
+#include <cstdint>
+#include <cstdlib>
+
+using namespace pycc::rt;
+
+namespace {
+constexpr uint64_t kMiB = 1ULL << 20U;
+
+// Fills *slot (registered as a root) with a list keeping about `bytes` of old-space objects.
+void retain_old_bytes(void** slot, uint64_t bytes) {
+  gc_set_nursery_size(0);
+  *slot = list_new(4);
+  gc_register_root(slot);
+  while (gc_stats().bytesLive < bytes) { list_push_slot(slot, box_float(1)); }
+}
+} // namespace
+
+TEST(RuntimeGcPacer, TriggerGrowsWithLiveHeap) {
+  gc_reset_for_tests();
+  gc_set_background(false);
+  EXPECT_EQ(gc_telemetry().triggerBytes, kMiB); // nothing live yet: the minimum trigger
+  void* list = nullptr;
+  retain_old_bytes(&list, 4 * kMiB);
+  gc_collect();
+  const uint64_t live = gc_stats().bytesLive;
+  const GcTelemetry telem = gc_telemetry();
+  EXPECT_EQ(telem.heapGoalBytes, live + ((live / 100U) * 100U)); // default growth: 100%
+  EXPECT_EQ(telem.triggerBytes, telem.heapGoalBytes); // no allocation rate observed yet
+  gc_set_heap_growth(50);
+  EXPECT_EQ(gc_telemetry().heapGoalBytes, live + ((live / 100U) * 50U));
+  gc_unregister_root(&list);
+}
+
+TEST(RuntimeGcPacer, HeapTargetOverridesGrowth) {
+  gc_reset_for_tests();
+  gc_set_background(false);
+  void* list = nullptr;
+  retain_old_bytes(&list, 2 * kMiB);
+  gc_collect();
+  gc_set_heap_target(64 * kMiB);
+  EXPECT_EQ(gc_telemetry().heapGoalBytes, 64 * kMiB);
+  EXPECT_EQ(gc_telemetry().triggerBytes, 64 * kMiB);
+  // A target below the live heap still leaves headroom instead of collecting back to back
+  gc_set_heap_target(kMiB);
+  EXPECT_EQ(gc_telemetry().heapGoalBytes, gc_stats().bytesLive + kMiB);
+  gc_set_heap_target(0);
+  gc_set_heap_growth(-1);
+  EXPECT_EQ(gc_telemetry().triggerBytes, static_cast<uint64_t>(SIZE_MAX));
+  gc_unregister_root(&list);
+}
+
+TEST(RuntimeGcPacer, FixedThresholdPinsTrigger) {
+  gc_reset_for_tests();
+  gc_set_background(false);
+  gc_set_threshold(4096);
+  void* list = nullptr;
+  retain_old_bytes(&list, 2 * kMiB);
+  gc_collect();
+  EXPECT_EQ(gc_telemetry().triggerBytes, 4096U);
+  gc_set_heap_growth(100); // resumes pacing from the live bytes of the last collection
+  const GcTelemetry telem = gc_telemetry();
+  EXPECT_GE(telem.triggerBytes, 2 * gc_stats().bytesLive - 100U);
+  EXPECT_EQ(telem.triggerBytes, telem.heapGoalBytes);
+  gc_unregister_root(&list);
+}
+
+TEST(RuntimeGcPacer, EnvironmentSetsHeapTarget) {
+  ::setenv("PYCC_GC_HEAP_TARGET", "8m", 1);
+  gc_reset_for_tests();
+  EXPECT_EQ(gc_telemetry().heapGoalBytes, 8 * kMiB);
+  ::unsetenv("PYCC_GC_HEAP_TARGET");
+  ::setenv("PYCC_GC_PERCENT", "off", 1);
+  gc_reset_for_tests();
+  EXPECT_EQ(gc_telemetry().triggerBytes, static_cast<uint64_t>(SIZE_MAX));
+  ::unsetenv("PYCC_GC_PERCENT");
+  gc_reset_for_tests();
+  EXPECT_EQ(gc_telemetry().triggerBytes, kMiB);
+}
@@ -0,0 +1,161 @@
+/***
+ * Name: test_runtime_gc_shadow_stack
+ * Purpose: Verify the collector takes precise roots from LLVM shadow-stack frames linked into
+ *          each thread's llvm_gc_root_chain, including threads that keep pushing and popping
+ *          frames or overwriting slots during a background cycle, and releases them once the
+ *          frames are popped.
+ */
+#include <gtest/gtest.h>
+#include "runtime/All.h"
+#include "runtime/c_api.h"
+#include <atomic>
+#include <thread>
+
+using namespace pycc::rt;
+
+namespace {
+// Frame layout produced by LLVM's shadow-stack lowering for a function with N gcroots
+template <int N>
+struct Frame {
+  pycc_gc_stack_entry entry{};
+  void* roots[N]{}; // NOLINT(cppcoreguidelines-avoid-c-arrays)
+};
+
+template <int N>
+void push_frame(Frame<N>& frame, const pycc_gc_frame_map& map) {
+  frame.entry.next = llvm_gc_root_chain;
+  frame.entry.map = &map;
+  llvm_gc_root_chain = &frame.entry;
+}
+
+template <int N>
+void pop_frame(Frame<N>& frame) { llvm_gc_root_chain = frame.entry.next; }
+
+// A pointer store into a frame slot as compiled code does it (pycc_gc_store_barrier)
+void store_slot(void*& slot, void* value) {
+  if (std::atomic_ref<uint8_t>(pycc_gc_marking).load(std::memory_order_relaxed) != 0U) { pycc_gc_write_barrier(&slot, value); }
+  slot = value;
+}
+} // namespace
+
+TEST(RuntimeShadowStack, FrameRootsSurviveMinorAndMajor) {
+  gc_reset_for_tests();
+  static const pycc_gc_frame_map kMap{2, 0};
+  Frame<2> frame;
+  push_frame(frame, kMap);
+  frame.roots[0] = box_float(7);
+  frame.roots[1] = list_new(2);
+  list_push_slot(&frame.roots[1], box_float(8));
+  (void)box_float(0); // garbage
+  gc_collect_minor();
+  gc_collect();
+  EXPECT_EQ(box_float_value(frame.roots[0]), 7);
+  ASSERT_EQ(list_len(frame.roots[1]), 1U);
+  EXPECT_EQ(box_float_value(list_get(frame.roots[1], 0)), 8);
+  EXPECT_EQ(gc_stats().numFreed, 1U);
+  pop_frame(frame);
+  gc_collect();
+  EXPECT_EQ(gc_stats().bytesLive, 0U);
+}
+
+TEST(RuntimeShadowStack, WalksCallerFramesIncludingMetadataRoots) {
+  gc_reset_for_tests();
+  static const pycc_gc_frame_map kCallerMap{1, 0};
+  // Roots with metadata come first and are counted in num_roots
+  struct { pycc_gc_frame_map map; const void* meta[1]; } static const kCalleeMap{{2, 1}, {nullptr}}; // NOLINT(cppcoreguidelines-avoid-c-arrays)
+  Frame<1> caller;
+  Frame<2> callee;
+  push_frame(caller, kCallerMap);
+  caller.roots[0] = string_new("caller", 6);
+  push_frame(callee, kCalleeMap.map);
+  callee.roots[0] = box_float(1);
+  callee.roots[1] = nullptr; // not yet assigned
+  gc_collect();
+  EXPECT_EQ(gc_stats().numFreed, 0U);
+  EXPECT_EQ(string_len(caller.roots[0]), 6U);
+  pop_frame(callee);
+  gc_collect();
+  EXPECT_EQ(gc_stats().numFreed, 1U);
+  pop_frame(caller);
+  gc_collect();
+  EXPECT_EQ(gc_stats().numFreed, 2U);
+  EXPECT_EQ(llvm_gc_root_chain, nullptr);
+}
+
+TEST(RuntimeShadowStack, BackgroundCycleWalksFramesOfRunningThread) {
+  gc_reset_for_tests();
+  gc_set_background(true);
+  static const pycc_gc_frame_map kMap{2, 0};
+  Frame<2> mainFrame; // on this thread's chain, walked while it waits for the cycles
+  push_frame(mainFrame, kMap);
+  mainFrame.roots[0] = string_new("main", 4);
+  std::atomic<bool> done{false};
+  std::atomic<int> rounds{0};
+  std::atomic<int> corrupted{0};
+  std::thread worker([&] {
+    static const pycc_gc_frame_map kWorkerMap{8, 0};
+    for (int i = 0; !done.load(); ++i) {
+      Frame<8> frame;
+      push_frame(frame, kWorkerMap);
+      frame.roots[0] = box_float(i);
+      // Move the only reference down the slots without entering the runtime: a walk that
+      // overlapped a move would find neither slot holding it
+      for (int k = 0; k < 4096; ++k) {
+        const int from = (8 - (k % 8)) % 8;
+        frame.roots[(from + 7) % 8] = frame.roots[from];
+        frame.roots[from] = nullptr;
+        gc_safepoint(); // what compiled loop headers do
+      }
+      for (int g = 0; g < 64; ++g) { (void)box_float(-1); } // reuse the memory of a wrongly freed box
+      if (box_float_value(frame.roots[0]) != i) { corrupted.fetch_add(1); }
+      pop_frame(frame);
+      rounds.fetch_add(1);
+    }
+    EXPECT_EQ(llvm_gc_root_chain, nullptr);
+  });
+  while (rounds.load() == 0) { std::this_thread::yield(); }
+  for (int c = 0; c < 20; ++c) { gc_collect(); }
+  EXPECT_EQ(string_len(mainFrame.roots[0]), 4U);
+  EXPECT_EQ(llvm_gc_root_chain, &mainFrame.entry); // the worker's frames never land here
+  pop_frame(mainFrame);
+  done.store(true);
+  worker.join();
+  EXPECT_GT(rounds.load(), 0);
+  EXPECT_EQ(corrupted.load(), 0);
+  gc_set_background(false);
+}
+
+TEST(RuntimeShadowStack, SlotOverwrittenBetweenMarkSlices) {
+  gc_reset_for_tests();
+  gc_set_background(true);
+  static const pycc_gc_frame_map kMap{2, 0};
+  Frame<2> frame;
+  push_frame(frame, kMap);
+  frame.roots[0] = list_new(4);
+  for (int i = 0; i < 20000; ++i) { list_push_slot(&frame.roots[0], box_float(i)); } // takes many slices to mark
+  std::atomic<bool> done{false};
+  std::thread collector([&done] {
+    for (int c = 0; c < 10; ++c) { gc_collect(); }
+    done.store(true);
+  });
+  // The only reference to each fresh box lives in the slot, replaced between slices and
+  // before the remark, which finds the current one with this thread stopped
+  int corrupted = 0;
+  int stores = 0;
+  for (int i = 0; !done.load(); ++i) {
+    store_slot(frame.roots[1], box_float(i));
+    ++stores;
+    for (int k = 0; k < 16; ++k) {
+      (void)box_float(-1); // garbage that reuses the memory of a wrongly freed box
+      gc_safepoint();
+    }
+    if (box_float_value(frame.roots[1]) != i) { ++corrupted; }
+  }
+  collector.join();
+  EXPECT_GT(stores, 0);
+  EXPECT_EQ(corrupted, 0);
+  EXPECT_EQ(list_len(frame.roots[0]), 20000U);
+  EXPECT_EQ(box_float_value(list_get(frame.roots[0], 19999)), 19999);
+  pop_frame(frame);
+  gc_set_background(false);
+}
@@ -0,0 +1,71 @@
+/***
+ * Name: test_runtime_gc_timings
+ * Purpose: Verify GC pause/mark/sweep histograms: one sample per stop-the-world section and per
+ *          completed collection, ordered percentiles, and the C API mirror of gc_telemetry.
+ */
+#include <gtest/gtest.h>
+#include "runtime/All.h"
+#include "runtime/c_api.h"
+
+using namespace pycc::rt;
+
+namespace {
+void expect_ordered(const GcPauseSummary& sum) {
+  EXPECT_LE(sum.p50Ns, sum.p90Ns);
+  EXPECT_LE(sum.p90Ns, sum.p99Ns);
+  EXPECT_LE(sum.p99Ns, sum.maxNs);
+}
+} // namespace
+
+TEST(RuntimeGcTimings, SynchronousCollectionsRecordOneSampleEach) {
+  gc_reset_for_tests();
+  EXPECT_EQ(gc_telemetry().pause.count, 0U);
+  void* list = list_new(4);
+  gc_register_root(&list);
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 0; i < 5000; ++i) { list_push_slot(&list, box_float(i)); (void)box_float(0.5); }
+    gc_collect_minor();
+    gc_collect();
+  }
+  const GcTelemetry telem = gc_telemetry();
+  EXPECT_EQ(telem.pause.count, 6U);
+  EXPECT_EQ(telem.mark.count, 6U);
+  EXPECT_EQ(telem.sweep.count, 6U);
+  EXPECT_GT(telem.pause.maxNs, 0U);
+  EXPECT_GT(telem.mark.maxNs, 0U);
+  expect_ordered(telem.pause);
+  expect_ordered(telem.mark);
+  expect_ordered(telem.sweep);
+  // A pause covers its collection's marking and sweeping
+  EXPECT_GE(telem.pause.maxNs, telem.mark.maxNs);
+  gc_unregister_root(&list);
+}
+
+TEST(RuntimeGcTimings, BackgroundCycleRecordsSlicesAndOneCollection) {
+  gc_reset_for_tests();
+  void* list = list_new(4);
+  gc_register_root(&list);
+  for (int i = 0; i < 20000; ++i) { list_push_slot(&list, box_float(i)); }
+  gc_set_background(true);
+  gc_collect(); // waits for one complete background major cycle
+  gc_set_background(false);
+  const GcTelemetry telem = gc_telemetry();
+  EXPECT_GE(telem.pause.count, 2U); // the root slice plus at least the remark slice
+  EXPECT_EQ(telem.mark.count, 1U);
+  EXPECT_EQ(telem.sweep.count, 1U);
+  EXPECT_EQ(list_len(list), 20000U);
+  gc_unregister_root(&list);
+}
+
+TEST(RuntimeGcTimings, CApiMatchesTelemetry) {
+  gc_reset_for_tests();
+  for (int i = 0; i < 10; ++i) { gc_collect(); }
+  const GcTelemetry telem = gc_telemetry();
+  pycc_gc_timings out{};
+  pycc_gc_get_timings(&out);
+  EXPECT_EQ(out.pause.count, telem.pause.count);
+  EXPECT_EQ(out.pause.p50_ns, telem.pause.p50Ns);
+  EXPECT_EQ(out.pause.p99_ns, telem.pause.p99Ns);
+  EXPECT_EQ(out.mark.max_ns, telem.mark.maxNs);
+  EXPECT_EQ(out.sweep.count, 10U);
+}
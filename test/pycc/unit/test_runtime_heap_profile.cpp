@@ -0,0 +1,55 @@
+/***
+ * Name: test_runtime_heap_profile
+ * Purpose: Verify the sampling heap profiler records allocation stacks, drops freed objects
+ *          from the in-use totals, and writes a pprof heap_v2 profile.
+ */
+#include <gtest/gtest.h>
+#include "runtime/All.h"
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using namespace pycc::rt;
+
+TEST(RuntimeHeapProfile, SampledSitesTrackLiveObjects) {
+  gc_reset_for_tests();
+  gc_set_heap_profile_rate(1); // every allocation, after the first re-arms the countdown
+  void* keep = list_new(16);
+  gc_register_root(&keep);
+  for (int i = 0; i < 100; ++i) {
+    const std::string text = "profiled-" + std::to_string(i);
+    void* str = string_new(text.data(), text.size());
+    if (i % 10 == 0) { list_push_slot(&keep, str); }
+  }
+  gc_collect();
+  const std::string path = ::testing::TempDir() + "pycc_heap_profile.txt";
+  ASSERT_TRUE(gc_heap_profile_dump(path.c_str()));
+  gc_set_heap_profile_rate(0);
+
+  std::ifstream in(path);
+  std::stringstream text;
+  text << in.rdbuf();
+  const std::string profile = text.str();
+  uint64_t inuseCount = 0, inuseBytes = 0, allocCount = 0, allocBytes = 0;
+  std::size_t period = 0;
+  ASSERT_EQ(std::sscanf(profile.c_str(), "heap profile: %" SCNu64 ": %" SCNu64 " [%" SCNu64 ": %" SCNu64 "] @ heap_v2/%zu",
+                        &inuseCount, &inuseBytes, &allocCount, &allocBytes, &period), 5);
+  EXPECT_EQ(period, 1U);
+  EXPECT_GE(allocCount, 100U);
+  // The ten kept strings stay in use; the other ninety died in the collection
+  EXPECT_GE(inuseCount, 10U);
+  EXPECT_LT(inuseCount, 30U);
+  EXPECT_GT(inuseBytes, 0U);
+  EXPECT_NE(profile.find("] @ 0x"), std::string::npos);
+  EXPECT_NE(profile.find("\nMAPPED_LIBRARIES:\n"), std::string::npos);
+  gc_unregister_root(&keep);
+  std::remove(path.c_str());
+}
+
+TEST(RuntimeHeapProfile, DumpNeedsAPath) {
+  gc_reset_for_tests();
+  if (std::getenv("PYCC_HEAP_PROFILE") == nullptr) { EXPECT_FALSE(gc_heap_profile_dump(nullptr)); }
+  EXPECT_FALSE(gc_heap_profile_dump("/nonexistent-dir/heap.txt"));
+}
@@ -0,0 +1,107 @@
+/***
+ * Name: test_runtime_set
+ * Purpose: Verify the native set type: membership by value, add/discard, union, intersection
+ *          and difference, ordered iteration, and survival across collections.
+ */
+#include <gtest/gtest.h>
+#include "runtime/All.h"
+#include "runtime/detail/RuntimeIntrospection.h"
+#include <string>
+
+using namespace pycc::rt;
+
+TEST(RuntimeSet, AddDiscardAndContains) {
+  gc_reset_for_tests();
+  void* s = nullptr;
+  gc_register_root(&s);
+  constexpr int kElems = 5000;
+  for (int i = 0; i < kElems; ++i) { set_add(&s, box_int(i)); }
+  for (int i = 0; i < kElems; ++i) { set_add(&s, box_float(static_cast<double>(i))); } // equal to the ints
+  EXPECT_EQ(set_len(s), static_cast<std::size_t>(kElems));
+  EXPECT_TRUE(set_contains(s, box_int(4999)));
+  EXPECT_FALSE(set_contains(s, box_int(kElems)));
+  for (int i = 0; i < kElems; i += 2) { EXPECT_TRUE(set_discard(s, box_int(i))); }
+  EXPECT_FALSE(set_discard(s, box_int(0)));
+  EXPECT_EQ(set_len(s), static_cast<std::size_t>(kElems / 2));
+  for (int i = 0; i < kElems; ++i) { EXPECT_EQ(set_contains(s, box_int(i)), (i % 2) == 1) << i; }
+  // Re-adding fills the table past its discarded entries
+  for (int i = 0; i < kElems; i += 2) { set_add(&s, box_int(i)); }
+  EXPECT_EQ(set_len(s), static_cast<std::size_t>(kElems));
+  for (int i = 0; i < kElems; ++i) { EXPECT_TRUE(set_contains(s, box_int(i))) << i; }
+  EXPECT_EQ(type_of_public(s), TypeTag::Set);
+  gc_unregister_root(&s);
+}
+
+TEST(RuntimeSet, StringsAreMembersByValue) {
+  gc_reset_for_tests();
+  void* s = set_new(0);
+  gc_register_root(&s);
+  for (int i = 0; i < 100; ++i) {
+    const std::string v = "v" + std::to_string(i % 10);
+    set_add(&s, string_new(v.data(), v.size()));
+  }
+  EXPECT_EQ(set_len(s), 10U);
+  gc_collect();
+  EXPECT_TRUE(set_contains(s, string_from_cstr("v7")));
+  EXPECT_FALSE(set_contains(s, string_from_cstr("v10")));
+  gc_unregister_root(&s);
+}
+
+TEST(RuntimeSet, UnionIntersectionDifference) {
+  gc_reset_for_tests();
+  void* a = nullptr;
+  void* b = nullptr;
+  gc_register_root(&a);
+  gc_register_root(&b);
+  for (int i = 0; i < 10; ++i) { set_add(&a, box_int(i)); }
+  for (int i = 5; i < 15; ++i) { set_add(&b, box_int(i)); }
+  void* u = set_union(a, b);
+  gc_register_root(&u);
+  void* n = set_intersection(a, b);
+  gc_register_root(&n);
+  void* d = set_difference(a, b);
+  gc_register_root(&d);
+  EXPECT_EQ(set_len(u), 15U);
+  EXPECT_EQ(set_len(n), 5U);
+  EXPECT_EQ(set_len(d), 5U);
+  for (int i = 0; i < 15; ++i) {
+    EXPECT_TRUE(set_contains(u, box_int(i)));
+    EXPECT_EQ(set_contains(n, box_int(i)), i >= 5 && i < 10);
+    EXPECT_EQ(set_contains(d, box_int(i)), i < 5);
+  }
+  EXPECT_EQ(set_len(a), 10U); // operands are left alone
+  gc_unregister_root(&d);
+  gc_unregister_root(&n);
+  gc_unregister_root(&u);
+  gc_unregister_root(&b);
+  gc_unregister_root(&a);
+}
+
+TEST(RuntimeSet, IteratesInInsertionOrder) {
+  gc_reset_for_tests();
+  void* s = nullptr;
+  gc_register_root(&s);
+  for (int i = 0; i < 20; ++i) { set_add(&s, box_int((i * 7) % 20)); }
+  EXPECT_TRUE(set_discard(s, box_int(7)));
+  void* it = set_iter_new(s);
+  gc_register_root(&it);
+  const uint64_t before = gc_stats().numAllocated;
+  int seen = 0;
+  for (int i = 0; i < 20; ++i) {
+    if ((i * 7) % 20 == 7) { continue; }
+    void* e = set_iter_next(it);
+    ASSERT_NE(e, nullptr);
+    EXPECT_EQ(box_int_value(e), (i * 7) % 20);
+    ++seen;
+  }
+  EXPECT_EQ(set_iter_next(it), nullptr);
+  EXPECT_EQ(seen, 19);
+  EXPECT_EQ(gc_stats().numAllocated, before);
+  void* again = set_iter_new(s);
+  (void)set_iter_next(again);
+  set_add(&s, box_int(100));
+  EXPECT_ANY_THROW((void)set_iter_next(again));
+  rt_clear_exception();
+  gc_unregister_root(&it);
+  gc_unregister_root(&s);
+}
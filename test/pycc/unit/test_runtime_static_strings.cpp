@@ -0,0 +1,52 @@
+/***
+ * Name: test_runtime_static_strings
+ * Purpose: Verify immortal string objects laid out in read-only data behave as strings, carry
+ *          the runtime's hash, and pass through collections and channels untouched.
+ */
+#include <gtest/gtest.h>
+#include "runtime/All.h"
+#include <string>
+
+using namespace pycc::rt;
+
+namespace {
+const auto kKey = make_static_string("static key");
+const auto kEmpty = make_static_string("");
+} // namespace
+
+TEST(RuntimeStaticString, ReadsAsString) {
+  gc_reset_for_tests();
+  void* s = kKey.value();
+  EXPECT_EQ(string_len(s), 10U);
+  EXPECT_STREQ(string_data(s), "static key");
+  EXPECT_EQ(string_len(kEmpty.value()), 0U);
+  EXPECT_STREQ(string_data(string_concat(s, string_from_cstr("!"))), "static key!");
+  static_assert(string_content_hash("static key") != 0U);
+}
+
+TEST(RuntimeStaticString, DictKeysMatchHeapStrings) {
+  gc_reset_for_tests();
+  void* d = nullptr;
+  gc_register_root(&d);
+  dict_set(&d, kKey.value(), box_int(1));
+  EXPECT_EQ(box_int_value(dict_get(d, string_from_cstr("static key"))), 1);
+  dict_set(&d, string_from_cstr("static key"), box_int(2));
+  EXPECT_EQ(dict_len(d), 1U);
+  EXPECT_EQ(box_int_value(dict_get(d, kKey.value())), 2);
+  EXPECT_EQ(box_int_value(dict_get(d, string_intern("static key", 10))), 2);
+  gc_unregister_root(&d);
+}
+
+TEST(RuntimeStaticString, SurvivesCollectionsAndChannels) {
+  gc_reset_for_tests();
+  void* list = list_new(1);
+  gc_register_root(&list);
+  list_push_slot(&list, kKey.value());
+  gc_collect();
+  EXPECT_EQ(list_get(list, 0), kKey.value()); // never moved
+  auto* ch = chan_new(1);
+  chan_send(ch, kKey.value());
+  EXPECT_EQ(chan_recv(ch), kKey.value()); // shared as is, not copied
+  chan_close(ch);
+  gc_unregister_root(&list);
+}
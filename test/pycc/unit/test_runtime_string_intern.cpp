@@ -0,0 +1,74 @@
+/***
+ * Name: test_runtime_string_intern
+ * Purpose: Verify interned strings are shared per content, outlive collections and are usable
+ *          as dict keys and attribute names from any thread.
+ */
+#include <gtest/gtest.h>
+#include "runtime/All.h"
+#include <atomic>
+#include <cstring>
+#include <string>
+
+using namespace pycc::rt;
+
+TEST(RuntimeStringIntern, EqualContentSharesOneObject) {
+  gc_reset_for_tests();
+  void* a = string_intern("name", 4);
+  void* b = string_intern("name\0ignored", 4);
+  EXPECT_EQ(a, b);
+  EXPECT_NE(string_intern("Name", 4), a);
+  EXPECT_EQ(string_len(a), 4U);
+  EXPECT_STREQ(string_data(a), "name");
+  EXPECT_EQ(string_intern(nullptr, 0), string_intern("", 0));
+  EXPECT_EQ(string_len(string_intern("", 0)), 0U);
+}
+
+TEST(RuntimeStringIntern, InternedStringsOutliveCollections) {
+  gc_reset_for_tests();
+  gc_set_nursery_size(0);
+  void* s = string_intern("never collected", 15);
+  const RuntimeStats before = gc_stats();
+  for (int i = 0; i < 1000; ++i) { (void)string_intern("never collected", 15); }
+  gc_collect();
+  const RuntimeStats after = gc_stats();
+  EXPECT_EQ(after.bytesAllocated, before.bytesAllocated); // not on the collected heap
+  EXPECT_EQ(std::string(string_data(s), string_len(s)), "never collected");
+  EXPECT_EQ(string_intern("never collected", 15), s);
+}
+
+TEST(RuntimeStringIntern, DictKeysAndAttributes) {
+  gc_reset_for_tests();
+  void* d = nullptr;
+  gc_register_root(&d);
+  dict_set(&d, string_intern("key", 3), box_int(7));
+  EXPECT_EQ(box_int_value(dict_get(d, string_intern("key", 3))), 7);
+  EXPECT_EQ(box_int_value(dict_get(d, string_from_cstr("key"))), 7);
+  void* obj = object_new(1);
+  gc_register_root(&obj);
+  object_set_attr(obj, string_from_cstr("foo"), box_int(3));
+  EXPECT_EQ(box_int_value(object_get_attr(obj, string_intern("foo", 3))), 3);
+  gc_unregister_root(&obj);
+  gc_unregister_root(&d);
+}
+
+struct InternPayload { void* expected; std::atomic<int>* matched; };
+
+static void entry_intern(const void* buf, std::size_t /*len*/, void** /*ret*/, std::size_t* /*ret_len*/) {
+  const auto* p = static_cast<const InternPayload*>(buf);
+  for (int i = 0; i < 1000; ++i) {
+    if (string_intern("shared", 6) == p->expected) { p->matched->fetch_add(1); }
+    (void)string_new("churn", 5);
+  }
+  gc_collect(); // the worker's heap collector leaves the shared string alone
+  if (std::strcmp(string_data(p->expected), "shared") == 0) { p->matched->fetch_add(1); }
+}
+
+TEST(RuntimeStringIntern, SharedWithPrivateHeapThreads) {
+  gc_reset_for_tests();
+  std::atomic<int> matched{0};
+  InternPayload pay{string_intern("shared", 6), &matched};
+  RtThreadHandle* th[2]{};
+  for (auto& handle : th) { handle = rt_spawn(entry_intern, &pay, sizeof(pay)); }
+  for (auto* handle : th) { (void)rt_join(handle, nullptr, nullptr); rt_thread_handle_destroy(handle); }
+  EXPECT_EQ(matched.load(), 2 * 1001);
+}
@@ -0,0 +1,84 @@
+/***
+ * Name: test_runtime_trace
+ * Purpose: Verify the runtime records GC phases, thread lifetimes and channel waits into its
+ *          trace buffers and writes them out as a time-ordered trace file.
+ */
+#include <gtest/gtest.h>
+#include "runtime/All.h"
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace pycc::rt;
+
+namespace {
+struct ReadTrace { TraceFileHeader header; std::vector<TraceEvent> events; };
+
+ReadTrace read_trace(const std::string& path) {
+  ReadTrace trace;
+  std::ifstream in(path, std::ios::binary);
+  in.read(reinterpret_cast<char*>(&trace.header), sizeof(trace.header)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+  trace.events.resize(trace.header.count);
+  in.read(reinterpret_cast<char*>(trace.events.data()), static_cast<std::streamsize>(trace.events.size() * sizeof(TraceEvent))); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+  return trace;
+}
+
+int count(const ReadTrace& trace, TraceKind kind, TracePhase phase) {
+  int n = 0;
+  for (const auto& ev : trace.events) { n += (ev.kind == kind && ev.phase == phase) ? 1 : 0; }
+  return n;
+}
+
+void entry_wait(const void* buf, std::size_t /*len*/, void** /*ret*/, std::size_t* /*ret_len*/) {
+  auto* in = *static_cast<RtChannelHandle* const*>(buf);
+  (void)chan_recv(in);
+}
+} // namespace
+
+TEST(RuntimeTrace, RecordsCollectionsThreadsAndChannelWaits) {
+  gc_reset_for_tests();
+  const std::string path = ::testing::TempDir() + "pycc_rt_trace.bin";
+  (void)trace_flush(path.c_str()); // drop anything recorded earlier
+  trace_set_enabled(true);
+  gc_collect();
+  auto* in = chan_new(1);
+  RtThreadHandle* th = rt_spawn(entry_wait, &in, sizeof(in));
+  std::this_thread::sleep_for(std::chrono::milliseconds(50)); // let the worker block on the empty channel
+  chan_send(in, box_int(1));
+  (void)rt_join(th, nullptr, nullptr);
+  rt_thread_handle_destroy(th);
+  trace_set_enabled(false);
+  ASSERT_TRUE(trace_flush(path.c_str()));
+  chan_close(in);
+
+  const ReadTrace trace = read_trace(path);
+  const TraceFileHeader expected;
+  EXPECT_EQ(std::memcmp(trace.header.magic, expected.magic, sizeof(expected.magic)), 0);
+  EXPECT_EQ(trace.header.eventSize, sizeof(TraceEvent));
+  ASSERT_EQ(trace.events.size(), trace.header.count);
+  EXPECT_GE(count(trace, TraceKind::GcMajor, TracePhase::Begin), 1);
+  EXPECT_EQ(count(trace, TraceKind::GcMajor, TracePhase::Begin), count(trace, TraceKind::GcMajor, TracePhase::End));
+  EXPECT_GE(count(trace, TraceKind::GcMark, TracePhase::Begin), 1);
+  EXPECT_EQ(count(trace, TraceKind::ThreadSpawn, TracePhase::Instant), 1);
+  EXPECT_EQ(count(trace, TraceKind::ThreadRun, TracePhase::End), 1);
+  EXPECT_EQ(count(trace, TraceKind::ThreadJoin, TracePhase::End), 1);
+  EXPECT_EQ(count(trace, TraceKind::ChanRecvBlocked, TracePhase::End), 1);
+  for (std::size_t i = 1; i < trace.events.size(); ++i) {
+    EXPECT_LE(trace.events[i - 1].timeNs, trace.events[i].timeNs);
+  }
+  // The worker recorded under a thread number of its own
+  uint16_t runner = 0;
+  uint16_t main = 0;
+  for (const auto& ev : trace.events) {
+    if (ev.kind == TraceKind::ThreadRun) { runner = ev.thread; }
+    if (ev.kind == TraceKind::ThreadJoin) { main = ev.thread; }
+  }
+  EXPECT_NE(runner, main);
+
+  // A flush drains the buffers
+  ASSERT_TRUE(trace_flush(path.c_str()));
+  EXPECT_EQ(read_trace(path).header.count, 0U);
+}
@@ -0,0 +1,41 @@
+/***
+ * Name: test_set_membership_typing
+ * Purpose: Ensure membership against set literals, set comprehensions and names bound to them
+ *          types to bool, checked against the set's element kinds.
+ */
+#include <gtest/gtest.h>
+#include "lexer/Lexer.h"
+#include "parser/Parser.h"
+#include "sema/Sema.h"
+
+using namespace pycc;
+
+static std::unique_ptr<ast::Module> parseSrc(const char* src) {
+  lex::Lexer L; L.pushString(src, "set_membership.py");
+  parse::Parser P(L);
+  return P.parseModule();
+}
+
+TEST(SemaSetMembership, LiteralsCompsAndNamesAccepted) {
+  const char* src = R"PY(
+def f() -> bool:
+  s = {3, 1, 2}
+  seen = {x for x in [1, 2, 3, 4] if x > 2}
+  both = {y for y in seen if y in s}
+  a = 2 in s
+  b = 9 not in both
+  return "a" in {"a", "b"}
+)PY";
+  auto mod = parseSrc(src);
+  sema::Sema S; std::vector<sema::Diagnostic> diags; EXPECT_TRUE(S.check(*mod, diags)) << (diags.empty()?"":diags[0].message);
+}
+
+TEST(SemaSetMembership, ElementKindMismatchRejected) {
+  const char* src = R"PY(
+def f() -> bool:
+  s = {1, 2}
+  return "a" in s
+)PY";
+  auto mod = parseSrc(src);
+  sema::Sema S; std::vector<sema::Diagnostic> diags; EXPECT_FALSE(S.check(*mod, diags));
+}
@@ -1,20 +1,45 @@
 /**
- * Simple runtime GC benchmark: compares throughput with background GC on vs. off.
- * Usage: bench_gc [iters] [size]
+ * Simple runtime GC benchmark: compares throughput with background GC on vs. off,
+ * measures allocation scaling with 1..N mutator threads (TLAB fast path), then
+ * write-barrier throughput with 1..N threads storing concurrently. It starts with the
+ * time to mark a large List/Dict graph with heap arenas on huge pages vs. base pages.
+ * Usage: bench_gc [iters] [size] [max_threads]
  */
 #include "runtime/All.h"
+#include <algorithm>
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <numeric>
+#include <random>
 #include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
 
 using namespace pycc::rt;
 
+// AnonHugePages from /proc/self/smaps_rollup, in KiB (0 where unavailable).
+static long long anon_huge_kib() {
+  std::ifstream in("/proc/self/smaps_rollup");
+  std::string key;
+  long long value = 0;
+  while (in >> key >> value) {
+    if (key == "AnonHugePages:") { return value; }
+    in.ignore(256, '\n');
+  }
+  return 0;
+}
+
 int main(int argc, char** argv) {
   std::size_t iters = (argc > 1) ? static_cast<std::size_t>(std::strtoull(argv[1], nullptr, 10)) : 200000;
   std::size_t size  = (argc > 2) ? static_cast<std::size_t>(std::strtoull(argv[2], nullptr, 10)) : 24;
+  std::size_t maxThreads = (argc > 3) ? static_cast<std::size_t>(std::strtoull(argv[3], nullptr, 10))
+                                      : std::max<std::size_t>(4, std::thread::hardware_concurrency());
 
   auto run = [&](bool bg, int barrierMode) {
     gc_reset_for_tests();
@@ -43,6 +68,7 @@ int main(int argc, char** argv) {
               << " size=" << size
               << " time_ms=" << ms
               << " collections=" << st.numCollections
+              << " (minor=" << st.numMinorCollections << " major=" << st.numMajorCollections << ")"
               << " bytes_alloc=" << st.bytesAllocated
               << " bytes_live=" << st.bytesLive
               << " peak_live=" << st.peakBytesLive
@@ -52,8 +78,134 @@ int main(int argc, char** argv) {
               << "\n";
   };
 
+  // Each thread performs `iters` allocation rounds; total work grows with the thread count,
+  // so ideal scaling keeps time_ms flat and multiplies allocs_per_sec.
+  auto runThreads = [&](std::size_t threads) {
+    gc_reset_for_tests();
+    gc_set_threshold(1 << 20); // 1MiB
+    gc_set_conservative(false);
+    gc_set_background(true);
+    const auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (std::size_t t = 0; t < threads; ++t) {
+      workers.emplace_back([&] {
+        const std::string s(size, 'x');
+        for (std::size_t i = 0; i < iters; ++i) {
+          (void)string_new(s.c_str(), s.size());
+          (void)box_int(static_cast<int64_t>(i));
+          (void)box_float(static_cast<double>(i) * 0.5);
+          (void)box_bool((i & 1U) != 0U);
+        }
+      });
+    }
+    for (auto& w : workers) { w.join(); }
+    const auto t1 = std::chrono::steady_clock::now();
+    const auto us = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+    const auto st = gc_stats();
+    const double allocs = static_cast<double>(threads * iters * 2U); // the int and bool are immediates
+    std::cout << "[mt] threads=" << threads
+              << " iters=" << iters
+              << " time_ms=" << (us / 1000)
+              << " allocs_per_sec=" << static_cast<long long>(us > 0 ? allocs * 1e6 / static_cast<double>(us) : 0.0)
+              << " collections=" << st.numCollections
+              << " (minor=" << st.numMinorCollections << " major=" << st.numMajorCollections << ")"
+              << "\n";
+  };
+
+  // SATB stores with a background collector: every pre-barrier logs the overwritten value and
+  // the post-barrier filters the stored one, as list_set and codegen'd slot stores do.
+  auto runBarrier = [&](std::size_t threads) {
+    gc_reset_for_tests();
+    gc_set_background(true);
+    gc_set_barrier_mode(1);
+    const std::size_t stores = iters * 4U;
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    const auto t0 = std::chrono::steady_clock::now();
+    for (std::size_t t = 0; t < threads; ++t) {
+      workers.emplace_back([&] {
+        void* slot = box_float(1.0); // a heap object: barriers ignore immediates
+        gc_register_root(&slot);
+        void* value = slot;
+        for (std::size_t i = 0; i < stores; ++i) {
+          gc_pre_barrier(&slot);
+          gc_write_barrier(&slot, value);
+        }
+        gc_unregister_root(&slot);
+      });
+    }
+    for (auto& w : workers) { w.join(); }
+    const auto t1 = std::chrono::steady_clock::now();
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+    const double total = static_cast<double>(threads * stores);
+    std::cout << "[barrier] threads=" << threads
+              << " stores=" << static_cast<long long>(total)
+              << " time_ms=" << (ns / 1000000)
+              << " ns_per_store=" << (total > 0 ? static_cast<double>(ns) / total : 0.0)
+              << "\n";
+    gc_set_background(false);
+    gc_collect(); // drop the logged entries
+  };
+
+  // Each configuration runs in a child process, so it starts from fresh arenas. Nodes are
+  // linked from the root in shuffled order, so marking jumps across the whole heap.
+  auto runHugePages = [&](bool huge) {
+    const pid_t pid = ::fork();
+    if (pid != 0) { int status = 0; (void)::waitpid(pid, &status, 0); return; }
+    gc_reset_for_tests();
+    gc_set_huge_pages(huge);
+    gc_set_threshold(SIZE_MAX);
+    const std::size_t nodes = iters;
+    std::vector<std::size_t> order(nodes);
+    std::iota(order.begin(), order.end(), 0U);
+    std::shuffle(order.begin(), order.end(), std::mt19937_64(42)); // NOLINT(readability-magic-numbers)
+    void* built = list_new(nodes);
+    gc_register_root(&built);
+    for (std::size_t i = 0; i < nodes; ++i) {
+      void* node = list_new(4);
+      list_push_slot(&node, box_float(static_cast<double>(i)));
+      list_push_slot(&node, string_new("node", 4));
+      if ((i % 8U) == 0U) {
+        void* dict = dict_new(4);
+        dict_set(&dict, string_new("k", 1), box_float(0.5));
+        list_push_slot(&node, dict);
+      }
+      list_push_slot(&built, node);
+    }
+    void* root = list_new(nodes);
+    gc_register_root(&root);
+    for (const std::size_t i : order) { list_push_slot(&root, list_get(built, i)); }
+    gc_unregister_root(&built);
+    gc_collect(); // promote everything and drop the build order
+    constexpr int kRounds = 5;
+    std::vector<long long> us;
+    for (int r = 0; r < kRounds; ++r) {
+      const auto t0 = std::chrono::steady_clock::now();
+      gc_collect();
+      us.push_back(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t0).count());
+    }
+    std::sort(us.begin(), us.end());
+    const auto st = gc_stats();
+    std::cout << (huge ? "[thp=on]" : "[thp=off]")
+              << " nodes=" << nodes
+              << " collect_us_p50=" << us[kRounds / 2]
+              << " collect_us_min=" << us.front()
+              << " bytes_live=" << st.bytesLive
+              << " arena_bytes=" << st.arenaBytes
+              << " advised_bytes=" << st.hugePageBytes
+              << " anon_huge_kib=" << anon_huge_kib()
+              << "\n" << std::flush;
+    std::_Exit(0);
+  };
+
+  // Fork before any of the runs below start collector or mutator threads
+  runHugePages(false);
+  runHugePages(true);
   run(false, 0);
   run(true, 0);
   run(true, 1);
+  for (std::size_t threads = 1; threads <= maxThreads; threads *= 2) { runThreads(threads); }
+  for (std::size_t threads = 1; threads <= maxThreads; threads *= 2) { runBarrier(threads); }
   return 0;
 }
@@ -0,0 +1,44 @@
+#include "runtime/Trace.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+// Convert a runtime trace file (PYCC_RT_TRACE) to Chrome trace JSON for chrome://tracing or Perfetto.
+int main(int argc, char** argv) {
+  if (argc < 2) { std::cerr << "usage: trace_to_chrome <trace.bin> [out.json]\n"; return 2; }
+  std::ifstream in(argv[1], std::ios::binary);
+  if (!in) { std::cerr << "failed to open: " << argv[1] << "\n"; return 2; }
+  pycc::rt::TraceFileHeader header;
+  const pycc::rt::TraceFileHeader expected;
+  in.read(reinterpret_cast<char*>(&header), sizeof(header)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+  if (!in || std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 || header.eventSize != sizeof(pycc::rt::TraceEvent)) {
+    std::cerr << "not a runtime trace: " << argv[1] << "\n"; return 2;
+  }
+  std::vector<pycc::rt::TraceEvent> events(header.count);
+  in.read(reinterpret_cast<char*>(events.data()), static_cast<std::streamsize>(events.size() * sizeof(pycc::rt::TraceEvent))); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+  if (!in) { std::cerr << "truncated trace: " << argv[1] << "\n"; return 2; }
+
+  std::ofstream file;
+  if (argc > 2) {
+    file.open(argv[2]);
+    if (!file) { std::cerr << "failed to open: " << argv[2] << "\n"; return 2; }
+  }
+  std::ostream& out = argc > 2 ? file : std::cout;
+  const uint64_t origin = events.empty() ? 0 : events.front().timeNs;
+  out << "{\"traceEvents\":[";
+  const char* sep = "\n";
+  for (const auto& ev : events) {
+    const bool gc = ev.kind <= pycc::rt::TraceKind::GcStop;
+    const uint64_t ns = ev.timeNs - origin;
+    out << sep << "{\"name\":\"" << pycc::rt::trace_kind_name(ev.kind) << "\",\"cat\":\"" << (gc ? "gc" : "mutator")
+        << "\",\"ph\":\"" << static_cast<char>(ev.phase) << "\",\"ts\":" << ns / 1000U << '.' << (ns % 1000U) / 100U
+        << ",\"pid\":1,\"tid\":" << ev.thread;
+    if (ev.phase == pycc::rt::TracePhase::Instant) { out << ",\"s\":\"t\""; }
+    if (ev.arg != 0) { out << ",\"args\":{\"arg\":" << ev.arg << "}"; }
+    out << "}";
+    sep = ",\n";
+  }
+  out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+  return out ? 0 : 1;
+}